@@ -0,0 +1,125 @@
+// Measures the dataset layout directly, without the network: a dataset with the
+// requested number of elements is encoded in memory, then the benchmark times
+//  - parse: decoding the whole dataset
+//  - find: looking up every element of a parsed dataset
+//  - read: reading the value of every element, through the data handlers
+//  - build: encoding the parsed dataset again
+// and reports the heap allocations per element of each step.
+//
+//   g++ -std=c++11 -O2 -DIMEBRA_USE_ICONV -Ilibrary/include examples/benchmark-dataset-layout.cpp \
+//       library/src/*.cpp library/implementation/*.cpp -lpthread -o benchmark-dataset-layout
+//   ./benchmark-dataset-layout [elements per dataset] [repetitions]
+//
+// Run it with the builds to compare (e.g. before and after a change of the dataset
+// storage).
+#include <imebra/imebra.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace imebra;
+
+namespace {
+
+    std::atomic<size_t> allocations(0);
+
+    struct sResult {
+        double microseconds;
+        double allocationsPerElement;
+    };
+
+    template <typename Step>
+    sResult measure(size_t repetitions, size_t elements, Step step) {
+        const size_t firstAllocation = allocations;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (size_t repetition = 0; repetition != repetitions; ++repetition) {
+            step();
+        }
+        const double elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        sResult result;
+        result.microseconds = elapsed / (double)repetitions;
+        result.allocationsPerElement = (double)(allocations - firstAllocation) / (double)repetitions / (double)elements;
+        return result;
+    }
+
+    DataSet parse(const Memory& encoded) {
+        MemoryStreamInput input(encoded);
+        StreamReader reader(input);
+        return CodecFactory::load(reader);
+    }
+
+    void build(const DataSet& dataSet, MutableMemory& encoded) {
+        MemoryStreamOutput output(encoded);
+        StreamWriter writer(output);
+        CodecFactory::save(dataSet, writer, codecType_t::dicom);
+    }
+
+    void report(const char* name, const sResult& result) {
+        std::cout << name << ": " << result.microseconds << " us, " << result.allocationsPerElement << " allocations per element" << std::endl;
+    }
+}
+
+void* operator new(size_t size) {
+    ++allocations;
+    void* pMemory = std::malloc(size == 0 ? 1 : size);
+    if (pMemory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pMemory;
+}
+
+void operator delete(void* pMemory) noexcept {
+    std::free(pMemory);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t elementsCount = argc > 1 ? (size_t)std::atol(argv[1]) : 5000;
+    const size_t repetitions = argc > 2 ? (size_t)std::atol(argv[2]) : 200;
+
+    // Private elements with short values, spread over groups of 500 elements
+    MutableMemory encoded;
+    {
+        MutableDataSet dataSet("1.2.840.10008.1.2.1");
+        dataSet.setString(TagId(tagId_t::SOPClassUID_0008_0016), "1.2.840.10008.5.1.4.1.1.7");
+        dataSet.setString(TagId(tagId_t::SOPInstanceUID_0008_0018), "1.2.826.0.1.3680043.10.1");
+        size_t count = 0;
+        for (std::uint16_t group = 0x0009; count < elementsCount; group = (std::uint16_t)(group + 2)) {
+            for (std::uint16_t tag = 0x1000; tag != 0x1000 + 500 && count < elementsCount; ++tag, ++count) {
+                dataSet.setString(TagId(group, tag), "VALUE " + std::to_string(count), tagVR_t::LO);
+            }
+        }
+        build(dataSet, encoded);
+    }
+
+    const DataSet parsed(parse(encoded));
+    const std::vector<TagId> tags(parsed.getTags());
+    std::cout << "elements: " << tags.size() << ", encoded size: " << encoded.size() << " bytes" << std::endl;
+
+    size_t checked = 0;
+    report("parse", measure(repetitions, tags.size(), [&]() {
+        checked += parse(encoded).getTags().size();
+    }));
+    report("find", measure(repetitions, tags.size(), [&]() {
+        for (const TagId& tag : tags) {
+            checked += parsed.bufferExists(tag, 0) ? 1 : 0;
+        }
+    }));
+    report("read", measure(repetitions, tags.size(), [&]() {
+        for (const TagId& tag : tags) {
+            checked += parsed.getString(tag, 0, "").size();
+        }
+    }));
+    report("build", measure(repetitions, tags.size(), [&]() {
+        MutableMemory rebuilt;
+        build(parsed, rebuilt);
+        checked += rebuilt.size();
+    }));
+
+    return checked != 0 ? 0 : 1;
+}
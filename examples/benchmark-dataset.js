@@ -0,0 +1,97 @@
+// Measures the time spent decoding and encoding datasets with many elements: the files
+// are generated with the requested number of elements, then sent with a c-store to a
+// local scp that decodes each received dataset and encodes it again to disk.
+//
+//   node examples/benchmark-dataset.js [elements per dataset] [datasets]
+//
+// Run it with the builds to compare (e.g. before and after a change of the dataset
+// storage): the network transfer is the same for both, the difference is the time
+// spent by storeScu and by the scp on the datasets.
+const addon = require('../index');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const elementsCount = parseInt(process.argv[2] || '5000');
+const datasetsCount = parseInt(process.argv[3] || '200');
+const port = '11400';
+
+const sopClassUid = '1.2.840.10008.5.1.4.1.1.7'; // Secondary Capture Image Storage
+
+// explicit VR little endian element with a 2 bytes length
+const element = (group, tag, vr, value) => {
+    let data = Buffer.from(value, 'latin1');
+    if (data.length % 2) {
+        data = Buffer.concat([data, Buffer.from(vr === 'UI' ? '\0' : ' ')]);
+    }
+    const header = Buffer.alloc(8);
+    header.writeUInt16LE(group, 0);
+    header.writeUInt16LE(tag, 2);
+    header.write(vr, 4, 'latin1');
+    header.writeUInt16LE(data.length, 6);
+    return Buffer.concat([header, data]);
+};
+
+const buildFile = (index) => {
+    const sopInstanceUid = `1.2.826.0.1.3680043.10.1.${process.pid}.${index}`;
+
+    const metaElements = [
+        Buffer.from([0x02, 0x00, 0x01, 0x00, 0x4f, 0x42, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x01]),
+        element(0x0002, 0x0002, 'UI', sopClassUid),
+        element(0x0002, 0x0003, 'UI', sopInstanceUid),
+        element(0x0002, 0x0010, 'UI', '1.2.840.10008.1.2.1'),
+    ];
+    const metaLength = metaElements.reduce((total, item) => total + item.length, 0);
+    const groupLength = Buffer.from([0x02, 0x00, 0x00, 0x00, 0x55, 0x4c, 0x04, 0x00, 0, 0, 0, 0]);
+    groupLength.writeUInt32LE(metaLength, 8);
+
+    const elements = [
+        element(0x0008, 0x0016, 'UI', sopClassUid),
+        element(0x0008, 0x0018, 'UI', sopInstanceUid),
+        element(0x0010, 0x0010, 'PN', 'Benchmark^Dataset'),
+        element(0x0010, 0x0020, 'LO', 'BENCHMARK'),
+        element(0x0020, 0x000d, 'UI', `1.2.826.0.1.3680043.10.2.${process.pid}`),
+        element(0x0020, 0x000e, 'UI', `1.2.826.0.1.3680043.10.3.${process.pid}`),
+    ];
+
+    // private groups, each one with a creator and 256 elements
+    for (let count = 0, group = 0x0009; count < elementsCount; group += 2) {
+        elements.push(element(group, 0x0010, 'LO', 'BENCHMARK'));
+        for (let tag = 0x1000; tag <= 0x10ff && count < elementsCount; ++tag, ++count) {
+            elements.push(element(group, tag, 'LO', `VALUE ${count}`));
+        }
+    }
+
+    return Buffer.concat([Buffer.alloc(128), Buffer.from('DICM'), groupLength].concat(metaElements, elements));
+};
+
+const sourcePath = fs.mkdtempSync(path.join(os.tmpdir(), 'benchmark-dataset-source-'));
+const storagePath = fs.mkdtempSync(path.join(os.tmpdir(), 'benchmark-dataset-storage-'));
+for (let index = 0; index < datasetsCount; ++index) {
+    fs.writeFileSync(path.join(sourcePath, `${index}.dcm`), buildFile(index));
+}
+
+addon.startScp(JSON.stringify({
+    "source": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+    "storagePath": storagePath,
+}), () => {});
+
+setTimeout(() => {
+    const start = process.hrtime.bigint();
+    addon.storeScu(JSON.stringify({
+        "source": { "aet": "BENCHSCU", "ip": "127.0.0.1", "port": "0" },
+        "target": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+        "sourcePath": sourcePath,
+    }), (result) => {
+        const response = JSON.parse(result);
+        if (response.status === 'pending') {
+            return;
+        }
+        const milliseconds = Number(process.hrtime.bigint() - start) / 1e6;
+        console.log(`${datasetsCount} datasets with ${elementsCount} elements: ${(milliseconds / datasetsCount).toFixed(2)} ms/dataset, ` +
+            `${(milliseconds * 1000 / datasetsCount / elementsCount).toFixed(3)} us/element (${response.status})`);
+        fs.rmSync(sourcePath, { recursive: true, force: true });
+        fs.rmSync(storagePath, { recursive: true, force: true });
+        process.exit(0);
+    });
+}, 200);
@@ -0,0 +1,93 @@
+// Measures concurrent readers on a dataset before and after DataSet::freeze(): each
+// thread reads the value of every element of the same dataset, first while the
+// dataset is still locked by each read, then once it has been frozen. The values
+// read by the threads are checked against the ones read before starting them.
+//
+//   g++ -std=c++11 -O2 -DIMEBRA_USE_ICONV -Ilibrary/include examples/benchmark-frozen-dataset.cpp \
+//       library/src/*.cpp library/implementation/*.cpp -lpthread -o benchmark-frozen-dataset
+//   ./benchmark-frozen-dataset [elements] [threads] [repetitions]
+#include <imebra/imebra.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace imebra;
+
+namespace {
+
+    // Reads all the elements from several threads, returns the elapsed
+    // milliseconds and counts the values that differ from the expected ones
+    double readConcurrently(const DataSet& dataSet, const std::vector<TagId>& tags, const std::vector<std::string>& expected,
+                            size_t threadsCount, size_t repetitions, std::atomic<size_t>& mismatches) {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t thread = 0; thread != threadsCount; ++thread) {
+            threads.emplace_back([&]() {
+                for (size_t repetition = 0; repetition != repetitions; ++repetition) {
+                    for (size_t position = 0; position != tags.size(); ++position) {
+                        if (dataSet.getString(tags[position], 0, "") != expected[position]) {
+                            ++mismatches;
+                        }
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t elementsCount = argc > 1 ? (size_t)std::atol(argv[1]) : 2000;
+    const size_t threadsCount = argc > 2 ? (size_t)std::atol(argv[2]) : std::max(std::thread::hardware_concurrency(), 2u);
+    const size_t repetitions = argc > 3 ? (size_t)std::atol(argv[3]) : 20;
+
+    // Private elements with short values, spread over groups of 500 elements
+    MutableMemory encoded;
+    {
+        MutableDataSet dataSet("1.2.840.10008.1.2.1");
+        dataSet.setString(TagId(tagId_t::SOPClassUID_0008_0016), "1.2.840.10008.5.1.4.1.1.7");
+        dataSet.setString(TagId(tagId_t::SOPInstanceUID_0008_0018), "1.2.826.0.1.3680043.10.1");
+        size_t count = 0;
+        for (std::uint16_t group = 0x0009; count < elementsCount; group = (std::uint16_t)(group + 2)) {
+            for (std::uint16_t tag = 0x1000; tag != 0x1000 + 500 && count < elementsCount; ++tag, ++count) {
+                dataSet.setString(TagId(group, tag), "VALUE " + std::to_string(count), tagVR_t::LO);
+            }
+        }
+        MemoryStreamOutput output(encoded);
+        StreamWriter writer(output);
+        CodecFactory::save(dataSet, writer, codecType_t::dicom);
+    }
+
+    MemoryStreamInput input(encoded);
+    StreamReader reader(input);
+    DataSet dataSet(CodecFactory::load(reader));
+
+    const std::vector<TagId> tags(dataSet.getTags());
+    std::vector<std::string> expected;
+    for (const TagId& tag : tags) {
+        expected.push_back(dataSet.getString(tag, 0, ""));
+    }
+    const double reads = (double)(tags.size() * threadsCount * repetitions);
+    std::cout << "elements: " << tags.size() << ", threads: " << threadsCount << std::endl;
+
+    std::atomic<size_t> mismatches(0);
+    const double lockedMs = readConcurrently(dataSet, tags, expected, threadsCount, repetitions, mismatches);
+    std::cout << "locked: " << lockedMs << " ms, " << lockedMs * 1000000.0 / reads << " ns per read" << std::endl;
+
+    dataSet.freeze();
+    const double frozenMs = readConcurrently(dataSet, tags, expected, threadsCount, repetitions, mismatches);
+    std::cout << "frozen: " << frozenMs << " ms, " << frozenMs * 1000000.0 / reads << " ns per read" << std::endl;
+
+    std::cout << "mismatches: " << mismatches << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
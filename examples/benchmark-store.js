@@ -0,0 +1,84 @@
+// Measures the c-store throughput over loopback for a range of maximum PDU lengths.
+//
+//   node examples/benchmark-store.js <folder with dicom files> [round trip ms] [socket buffer bytes]
+//
+// With a round trip time the latency is injected by running tc/netem on the loopback
+// interface (linux only, needs root), the qdisc is removed when the benchmark ends.
+const addon = require('../index');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { execSync } = require('child_process');
+
+const sourcePath = process.argv[2];
+const delay = parseInt(process.argv[3] || '0');
+const bufferSize = parseInt(process.argv[4] || '0');
+const pduLengths = [16384, 32768, 65536, 131072, 262144, 1048576, 4194304];
+const basePort = 11200;
+
+if (!sourcePath) {
+    console.log('usage: node benchmark-store.js <folder with dicom files> [round trip ms] [socket buffer bytes]');
+    process.exit(1);
+}
+
+const listFiles = (dir) => fs.statSync(dir).isDirectory()
+    ? fs.readdirSync(dir).reduce((files, name) => files.concat(listFiles(path.join(dir, name))), [])
+    : [dir];
+const totalBytes = listFiles(sourcePath).reduce((total, file) => total + fs.statSync(file).size, 0);
+
+const removeDelay = () => {
+    if (delay > 0) {
+        execSync('tc qdisc del dev lo root netem');
+    }
+};
+if (delay > 0) {
+    // netem delays both directions of the loopback, each gets half of the round trip
+    execSync(`tc qdisc add dev lo root netem delay ${delay / 2}ms`);
+    process.on('exit', removeDelay);
+    process.on('SIGINT', () => process.exit(1));
+}
+
+const socketOptions = {
+    "sendBufferSize": bufferSize,
+    "receiveBufferSize": bufferSize,
+    "noDelay": true,
+};
+
+const run = (index) => {
+    if (index === pduLengths.length) {
+        process.exit(0);
+    }
+    const maxPduLength = pduLengths[index];
+    const port = String(basePort + index);
+    const storagePath = fs.mkdtempSync(path.join(os.tmpdir(), 'benchmark-store-'));
+
+    // the pdus sent by storeScu are limited by the length accepted by the scp
+    addon.startScp(JSON.stringify(Object.assign({
+        "source": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+        "storagePath": storagePath,
+        "passThrough": true,
+        "maxPduLength": maxPduLength,
+    }, socketOptions)), () => {});
+
+    setTimeout(() => {
+        const start = process.hrtime.bigint();
+        addon.storeScu(JSON.stringify(Object.assign({
+            "source": { "aet": "BENCHSCU", "ip": "127.0.0.1", "port": "0" },
+            "target": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+            "sourcePath": sourcePath,
+            "maxPduLength": maxPduLength,
+        }, socketOptions)), (result) => {
+            const response = JSON.parse(result);
+            if (response.status === 'pending') {
+                return;
+            }
+            const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+            console.log(`maxPduLength ${maxPduLength}: ${(totalBytes / 1048576 / seconds).toFixed(1)} MB/s (${response.status})`);
+            fs.rmSync(storagePath, { recursive: true, force: true });
+            run(index + 1);
+        });
+    }, 200);
+};
+
+console.log(`${(totalBytes / 1048576).toFixed(1)} MB, round trip ${delay} ms, socket buffers ${bufferSize || 'default'}`);
+run(0);
@@ -0,0 +1,78 @@
+// Counts the read and write system calls per GB transferred by a c-store over loopback,
+// with the 4096 bytes stream buffers used by the previous versions and with the default.
+//
+//   node examples/benchmark-streams.js <folder with dicom files> [stream buffer bytes]
+//
+// The counters come from /proc/self/io (linux only) and include the calls made by the scp
+// to store the received files, the scu and the scp run in this process.
+const addon = require('../index');
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+
+const sourcePath = process.argv[2];
+const streamBufferSizes = [4096, parseInt(process.argv[3] || '0')];
+const basePort = 11300;
+
+if (!sourcePath) {
+    console.log('usage: node benchmark-streams.js <folder with dicom files> [stream buffer bytes]');
+    process.exit(1);
+}
+
+const listFiles = (dir) => fs.statSync(dir).isDirectory()
+    ? fs.readdirSync(dir).reduce((files, name) => files.concat(listFiles(path.join(dir, name))), [])
+    : [dir];
+const totalBytes = listFiles(sourcePath).reduce((total, file) => total + fs.statSync(file).size, 0);
+
+const readCounters = () => {
+    const counters = {};
+    fs.readFileSync('/proc/self/io', 'utf8').split('\n').forEach((line) => {
+        const [name, value] = line.split(':');
+        if (value !== undefined) {
+            counters[name] = Number(value);
+        }
+    });
+    return counters;
+};
+
+const run = (index) => {
+    if (index === streamBufferSizes.length) {
+        process.exit(0);
+    }
+    const streamBufferSize = streamBufferSizes[index];
+    const port = String(basePort + index);
+    const storagePath = fs.mkdtempSync(path.join(os.tmpdir(), 'benchmark-streams-'));
+
+    addon.startScp(JSON.stringify({
+        "source": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+        "storagePath": storagePath,
+        "passThrough": true,
+        "streamBufferSize": streamBufferSize,
+    }), () => {});
+
+    setTimeout(() => {
+        const before = readCounters();
+        const start = process.hrtime.bigint();
+        addon.storeScu(JSON.stringify({
+            "source": { "aet": "BENCHSCU", "ip": "127.0.0.1", "port": "0" },
+            "target": { "aet": "BENCHSCP", "ip": "127.0.0.1", "port": port },
+            "sourcePath": sourcePath,
+            "streamBufferSize": streamBufferSize,
+        }), (result) => {
+            const response = JSON.parse(result);
+            if (response.status === 'pending') {
+                return;
+            }
+            const after = readCounters();
+            const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+            const perGB = (counter) => ((after[counter] - before[counter]) * 1073741824 / totalBytes).toFixed(0);
+            console.log(`streamBufferSize ${streamBufferSize || 'default'}: ${perGB('syscr')} reads/GB, ${perGB('syscw')} writes/GB, ` +
+                `${(totalBytes / 1048576 / seconds).toFixed(1)} MB/s (${response.status})`);
+            fs.rmSync(storagePath, { recursive: true, force: true });
+            run(index + 1);
+        });
+    }, 200);
+};
+
+console.log(`${(totalBytes / 1048576).toFixed(1)} MB`);
+run(0);
@@ -19,8 +19,12 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "memoryImpl.h"
 #include "configurationImpl.h"
 #include "dicomStreamCodecImpl.h"
+#include "fileStreamImpl.h"
 #include "dataHandlerStringUIImpl.h"
+#include "tcpSequenceStreamImpl.h"
+#include "tcpReactorImpl.h"
 #include <memory.h>
+#include <cstdio>
 #include <cassert>
 
 namespace imebra
@@ -968,6 +972,12 @@ acsePDU::~acsePDU()
 
 
 std::shared_ptr<acsePDU> acsePDU::decodePDU(std::shared_ptr<streamReader> pReader)
+{
+    return decodePDU(pReader, nullptr);
+}
+
+
+std::shared_ptr<acsePDU> acsePDU::decodePDU(std::shared_ptr<streamReader> pReader, std::shared_ptr<pdataMemoryPool> pMemoryPool)
 {
     IMEBRA_FUNCTION_START();
 
@@ -989,7 +999,7 @@ std::shared_ptr<acsePDU> acsePDU::decodePDU(std::shared_ptr<streamReader> pReade
             pPDU = std::make_shared<acsePDUAssociateRJ>();
             break;
         case pduType_t::pData:
-            pPDU = std::make_shared<acsePDUPData>();
+            pPDU = std::make_shared<acsePDUPData>(pMemoryPool);
             break;
         case pduType_t::aReleaseRQ:
             pPDU = std::make_shared<acsePDUAReleaseRQ>();
@@ -1334,13 +1344,110 @@ void acsePDUAssociateRJ::decodePDUPayload(std::shared_ptr<streamReader> pReader)
 //
 ///////////////////////////////////////////////////////////
 
+///////////////////////////////////////////////////////////
+//
+// Memory pool for the received PDATA values
+//
+///////////////////////////////////////////////////////////
+
+pdataMemoryPool::pdataMemoryPool():
+    m_unusedSize(0)
+{
+}
+
+
+std::shared_ptr<memory> pdataMemoryPool::getMemory(size_t minimumSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    size_t sizeClass(0);
+    while((m_minimumClassSize << sizeClass) < minimumSize)
+    {
+        ++sizeClass;
+    }
+
+    // Too big for the pool
+    ///////////////////////////////////////////////////////////
+    if(sizeClass >= m_unusedMemory.size())
+    {
+        return std::make_shared<memory>(minimumSize);
+    }
+
+    const size_t classSize(m_minimumClassSize << sizeClass);
+
+    std::unique_ptr<memory> pMemory;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(!m_unusedMemory[sizeClass].empty())
+        {
+            pMemory = std::move(m_unusedMemory[sizeClass].back());
+            m_unusedMemory[sizeClass].pop_back();
+            m_unusedSize -= classSize;
+        }
+    }
+    if(pMemory == nullptr)
+    {
+        pMemory.reset(new memory(classSize));
+    }
+
+    // The memory goes back to the pool when released, unless
+    // the pool has already been destroyed
+    ///////////////////////////////////////////////////////////
+    std::weak_ptr<pdataMemoryPool> pPool(shared_from_this());
+    return std::shared_ptr<memory>(pMemory.release(), [pPool, sizeClass](memory* pReleasedMemory)
+    {
+        std::unique_ptr<memory> pReleased(pReleasedMemory);
+        std::shared_ptr<pdataMemoryPool> pLockedPool(pPool.lock());
+        if(pLockedPool != nullptr)
+        {
+            pLockedPool->reuseMemory(std::move(pReleased), sizeClass);
+        }
+    });
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void pdataMemoryPool::reuseMemory(std::unique_ptr<memory> pMemory, size_t sizeClass)
+{
+    // Called by a deleter: must not throw
+    ///////////////////////////////////////////////////////////
+    try
+    {
+        const size_t classSize(m_minimumClassSize << sizeClass);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(m_unusedSize + classSize <= IMEBRA_PDATA_MEMORY_POOL_MAX_SIZE)
+        {
+            m_unusedMemory[sizeClass].push_back(std::move(pMemory));
+            m_unusedSize += classSize;
+        }
+    }
+    catch(...)
+    {
+        // The memory is just deleted
+    }
+}
+
+
+acsePDUPData::acsePDUPData()
+{
+}
+
+
+acsePDUPData::acsePDUPData(std::shared_ptr<pdataMemoryPool> pMemoryPool):
+    m_pMemoryPool(pMemoryPool)
+{
+}
+
+
 acsePDU::pduType_t acsePDUPData::getPDUType() const
 {
     return pduType_t::pData;
 }
 
 
-size_t acsePDUPData::addItem(std::uint8_t presentationContextId, std::shared_ptr<memory> pMemory, size_t offset, size_t maxPDUSize, bool bCommand)
+size_t acsePDUPData::addItem(std::uint8_t presentationContextId, std::shared_ptr<const memory> pMemory, size_t offset, size_t maxPDUSize, bool bCommand, bool bLastMemory)
 {
     IMEBRA_FUNCTION_START();
 
@@ -1369,7 +1476,7 @@ size_t acsePDUPData::addItem(std::uint8_t presentationContextId, std::shared_ptr
     size_t remainingMemorySize = pMemory->size() - offset;
     if(remainingPDUSize >= remainingMemorySize)
     {
-        pData->m_bLast = true;
+        pData->m_bLast = bLastMemory;
         pData->m_memorySize = remainingMemorySize;
         m_values.push_back(pData);
         return remainingMemorySize;
@@ -1393,6 +1500,76 @@ const acsePDUPData::pdataValues_t& acsePDUPData::getValues() const
 }
 
 
+void acsePDUPData::encodePDU(std::shared_ptr<streamWriter> pWriter) const
+{
+    IMEBRA_FUNCTION_START();
+
+    IMEBRA_LOG_INFO("  -- Sending Data PDU");
+
+    // Each PDV has a 6 bytes header (item length, context id
+    // and pdv header)
+    ///////////////////////////////////////////////////////////
+    size_t pduSize(0);
+    for(const std::shared_ptr<acseItemPDataValue>& pValue: m_values)
+    {
+        pduSize += 6 + pValue->m_memorySize;
+    }
+    if(pduSize > std::numeric_limits<std::uint32_t>::max())
+    {
+        IMEBRA_THROW(std::logic_error, "The PDU's size is too big");
+    }
+
+    // All the headers are built in one buffer, then the
+    // headers and the values are sent together
+    ///////////////////////////////////////////////////////////
+    std::vector<std::uint8_t> headers(6 + 6 * m_values.size());
+    headers[0] = (std::uint8_t)pduType_t::pData;
+    headers[1] = 0;
+    std::uint32_t pduLength(pWriter->adjustEndian((std::uint32_t)pduSize, streamController::highByteEndian));
+    ::memcpy(&(headers[2]), &pduLength, sizeof(pduLength));
+
+    baseStreamOutput::outputBuffers_t buffers;
+    buffers.reserve(1 + 2 * m_values.size());
+    buffers.push_back(baseStreamOutput::outputBuffer{headers.data(), 6});
+
+    size_t headerOffset(6);
+    for(const std::shared_ptr<acseItemPDataValue>& pValue: m_values)
+    {
+        IMEBRA_LOG_INFO("     -- PValue");
+        IMEBRA_LOG_INFO("        size = " << pValue->m_memorySize << " bytes");
+        IMEBRA_LOG_INFO("        type = " << (pValue->m_bCommand ? "command" : "payload"));
+        IMEBRA_LOG_INFO("        last = " << (pValue->m_bLast ? "yes" : "no"));
+
+        std::uint32_t length(pWriter->adjustEndian((std::uint32_t)(pValue->m_memorySize + 2), streamController::highByteEndian));
+        ::memcpy(&(headers[headerOffset]), &length, sizeof(length));
+        headers[headerOffset + 4] = pValue->m_presentationContextId;
+        headers[headerOffset + 5] = (std::uint8_t)((pValue->m_bCommand ? 1 : 0) | (pValue->m_bLast ? 2 : 0));
+
+        // Consecutive headers are merged when there is no value
+        // between them
+        ///////////////////////////////////////////////////////////
+        if(buffers.back().m_pBuffer + buffers.back().m_bufferLength == &(headers[headerOffset]))
+        {
+            buffers.back().m_bufferLength += 6;
+        }
+        else
+        {
+            buffers.push_back(baseStreamOutput::outputBuffer{&(headers[headerOffset]), 6});
+        }
+        headerOffset += 6;
+
+        if(pValue->m_memorySize != 0)
+        {
+            buffers.push_back(baseStreamOutput::outputBuffer{pValue->m_pMemory->data() + pValue->m_memoryOffset, pValue->m_memorySize});
+        }
+    }
+
+    pWriter->write(buffers);
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 void acsePDUPData::encodePDUPayload(std::shared_ptr<streamWriter> pWriter) const
 {
     IMEBRA_FUNCTION_START();
@@ -1450,10 +1627,11 @@ void acsePDUPData::decodePDUPayload(std::shared_ptr<streamReader> reader)
         reader->read(&pdvHeader, 1);
         pDataValue->m_bCommand = (pdvHeader & 1) == 0 ? false : true;
         pDataValue->m_bLast = (pdvHeader & 2) == 0 ? false : true;
-        pDataValue->m_pMemory = std::make_shared<memory>(length - 2);
+        std::shared_ptr<memory> pValueMemory(m_pMemoryPool == nullptr ? std::make_shared<memory>(length - 2) : m_pMemoryPool->getMemory(length - 2));
+        reader->read(pValueMemory->data(), length - 2);
+        pDataValue->m_pMemory = pValueMemory;
         pDataValue->m_memoryOffset = 0;
         pDataValue->m_memorySize = length - 2;
-        reader->read(pDataValue->m_pMemory->data(), length - 2);
 
         IMEBRA_LOG_INFO("     -- PValue");
         IMEBRA_LOG_INFO("        size = " << pDataValue->m_memorySize << " bytes");
@@ -1468,6 +1646,201 @@ void acsePDUPData::decodePDUPayload(std::shared_ptr<streamReader> reader)
 
 
 
+///////////////////////////////////////////////////////////
+//
+// Stream that sends the written data as Data PDUs
+//
+///////////////////////////////////////////////////////////
+
+pdataStreamOutput::pdataStreamOutput(std::shared_ptr<streamWriter> pWriter, std::uint8_t presentationContextId, bool bCommand, std::uint32_t maxPDULength):
+    m_pWriter(pWriter),
+    m_presentationContextId(presentationContextId),
+    m_bCommand(bCommand),
+    m_maxPDULength(maxPDULength == 0 ? MAXIMUM_PDU_SIZE : maxPDULength),
+    m_pendingSize(0),
+    m_writtenSize(0),
+    m_bSent(false)
+{
+}
+
+
+void pdataStreamOutput::write(size_t startPosition, const std::uint8_t* pBuffer, size_t bufferLength)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    checkPosition(startPosition);
+
+    // Copy at most one PDU at a time, so the memory used
+    // stays bounded even when large values are copied
+    ///////////////////////////////////////////////////////////
+    while(bufferLength != 0)
+    {
+        if(m_pCurrentSegment == nullptr)
+        {
+            m_pCurrentSegment = std::make_shared<memory>();
+            m_pending.push_back(pendingData{m_pCurrentSegment, 0});
+        }
+
+        const size_t copySize(std::min(bufferLength, (size_t)m_maxPDULength));
+        const size_t segmentSize(m_pCurrentSegment->size());
+        m_pCurrentSegment->reserve(std::max(segmentSize + copySize, (size_t)m_maxPDULength + 6));
+        m_pCurrentSegment->resize(segmentSize + copySize);
+        ::memcpy(m_pCurrentSegment->data() + segmentSize, pBuffer, copySize);
+
+        pBuffer += copySize;
+        bufferLength -= copySize;
+        m_pendingSize += copySize;
+        m_writtenSize += copySize;
+
+        sendFullPDUs();
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void pdataStreamOutput::write(size_t startPosition, const std::shared_ptr<const memory>& pMemory)
+{
+    IMEBRA_FUNCTION_START();
+
+    if(pMemory->size() == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    checkPosition(startPosition);
+
+    m_pCurrentSegment.reset();
+    m_pending.push_back(pendingData{pMemory, 0});
+    m_pendingSize += pMemory->size();
+    m_writtenSize += pMemory->size();
+
+    sendFullPDUs();
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void pdataStreamOutput::flush()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    while(!m_pending.empty())
+    {
+        sendPDU(true);
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+size_t pdataStreamOutput::getSize() const
+{
+    return m_writtenSize;
+}
+
+
+bool pdataStreamOutput::isSent() const
+{
+    return m_bSent;
+}
+
+
+void pdataStreamOutput::checkPosition(size_t startPosition) const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(startPosition != m_writtenSize)
+    {
+        IMEBRA_THROW(std::logic_error, "The data PDU stream must be written sequentially");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void pdataStreamOutput::sendFullPDUs()
+{
+    IMEBRA_FUNCTION_START();
+
+    // With at least m_maxPDULength bytes pending the PDU is
+    // filled and some data is left for the following one, so
+    // the last fragment is always sent by flush()
+    ///////////////////////////////////////////////////////////
+    while(m_pendingSize >= m_maxPDULength)
+    {
+        sendPDU(false);
+    }
+
+    // The memory still being filled has been partially sent:
+    // if the remaining part has an even size then it becomes
+    // a PDV on its own, otherwise it is moved to the
+    // beginning of the memory so the following writes can
+    // complete it (PDVs are split on even boundaries)
+    ///////////////////////////////////////////////////////////
+    if(m_pCurrentSegment != nullptr && m_pending.front().m_pMemory == m_pCurrentSegment && m_pending.front().m_offset != 0)
+    {
+        pendingData& current(m_pending.front());
+        const size_t remainingSize(m_pCurrentSegment->size() - current.m_offset);
+        if((remainingSize & 0x1) == 0)
+        {
+            m_pCurrentSegment.reset();
+        }
+        else
+        {
+            ::memmove(m_pCurrentSegment->data(), m_pCurrentSegment->data() + current.m_offset, remainingSize);
+            m_pCurrentSegment->resize(remainingSize);
+            current.m_offset = 0;
+        }
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void pdataStreamOutput::sendPDU(bool bLast)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<acsePDUPData> pData(std::make_shared<acsePDUPData>());
+
+    while(!m_pending.empty())
+    {
+        pendingData& front(m_pending.front());
+        size_t added(pData->addItem(m_presentationContextId, front.m_pMemory, front.m_offset, m_maxPDULength, m_bCommand, bLast && m_pending.size() == 1));
+        if(added == 0)
+        {
+            if(pData->getValues().empty())
+            {
+                IMEBRA_THROW(std::logic_error, "The maximum PDU length is too small");
+            }
+            break;
+        }
+        front.m_offset += added;
+        m_pendingSize -= added;
+        if(front.m_offset == front.m_pMemory->size())
+        {
+            if(front.m_pMemory == m_pCurrentSegment)
+            {
+                m_pCurrentSegment.reset();
+            }
+            m_pending.pop_front();
+        }
+    }
+
+    m_bSent = true;
+    pData->encodePDU(m_pWriter);
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Association Release PDU (Base class)
@@ -1734,7 +2107,8 @@ associationBase::associationBase(
         std::uint32_t maxOperationsWeCanPerform,
         std::shared_ptr<streamReader> pReader,
         std::shared_ptr<streamWriter> pWriter,
-        std::uint32_t dimseTimeout):
+        std::uint32_t dimseTimeout,
+        std::uint32_t maxReceivedPDULength):
     m_role(role),
     m_thisAET(thisAET),
     m_otherAET(otherAET),
@@ -1742,8 +2116,14 @@ associationBase::associationBase(
     m_maxOperationsPerformed(maxOperationsWeCanPerform),
     m_bAssociated(1),
     m_maxPDULength(MAXIMUM_PDU_SIZE),
+    m_maxReceivedPDULength(maxReceivedPDULength == 0 ? MAXIMUM_PDU_SIZE : maxReceivedPDULength),
     m_pReader(pReader),
     m_pWriter(pWriter),
+    m_pPDataMemoryPool(std::make_shared<pdataMemoryPool>()),
+    m_reactorSocketId(0),
+    m_receivedBytesSize(0),
+    m_numberOfLastPData(0),
+    m_commandsToNotify(0),
     m_bTerminated(false),
     m_dimseTimeout(dimseTimeout)
 {
@@ -1752,11 +2132,24 @@ associationBase::associationBase(
 
 associationBase::~associationBase()
 {
+    // The listener is not notified while the association
+    // is destroyed
+    ///////////////////////////////////////////////////////////
+    {
+        std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+        m_commandReadyListener = nullptr;
+        m_terminatedListener = nullptr;
+    }
+
     m_pReader->terminate();
     if(m_readDataSetsThread != nullptr)
     {
         m_readDataSetsThread->join();
     }
+    if(m_pReactor != nullptr)
+    {
+        m_pReactor->removeSocket(m_reactorSocketId);
+    }
 }
 
 
@@ -1769,9 +2162,46 @@ void associationBase::sendMessage(std::shared_ptr<const associationMessage> mess
     const std::shared_ptr<const dataSet> pPayload(message->getPayloadDataSetNoThrow());
     if(pPayload != nullptr)
     {
-		// This seems to be a bug, we need to use the negotiated transfer syntax, defaulting to implicit vr for now
-        //transferSyntax = pPayload->getString(0x2, 0, 0x10, 0, 0, "");
+        // Use the payload's own transfer syntax when it has been
+        // negotiated for the message's abstract syntax.
+        // An uncompressed payload can be sent with any of the
+        // uncompressed transfer syntaxes, implicit vr first
+        ///////////////////////////////////////////////////////////
+        const std::string payloadTransferSyntax(pPayload->getString(0x2, 0, 0x10, 0, 0, ""));
+        std::vector<std::string> candidates;
+        if(!payloadTransferSyntax.empty())
+        {
+            candidates.push_back(payloadTransferSyntax);
+        }
+        if(payloadTransferSyntax.empty() ||
+                payloadTransferSyntax == "1.2.840.10008.1.2" ||
+                payloadTransferSyntax == "1.2.840.10008.1.2.1" ||
+                payloadTransferSyntax == "1.2.840.10008.1.2.2")
+        {
+            candidates.push_back("1.2.840.10008.1.2");
+            candidates.push_back("1.2.840.10008.1.2.1");
+            candidates.push_back("1.2.840.10008.1.2.2");
+        }
+
         transferSyntax = "1.2.840.10008.1.2";
+        bool bNegotiated(false);
+        for(const std::string& candidate: candidates)
+        {
+            for(const presentationContextsIds_t::value_type& scanContexts: m_presentationContextsIds)
+            {
+                if(scanContexts.second.first->m_abstractSyntax == message->getAbstractSyntax() &&
+                        scanContexts.second.second == candidate)
+                {
+                    transferSyntax = candidate;
+                    bNegotiated = true;
+                    break;
+                }
+            }
+            if(bNegotiated)
+            {
+                break;
+            }
+        }
     }
 
     // Find the transfer syntax negotiated for the requested
@@ -1806,127 +2236,145 @@ void associationBase::sendMessage(std::shared_ptr<const associationMessage> mess
         IMEBRA_THROW(AcseNoTransferSyntaxError, "No transfer syntax for the selected presentation context with abstract syntax " << message->getAbstractSyntax());
     }
 
-    // Serialize all the datasets (command and payload)
+    // Serialize and send all the datasets (command and payload).
+    // The command is sent in its own PDUs
     ///////////////////////////////////////////////////////////
-    std::shared_ptr<acsePDUPData> pData;
-
     std::unique_lock<std::mutex> lockWrite(m_lockWrite);
 
-    for(size_t dataSetCount(0); dataSetCount != 2; ++dataSetCount)
-    {
-        bool bExplicitDataType(false);
-        streamController::tByteOrdering endianType(streamController::lowByteEndian);
+    // When the encoding fails after part of the message has been
+    // sent the peer would receive a truncated message: the
+    // association is aborted
+    ///////////////////////////////////////////////////////////
+    bool bSent(false);
+    bool bWaitingResponse(false);
+    std::uint32_t waitingCommandId(0);
+    std::shared_ptr<pdataStreamOutput> pDataStream;
 
-        if(dataSetCount != 0)
+    try
+    {
+        for(size_t dataSetCount(0); dataSetCount != 2; ++dataSetCount)
         {
-            // Adjust the transfer syntax flags
-            ///////////////////////////////////////////////////////////
-            bExplicitDataType = (transferSyntax != "1.2.840.10008.1.2");        // Implicit VR little endian
+            bool bExplicitDataType(false);
+            streamController::tByteOrdering endianType(streamController::lowByteEndian);
 
-            // Explicit VR big endian
-            ///////////////////////////////////////////////////////////
-            endianType = (transferSyntax == "1.2.840.10008.1.2.2") ? streamController::highByteEndian : streamController::lowByteEndian;
-        }
+            if(dataSetCount != 0)
+            {
+                // Adjust the transfer syntax flags
+                ///////////////////////////////////////////////////////////
+                bExplicitDataType = (transferSyntax != "1.2.840.10008.1.2");        // Implicit VR little endian
 
-        std::shared_ptr<const dataSet> pDataSet(dataSetCount == 0 ? message->getCommandDataSet() : message->getPayloadDataSetNoThrow());
-        if(pDataSet == nullptr)
-        {
-            break;
-        }
+                // Explicit VR big endian
+                ///////////////////////////////////////////////////////////
+                endianType = (transferSyntax == "1.2.840.10008.1.2.2") ? streamController::highByteEndian : streamController::lowByteEndian;
+            }
 
-        if(pDataSet->bufferExists(0, 0, 0x100, 0))
-        {
-            // Check if the role is correct for the selected
-            // presentation context
-            ///////////////////////////////////////////////////////////
-            const bool bResponse( (pDataSet->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) & 0x00008000) != 0);
-            if(m_role == role_t::scu)
-            {
-                if(!bResponse && !pPresentationContext->m_bRequestorIsSCU)
-                {
-                    IMEBRA_THROW(AcseWrongRoleError, "Wrong role for the selected presentation context");
-                }
-            }
-            else
+            std::shared_ptr<const dataSet> pDataSet(dataSetCount == 0 ? message->getCommandDataSet() : message->getPayloadDataSetNoThrow());
+            if(pDataSet == nullptr)
             {
-                if(!bResponse && !pPresentationContext->m_bRequestorIsSCP)
-                {
-                    IMEBRA_THROW(AcseWrongRoleError, "Wrong role for the selected presentation context");
-                }
+                break;
             }
 
-            std::unique_lock<std::mutex> lockCommandsResponses(m_lockCommandsResponses);
-            if(bResponse)
+            if(pDataSet->bufferExists(0, 0, 0x100, 0))
             {
-                std::uint32_t responseId = pDataSet->getUnsignedLong(0x0, 0, 0x120, 0, 0, 0);
-                if((pDataSet->getUnsignedLong(0x0, 0, 0x900, 0, 0, 0) & 0xfff0) == 0xff00)
+                // Check if the role is correct for the selected
+                // presentation context
+                ///////////////////////////////////////////////////////////
+                const bool bResponse( (pDataSet->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) & 0x00008000) != 0);
+                if(m_role == role_t::scu)
                 {
-                    // partial response
-                    if(m_processingCommands.find(responseId) == m_processingCommands.end())
+                    if(!bResponse && !pPresentationContext->m_bRequestorIsSCU)
                     {
-                        IMEBRA_THROW(AcseWrongResponseIdError, "Sending a partial response with an ID that does not correspond to any received command");
+                        IMEBRA_THROW(AcseWrongRoleError, "Wrong role for the selected presentation context");
                     }
                 }
-                else if(m_processingCommands.erase(responseId) == 0)
+                else
                 {
-                    IMEBRA_THROW(AcseWrongResponseIdError, "Sending a response with an ID that does not correspond to any received command");
+                    if(!bResponse && !pPresentationContext->m_bRequestorIsSCP)
+                    {
+                        IMEBRA_THROW(AcseWrongRoleError, "Wrong role for the selected presentation context");
+                    }
                 }
-            }
-            else
-            {
-                if(pDataSet->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) != 0x0fff)
+
+                std::unique_lock<std::mutex> lockCommandsResponses(m_lockCommandsResponses);
+                if(bResponse)
                 {
-                    const std::uint32_t commandId(pDataSet->getUnsignedLong(0x0, 0, 0x110, 0, 0, 0));
-                    if(m_waitingResponses.count(commandId) != 0)
+                    std::uint32_t responseId = pDataSet->getUnsignedLong(0x0, 0, 0x120, 0, 0, 0);
+                    if((pDataSet->getUnsignedLong(0x0, 0, 0x900, 0, 0, 0) & 0xfff0) == 0xff00)
+                    {
+                        // partial response
+                        if(m_processingCommands.find(responseId) == m_processingCommands.end())
+                        {
+                            IMEBRA_THROW(AcseWrongResponseIdError, "Sending a partial response with an ID that does not correspond to any received command");
+                        }
+                    }
+                    else if(m_processingCommands.erase(responseId) == 0)
                     {
-                        IMEBRA_THROW(AcseWrongCommandIdError, "Sending a command with the same ID of a command still being processed");
+                        IMEBRA_THROW(AcseWrongResponseIdError, "Sending a response with an ID that does not correspond to any received command");
                     }
-                    if(m_maxOperationsInvoked != 0 && m_waitingResponses.size() == m_maxOperationsInvoked)
+                }
+                else
+                {
+                    if(pDataSet->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) != 0x0fff)
                     {
-                        IMEBRA_THROW(AcseTooManyOperationsInvokedError, "Invoking too many operations (max is " << m_maxOperationsInvoked << ")");
+                        const std::uint32_t commandId(pDataSet->getUnsignedLong(0x0, 0, 0x110, 0, 0, 0));
+                        if(m_waitingResponses.count(commandId) != 0)
+                        {
+                            IMEBRA_THROW(AcseWrongCommandIdError, "Sending a command with the same ID of a command still being processed");
+                        }
+                        if(m_maxOperationsInvoked != 0 && m_waitingResponses.size() == m_maxOperationsInvoked)
+                        {
+                            IMEBRA_THROW(AcseTooManyOperationsInvokedError, "Invoking too many operations (max is " << m_maxOperationsInvoked << ")");
+                        }
+                        m_waitingResponses.insert(commandId);
+                        bWaitingResponse = true;
+                        waitingCommandId = commandId;
                     }
-                    m_waitingResponses.insert(commandId);
                 }
             }
-        }
 
-        if(dataSetCount == 1)
-        {
-            // Commands are written in a separate PDU
-            pData->encodePDU(m_pWriter);
-            pData.reset();
-        }
-        if(pData == 0)
-        {
-            pData = std::make_shared<acsePDUPData>();
-        }
+            // Encode the dataset straight into Data PDUs: they are
+            // sent as soon as they are full, the large values are
+            // referenced, not copied
+            ///////////////////////////////////////////////////////////
+            pDataStream = std::make_shared<pdataStreamOutput>(m_pWriter, presentationContextId, dataSetCount == 0, m_maxPDULength);
+            {
+                std::shared_ptr<streamWriter> pDataSetWriter(std::make_shared<streamWriter>(pDataStream));
+                codecs::dicomStreamCodec::buildStream(pDataSetWriter, pDataSet, bExplicitDataType, endianType, codecs::dicomStreamCodec::streamType_t::normal);
+            }
 
-        // Encode the dataset into a memory object
-        //////////////////////////////////////////
-        std::shared_ptr<memory> pEncodedDataSet(std::make_shared<memory>());
-        {
-            std::shared_ptr<memoryStreamOutput> pWriteCommand(std::make_shared<memoryStreamOutput>(pEncodedDataSet));
-            std::shared_ptr<streamWriter> pCommandWriter(std::make_shared<streamWriter>(pWriteCommand));
-            codecs::dicomStreamCodec::buildStream(pCommandWriter, pDataSet, bExplicitDataType, endianType, codecs::dicomStreamCodec::streamType_t::normal);
-        }
+            if((pDataStream->getSize() & 0x1) != 0)
+            {
+                IMEBRA_THROW(std::logic_error, "The data size should be aligned on 2 bytes boundary");
+            }
 
-        if((pEncodedDataSet->size() & 0x1) != 0)
+            pDataStream->flush();
+            bSent = true;
+        }
+    }
+    catch(...)
+    {
+        // The command will never get a response
+        ///////////////////////////////////////////////////////////
+        if(bWaitingResponse)
         {
-            IMEBRA_THROW(std::logic_error, "The data size should be aligned on 2 bytes boundary");
+            std::unique_lock<std::mutex> lockCommandsResponses(m_lockCommandsResponses);
+            m_waitingResponses.erase(waitingCommandId);
         }
 
-        for(size_t offset(0); offset != pEncodedDataSet->size(); )
+        if(bSent || (pDataStream != nullptr && pDataStream->isSent()))
         {
-            size_t added(pData->addItem(presentationContextId, pEncodedDataSet, offset, m_maxPDULength, dataSetCount == 0));
-            if(added == 0)
+            lockWrite.unlock();
+            try
             {
-                pData->encodePDU(m_pWriter);
-                pData = std::make_shared<acsePDUPData>();
+                abort(acsePDUAAbort::reason_t::serviceUser);
+            }
+            catch(...)
+            {
+                // The original error is reported
             }
-            offset += added;
         }
+        throw;
     }
-    pData->encodePDU(m_pWriter);
 
     IMEBRA_FUNCTION_END();
 }
@@ -1949,6 +2397,73 @@ std::shared_ptr<associationMessage> associationBase::getResponse(std::uint16_t m
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Set the functions notified of the received commands and
+// of the termination
+//
+///////////////////////////////////////////////////////////
+void associationBase::setListener(std::function<void()> commandReady, std::function<void()> terminated)
+{
+    IMEBRA_FUNCTION_START();
+
+    size_t readyCommands(0);
+    bool bTerminated(false);
+    {
+        std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+        m_commandReadyListener = commandReady;
+        m_commandsToNotify = 0;
+        readyCommands = m_readyCommands.size();
+        bTerminated = m_bTerminated;
+        if(!bTerminated)
+        {
+            m_terminatedListener = terminated;
+        }
+    }
+
+    // The commands received before the listener was set
+    ///////////////////////////////////////////////////////////
+    for(size_t notify(0); notify != readyCommands; ++notify)
+    {
+        commandReady();
+    }
+    if(bTerminated)
+    {
+        terminated();
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Notify the listener of the commands made ready since
+// the last call
+//
+///////////////////////////////////////////////////////////
+void associationBase::notifyReadyCommands()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::function<void()> commandReady;
+    size_t readyCommands(0);
+    {
+        std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+        readyCommands = m_commandsToNotify;
+        m_commandsToNotify = 0;
+        commandReady = m_commandReadyListener;
+    }
+
+    for(size_t notify(0); notify != readyCommands; ++notify)
+    {
+        commandReady();
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Get a message (command + payload)
@@ -1962,51 +2477,200 @@ std::shared_ptr<associationMessage> associationBase::getMessage(std::uint16_t me
                 std::chrono::steady_clock::now() + std::chrono::seconds(m_dimseTimeout));
 
     std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+    readyMessageWaiter waiter(*this, !bResponse, bResponse, messageId);
 
     // Loop until all the message's dataset have been found
     ///////////////////////////////////////////////////////////
     while(!m_bTerminated)
     {
-        for(readyDatasets_t::iterator scanDatasets(m_readyDataSets.begin()), endDatasets(m_readyDataSets.end());
-            scanDatasets != endDatasets;
-            /* increased in the loop */)
+        std::shared_ptr<associationMessage> pMessage(takeReadyMessage(messageId, bResponse));
+        if(pMessage != nullptr)
         {
-            readyDatasets_t::iterator nextDataset(scanDatasets);
-            ++nextDataset;
+            return pMessage;
+        }
 
-            std::shared_ptr<dataSet> commandDataset((*scanDatasets)->getCommandDataSet());
+        waitReadyMessage(lock, waiter, endTime);
+    }
 
-            if(
-                    (*scanDatasets)->isComplete() &&
-                    (((commandDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0)) & 0x00008000) != 0) == bResponse && // Check if this is a response
-                    (!bResponse || (std::uint16_t)commandDataset->getUnsignedLong(0, 0, 0x0120, 0, 0) == messageId)) // If is a response check the message id
-            {
-                std::shared_ptr<associationMessage> pMessage(*scanDatasets);
-                m_readyDataSets.erase(scanDatasets);
-                return pMessage;
-            }
+    IMEBRA_THROW(StreamClosedError, "The input stream has been closed");
 
-            scanDatasets = nextDataset;
-        }
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Wait for a command or for a specific response
+//
+///////////////////////////////////////////////////////////
+bool associationBase::waitCommandOrResponse(std::uint16_t messageId)
+{
+    IMEBRA_FUNCTION_START();
 
-        if(m_dimseTimeout != 0 && std::chrono::steady_clock::now() > endTime)
+    std::chrono::time_point<std::chrono::steady_clock> endTime(
+                std::chrono::steady_clock::now() + std::chrono::seconds(m_dimseTimeout));
+
+    std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+    readyMessageWaiter waiter(*this, true, true, messageId);
+
+    while(!m_bTerminated)
+    {
+        if(!m_readyCommands.empty())
+        {
+            return true;
+        }
+        if(m_readyResponses.count(messageId) != 0)
         {
-            abort(acsePDUAAbort::reason_t::serviceUser);
-            m_pReader->terminate();
-            IMEBRA_THROW(StreamClosedError, "DIMSE Timeout, closing association");
+            return false;
         }
 
-        if(m_dimseTimeout == 0)
+        waitReadyMessage(lock, waiter, endTime);
+    }
+
+    IMEBRA_THROW(StreamClosedError, "The input stream has been closed");
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Register a thread waiting for a message
+//
+///////////////////////////////////////////////////////////
+associationBase::readyMessageWaiter::readyMessageWaiter(associationBase& association, bool bCommand, bool bResponse, std::uint16_t messageId):
+    m_association(association),
+    m_bCommand(bCommand),
+    m_bResponse(bResponse)
+{
+    if(m_bCommand)
+    {
+        m_commandWaiter = m_association.m_commandWaiters.insert(m_association.m_commandWaiters.end(), this);
+    }
+    if(m_bResponse)
+    {
+        m_responseWaiter = m_association.m_responseWaiters.insert(std::make_pair(messageId, this));
+    }
+}
+
+
+associationBase::readyMessageWaiter::~readyMessageWaiter()
+{
+    if(m_bCommand)
+    {
+        m_association.m_commandWaiters.erase(m_commandWaiter);
+    }
+    if(m_bResponse)
+    {
+        m_association.m_responseWaiters.erase(m_responseWaiter);
+    }
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Store a complete message and wake up only the threads
+// waiting for it.
+// Must be called while m_lockReadyDataSets is locked.
+//
+///////////////////////////////////////////////////////////
+void associationBase::addReadyMessage(std::shared_ptr<associationMessage> pMessage)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<dataSet> commandDataset(pMessage->getCommandDataSet());
+
+    if((commandDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) & 0x00008000) == 0)
+    {
+        m_readyCommands.push_back(pMessage);
+        for(readyMessageWaiter* pWaiter: m_commandWaiters)
         {
-            m_notifyReadyDataSets.wait(lock);
+            pWaiter->m_notify.notify_one();
         }
-        else
+        if(m_commandReadyListener)
         {
-            m_notifyReadyDataSets.wait_until(lock, endTime);
+            ++m_commandsToNotify;
         }
+        return;
     }
 
-    IMEBRA_THROW(StreamClosedError, "The input stream has been closed");
+    const std::uint16_t messageId((std::uint16_t)commandDataset->getUnsignedLong(0, 0, 0x0120, 0, 0));
+    m_readyResponses.insert(std::make_pair(messageId, pMessage));
+    for(std::multimap<std::uint16_t, readyMessageWaiter*>::const_iterator scanWaiters(m_responseWaiters.lower_bound(messageId)), endWaiters(m_responseWaiters.upper_bound(messageId));
+        scanWaiters != endWaiters;
+        ++scanWaiters)
+    {
+        scanWaiters->second->m_notify.notify_one();
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Remove and return a ready message.
+// Must be called while m_lockReadyDataSets is locked.
+//
+///////////////////////////////////////////////////////////
+std::shared_ptr<associationMessage> associationBase::takeReadyMessage(std::uint16_t messageId, bool bResponse)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<associationMessage> pMessage;
+
+    if(!bResponse)
+    {
+        if(!m_readyCommands.empty())
+        {
+            pMessage = m_readyCommands.front();
+            m_readyCommands.pop_front();
+        }
+        return pMessage;
+    }
+
+    // Responses with the same ID are kept in arrival order:
+    // lower_bound returns the oldest one (find may return
+    // any of them)
+    ///////////////////////////////////////////////////////////
+    std::multimap<std::uint16_t, std::shared_ptr<associationMessage> >::iterator findResponse(m_readyResponses.lower_bound(messageId));
+    if(findResponse != m_readyResponses.end() && findResponse->first == messageId)
+    {
+        pMessage = findResponse->second;
+        m_readyResponses.erase(findResponse);
+    }
+    return pMessage;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Wait until a message for the waiter is ready or the
+// DIMSE timeout expires.
+// Must be called while m_lockReadyDataSets is locked.
+//
+///////////////////////////////////////////////////////////
+void associationBase::waitReadyMessage(std::unique_lock<std::mutex>& lock, readyMessageWaiter& waiter, const std::chrono::time_point<std::chrono::steady_clock>& endTime)
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_dimseTimeout != 0 && std::chrono::steady_clock::now() > endTime)
+    {
+        abort(acsePDUAAbort::reason_t::serviceUser);
+        m_pReader->terminate();
+        IMEBRA_THROW(StreamClosedError, "DIMSE Timeout, closing association");
+    }
+
+    if(m_dimseTimeout == 0)
+    {
+        waiter.m_notify.wait(lock);
+    }
+    else
+    {
+        waiter.m_notify.wait_until(lock, endTime);
+    }
 
     IMEBRA_FUNCTION_END();
 }
@@ -2036,15 +2700,13 @@ std::shared_ptr<associationBase::receivedDataset> associationBase::decodePDU(boo
         ///////////////////////////////////////////////////////////
         if(numberOfLastPData != 0)
         {
-            // Decode all the pdata values until the last one of a
-            // dataset is found
+            // Find the presentation context of the dataset in its
+            // last pdata value
             ///////////////////////////////////////////////////////////
-            size_t datasetSize(0);
             std::string abstractSyntax;
             std::string transferSyntax;
-            for(std::shared_ptr<acseItemPDataValue> pData: pendingPData)
+            for(const std::shared_ptr<acseItemPDataValue>& pData: pendingPData)
             {
-                datasetSize += pData->m_memorySize;
                 if(pData->m_bLast)
                 {
                     presentationContextsIds_t::const_iterator findPresentationContext(
@@ -2059,16 +2721,15 @@ std::shared_ptr<associationBase::receivedDataset> associationBase::decodePDU(boo
                 }
             }
 
-            std::shared_ptr<memory> datasetMemory(std::make_shared<memory>(datasetSize));
-            size_t memoryOffset(0);
+            // The dataset is parsed directly from the pdata values,
+            // without concatenating them
+            ///////////////////////////////////////////////////////////
+            memoryChainStreamInput::fragments_t fragments;
             for(;;)
             {
                 std::shared_ptr<acseItemPDataValue> pData(pendingPData.front());
                 pendingPData.pop_front();
-                ::memcpy(datasetMemory->data() + memoryOffset,
-                         pData->m_pMemory->data() + pData->m_memoryOffset,
-                         pData->m_memorySize);
-                memoryOffset += pData->m_memorySize;
+                fragments.push_back(memoryChainStreamInput::fragment{pData->m_pMemory, pData->m_memoryOffset, pData->m_memorySize});
                 if(pData->m_bLast)
                 {
                     break;
@@ -2090,7 +2751,7 @@ std::shared_ptr<associationBase::receivedDataset> associationBase::decodePDU(boo
                 endianType = (transferSyntax == "1.2.840.10008.1.2.2") ? streamController::highByteEndian : streamController::lowByteEndian;
             }
 
-            std::shared_ptr<memoryStreamInput> dataSetStream(std::make_shared<memoryStreamInput>(datasetMemory));
+            std::shared_ptr<memoryChainStreamInput> dataSetStream(std::make_shared<memoryChainStreamInput>(fragments));
             std::shared_ptr<streamReader> dataSetStreamReader(std::make_shared<streamReader>(dataSetStream));
             std::shared_ptr<dataSet> pDataset(std::make_shared<dataSet>(transferSyntax, charsetsList_t()));
             codecs::dicomStreamCodec::parseStream(dataSetStreamReader, pDataset, bExplicitDataType, endianType);
@@ -2102,52 +2763,211 @@ std::shared_ptr<associationBase::receivedDataset> associationBase::decodePDU(boo
 
         // Get pdata values
         ///////////////////////////////////////////////////////////
-        std::shared_ptr<acsePDU> pdu(acsePDU::decodePDU(m_pReader));
+        readPDataValues(m_pReader, pendingPData, numberOfLastPData);
+    }
 
-        switch(pdu->getPDUType())
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Decode a PDU and append its PDATA values to the pending
+// ones
+//
+///////////////////////////////////////////////////////////
+void associationBase::readPDataValues(std::shared_ptr<streamReader> pReader, std::list<std::shared_ptr<acseItemPDataValue> >& pendingPData, size_t& numberOfLastPData) const
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<acsePDU> pdu(acsePDU::decodePDU(pReader, m_pPDataMemoryPool));
+
+    switch(pdu->getPDUType())
+    {
+    case acsePDU::pduType_t::aReleaseRQ:
+        // release request. Send a release response and
+        // throw a StreamClosedError exception
+        {
+            std::unique_lock<std::mutex> lock(m_lockWrite);
+            std::shared_ptr<acsePDUAReleaseRP> releaseRP(std::make_shared<acsePDUAReleaseRP>());
+            releaseRP->encodePDU(m_pWriter);
+            IMEBRA_THROW(StreamClosedError, "The association has been released");
+        }
+        break;
+    case acsePDU::pduType_t::aReleaseRP:
+        // release response received
+        IMEBRA_THROW(StreamClosedError, "The association has been released");
+    case acsePDU::pduType_t::aAbort:
+        // association aborted
+        IMEBRA_THROW(StreamClosedError, "The association has been aborted");
+    case acsePDU::pduType_t::pData:
         {
-        case acsePDU::pduType_t::aReleaseRQ:
-            // release request. Send a release response and
-            // throw a StreamClosedError exception
+
+            std::shared_ptr<acsePDUPData> pData(std::static_pointer_cast<acsePDUPData>(pdu));
+
+            // Add the pdata values to the pending pdata
+            ///////////////////////////////////////////////////////////
+            for(std::shared_ptr<acseItemPDataValue> pDataValue: pData->getValues())
             {
-                std::unique_lock<std::mutex> lock(m_lockWrite);
-                std::shared_ptr<acsePDUAReleaseRP> releaseRP(std::make_shared<acsePDUAReleaseRP>());
-                releaseRP->encodePDU(m_pWriter);
-                IMEBRA_THROW(StreamClosedError, "The association has been released");
+                if(pDataValue->m_memorySize != 0)
+                {
+                    pendingPData.push_back(pDataValue);
+                    if(pDataValue->m_bLast)
+                    {
+                        ++numberOfLastPData;
+                    }
+                }
             }
-            break;
-        case acsePDU::pduType_t::aReleaseRP:
-            // release response received
-            IMEBRA_THROW(StreamClosedError, "The association has been released");
-        case acsePDU::pduType_t::aAbort:
-            // association aborted
-            IMEBRA_THROW(StreamClosedError, "The association has been aborted");
-        case acsePDU::pduType_t::pData:
+        }
+        break;
+    default:
+        IMEBRA_THROW(AcseCorruptedMessageError, "Unexpected association request message (association already negotiated)");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+associationBase::storingPayload::storingPayload(std::shared_ptr<const dataSet> pCommand):
+    m_sopClassUid(pCommand->getString(0x0, 0, 0x0002, 0, 0, "")),
+    m_sopInstanceUid(pCommand->getString(0x0, 0, 0x1000, 0, 0, ""))
+{
+}
+
+
+associationBase::storingPayload::~storingPayload()
+{
+    // Remove the file if the payload is incomplete
+    ///////////////////////////////////////////////////////////
+    m_pFileWriter.reset();
+    if(!m_temporaryFileName.empty())
+    {
+        ::remove(m_temporaryFileName.c_str());
+    }
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Write a C-STORE payload into the storage folder as the
+// PDATA values arrive
+//
+///////////////////////////////////////////////////////////
+bool associationBase::storePendingPayload(bool bWaitForPayload)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<dataSet> pPayload;
+
+    try
+    {
+        storingPayload& payload(*m_pStoringPayload);
+
+        for(;;)
+        {
+            if(m_pendingPData.empty())
+            {
+                if(!bWaitForPayload)
+                {
+                    return false;
+                }
+                readPDataValues(m_pReader, m_pendingPData, m_numberOfLastPData);
+                continue;
+            }
+
+            std::shared_ptr<acseItemPDataValue> pData(m_pendingPData.front());
+            m_pendingPData.pop_front();
+
+            if(pData->m_bCommand)
             {
+                IMEBRA_THROW(AcseCorruptedMessageError, "Payload expected");
+            }
 
-                std::shared_ptr<acsePDUPData> pData(std::static_pointer_cast<acsePDUPData>(pdu));
+            if(payload.m_pFileWriter == nullptr)
+            {
+                // The UID becomes the file name: accept only valid UID
+                // characters
+                ///////////////////////////////////////////////////////////
+                if(payload.m_sopInstanceUid.empty() || payload.m_sopInstanceUid.find_first_not_of("0123456789.") != std::string::npos)
+                {
+                    IMEBRA_THROW(AcseCorruptedMessageError, "Invalid affected SOP instance UID " << payload.m_sopInstanceUid);
+                }
 
-                // Add the pdata values to the pending pdata
+                // Write the preamble and the meta information header
+                // using the negotiated transfer syntax
                 ///////////////////////////////////////////////////////////
-                for(std::shared_ptr<acseItemPDataValue> pDataValue: pData->getValues())
+                presentationContextsIds_t::const_iterator findPresentationContext(
+                            m_presentationContextsIds.find(pData->m_presentationContextId));
+                if(findPresentationContext == m_presentationContextsIds.end())
                 {
-                    if(pDataValue->m_memorySize != 0)
-                    {
-                        pendingPData.push_back(pDataValue);
-                        if(pDataValue->m_bLast)
-                        {
-                            ++numberOfLastPData;
-                        }
-                    }
+                    IMEBRA_THROW(AcseCorruptedMessageError, "Presentation context ID " << pData->m_presentationContextId << " not valid");
                 }
+                payload.m_transferSyntax = findPresentationContext->second.second;
+
+                payload.m_temporaryFileName = m_payloadStorageFolder + "/" + payload.m_sopInstanceUid + ".dcm.part";
+                payload.m_pFileWriter = std::make_shared<streamWriter>(std::make_shared<fileStreamOutput>(payload.m_temporaryFileName));
+
+                std::shared_ptr<dataSet> pMetaHeader(std::make_shared<dataSet>(payload.m_transferSyntax, charsetsList_t()));
+                pMetaHeader->setString(0x0002, 0, 0x0002, 0, payload.m_sopClassUid);
+                pMetaHeader->setString(0x0002, 0, 0x0003, 0, payload.m_sopInstanceUid);
+                pMetaHeader->setString(0x0002, 0, 0x0010, 0, payload.m_transferSyntax);
+
+                std::uint8_t preamble[128];
+                ::memset(preamble, 0, sizeof(preamble));
+                payload.m_pFileWriter->write(preamble, sizeof(preamble));
+                payload.m_pFileWriter->write((const std::uint8_t*)"DICM", 4);
+                codecs::dicomStreamCodec::buildStream(payload.m_pFileWriter, pMetaHeader, true, streamController::lowByteEndian, codecs::dicomStreamCodec::streamType_t::mediaStorage);
             }
-            break;
-        default:
-            IMEBRA_THROW(AcseCorruptedMessageError, "Unexpected association request message (association already negotiated)");
+
+            // Append the fragment as it is
+            ///////////////////////////////////////////////////////////
+            payload.m_pFileWriter->write(pData->m_pMemory->data() + pData->m_memoryOffset, pData->m_memorySize);
+
+            if(pData->m_bLast)
+            {
+                --m_numberOfLastPData;
+                break;
+            }
+        }
+
+        payload.m_pFileWriter->flushDataBuffer();
+        payload.m_pFileWriter.reset();
+
+        const std::string fileName(m_payloadStorageFolder + "/" + payload.m_sopInstanceUid + ".dcm");
+        if(::rename(payload.m_temporaryFileName.c_str(), fileName.c_str()) != 0)
+        {
+            IMEBRA_THROW(StreamWriteError, "Cannot rename " << payload.m_temporaryFileName << " to " << fileName);
         }
+        payload.m_temporaryFileName.clear();
 
+        // The message gets a payload that contains only the
+        // identifiers
+        ///////////////////////////////////////////////////////////
+        pPayload = std::make_shared<dataSet>(payload.m_transferSyntax, charsetsList_t());
+        pPayload->setString(0x0008, 0, 0x0016, 0, payload.m_sopClassUid);
+        pPayload->setString(0x0008, 0, 0x0018, 0, payload.m_sopInstanceUid);
+        m_pStoringPayload.reset();
+    }
+    catch(const StreamEOFError&)
+    {
+        m_pStoringPayload.reset();
+        throw;
+    }
+    catch(const std::exception& e)
+    {
+        m_pStoringPayload.reset();
+        abort(acsePDUAAbort::reason_t::serviceUser);
+        IMEBRA_THROW(StreamClosedError, "Cannot store the payload, association aborted (" << e.what() << ")");
     }
 
+    m_pReceivingMessage->addDataset(pPayload);
+
+    std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+    addReadyMessage(m_pReceivingMessage);
+    m_pReceivingMessage.reset();
+
+    return true;
+
     IMEBRA_FUNCTION_END();
 }
 
@@ -2185,7 +3005,7 @@ void associationBase::release()
         std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
         while(!m_bTerminated)
         {
-            m_notifyReadyDataSets.wait(lock);
+            m_notifyTerminated.wait(lock);
         }
     }
 
@@ -2210,6 +3030,16 @@ std::string associationBase::getOtherAET() const
     IMEBRA_FUNCTION_END();
 }
 
+std::uint32_t associationBase::getMaxOperationsInvoked() const
+{
+    return m_maxOperationsInvoked;
+}
+
+std::uint32_t associationBase::getMaxOperationsPerformed() const
+{
+    return m_maxOperationsPerformed;
+}
+
 std::string associationBase::getPresentationContextTransferSyntax(const std::string& abstractSyntax) const
 {
     IMEBRA_FUNCTION_START();
@@ -2270,121 +3100,351 @@ std::vector<std::string> associationBase::getPresentationContextTransferSyntaxes
 
 void associationBase::getMessagesThread()
 {
-    std::shared_ptr<associationMessage> pMessage;
-
-    std::list<std::shared_ptr<acseItemPDataValue> > pendingData;
-    size_t numberOfLastPData(0);
-
     try
     {
         // Loop until terminated
         ///////////////////////////////////////////////////////////
         for(;;)
         {
-            std::shared_ptr<receivedDataset> pReceivedDataset(decodePDU(pMessage == nullptr, pendingData, numberOfLastPData));
+            receiveMessage();
+            notifyReadyCommands();
+        }
+    }
+    catch(const StreamEOFError&)
+    {
+        setTerminated();
+    }
 
-            if(pReceivedDataset->m_pDataset->bufferExists(0, 0, 0x100, 0))
-            {
-                {
-                    std::unique_lock<std::mutex> lockCommandsResponses(m_lockCommandsResponses);
+}
 
-                    // We received a command or response dataset
-                    ///////////////////////////////////////////////////////////
-                    if( (pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) & 0x00008000) != 0)
-                    {
-                        // We received a response
-                        ///////////////////////////////////////////////////////////
 
-                        // Check for a partial response
-                        ///////////////////////////////////////////////////////////
-                        if( (pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x900, 0, 0, 0) & 0x0000fff0) == 0xff00)
-                        {
-                            // We received a partial response
-                            ///////////////////////////////////////////////////////////
-                            if(m_waitingResponses.find(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0120, 0, 0)) == m_waitingResponses.end())
-                            {
-                                abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
-                                IMEBRA_THROW(AcseWrongResponseIdError, "Received a partial response with a wrong ID");
-                            }
-                        }
-                        else if(m_waitingResponses.erase(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0120, 0, 0)) == 0)
-                        {
-                            abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
-                            IMEBRA_THROW(AcseWrongResponseIdError, "Received a response with a wrong ID");
-                        }
-                    }
-                    else
-                    {
-                        // We received a command (not cancel)
-                        ///////////////////////////////////////////////////////////
-                        if(pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) != 0x0fff)
-                        {
-                            if(m_processingCommands.count(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0110, 0, 0)) != 0)
-                            {
-                                abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
-                                IMEBRA_THROW(AcseWrongCommandIdError, "Received a command with an ID from a command still being processed");
-                            }
-                            if(m_maxOperationsPerformed != 0 && m_processingCommands.size() == m_maxOperationsPerformed)
-                            {
-                                IMEBRA_THROW(AcseTooManyOperationsPerformedError, "Performing too many operations (max is " << m_maxOperationsPerformed << ")");
-                            }
-                            m_processingCommands.insert(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0110, 0, 0));
-                        }
-                    }
-                }
+void associationBase::startReceivingMessages()
+{
+    IMEBRA_FUNCTION_START();
 
-                // We already have an incomplete message for which
-                // the payload hasn't arrived yet
-                ///////////////////////////////////////////////////////////
-                if(pMessage != nullptr)
-                {
-                    abort(acsePDUAAbort::reason_t::serviceProviderUnexpectedPDU);
-                    IMEBRA_THROW(AcseCorruptedMessageError, "Payload expected");
-                }
+    // The reactor watches the socket of the TCP streams
+    ///////////////////////////////////////////////////////////
+    std::shared_ptr<tcpSequenceStreamInput> pTcpInput(std::dynamic_pointer_cast<tcpSequenceStreamInput>(m_pReader->getControlledStream()));
+    if(pTcpInput != nullptr)
+    {
+        m_pReactor = tcpReactor::getReactor();
+    }
+
+    if(m_pReactor == nullptr)
+    {
+        m_readDataSetsThread.reset(new std::thread(&associationBase::getMessagesThread, this));
+        return;
+    }
+
+    // The reactor reads the socket directly. Data received
+    // together with the association negotiation is already
+    // in the reader's buffer
+    ///////////////////////////////////////////////////////////
+    m_pReactorInput = pTcpInput;
+    m_receivedBytesSize = m_pReader->getBufferedSize();
+    m_pReceivedBytes = std::make_shared<memory>(m_receivedBytesSize);
+    if(m_receivedBytesSize != 0)
+    {
+        m_pReader->read(m_pReceivedBytes->data(), m_receivedBytesSize);
+    }
+
+    m_reactorSocketId = m_pReactor->addSocket(
+                pTcpInput->getSocket(),
+                std::bind(&associationBase::receiveAvailableMessages, this),
+                m_receivedBytesSize != 0);
+
+    IMEBRA_FUNCTION_END();
+}
 
-                // Create the new message
-                ///////////////////////////////////////////////////////////
-                pMessage = std::make_shared<associationMessage>(pReceivedDataset->m_presentationContext, pReceivedDataset->m_pDataset);
 
+bool associationBase::receiveAvailableMessages()
+{
+    try
+    {
+        bool bClosed(false);
+        try
+        {
+            receiveAvailablePDUs();
+        }
+        catch(const StreamEOFError&)
+        {
+            // The PDUs received before the socket was closed are
+            // still decoded
+            ///////////////////////////////////////////////////////////
+            bClosed = true;
+        }
+
+        // Decode the complete datasets and write the payloads
+        // received so far, then give the worker back to the
+        // reactor
+        ///////////////////////////////////////////////////////////
+        for(;;)
+        {
+            if(m_pStoringPayload != nullptr)
+            {
+                if(!storePendingPayload(false))
+                {
+                    break;
+                }
+            }
+            else if(m_numberOfLastPData != 0)
+            {
+                receiveMessage();
             }
             else
             {
-                // We received the payload
+                break;
+            }
+        }
+
+        // The listener hands the commands over to its own
+        // threads
+        ///////////////////////////////////////////////////////////
+        notifyReadyCommands();
+
+        if(!bClosed)
+        {
+            return true;
+        }
+    }
+    catch(const StreamEOFError&)
+    {
+    }
+    catch(const std::exception&)
+    {
+        // The reactor's workers serve all the associations:
+        // a corrupted association is just terminated
+    }
+    setTerminated();
+    return false;
+}
+
+
+void associationBase::receiveAvailablePDUs()
+{
+    IMEBRA_FUNCTION_START();
+
+    // Read what the socket has received. At most one PDU of
+    // the maximum length is read per call, so the other
+    // associations get their turn: epoll reports the socket
+    // again if more data is waiting
+    ///////////////////////////////////////////////////////////
+    const size_t pduHeaderSize(6);
+    const size_t maxReadSize(std::max((size_t)m_maxReceivedPDULength + pduHeaderSize, (size_t)IMEBRA_TCP_STREAM_BUFFER_SIZE));
+    bool bClosed(false);
+    for(size_t totalReadSize(0); totalReadSize < maxReadSize; )
+    {
+        const size_t readSize(std::min(maxReadSize - totalReadSize, (size_t)IMEBRA_TCP_STREAM_BUFFER_SIZE));
+        if(m_pReceivedBytes->size() < m_receivedBytesSize + readSize)
+        {
+            m_pReceivedBytes->resize(m_receivedBytesSize + readSize);
+        }
+        size_t readBytes(0);
+        try
+        {
+            readBytes = m_pReactorInput->readAvailable(m_pReceivedBytes->data() + m_receivedBytesSize, readSize);
+        }
+        catch(const StreamEOFError&)
+        {
+            bClosed = true;
+        }
+        if(readBytes == 0)
+        {
+            break;
+        }
+        m_receivedBytesSize += readBytes;
+        totalReadSize += readBytes;
+    }
+
+    // Find the complete PDUs. The length declared in the
+    // PDU header is checked before its bytes are buffered
+    ///////////////////////////////////////////////////////////
+    const std::uint8_t* const pReceivedBytes(m_pReceivedBytes->data());
+    const size_t receivedSize(m_receivedBytesSize);
+    size_t completeSize(0);
+    while(receivedSize - completeSize >= pduHeaderSize)
+    {
+        const std::uint8_t* const pHeader(pReceivedBytes + completeSize);
+        const std::uint32_t pduLength(
+                    ((std::uint32_t)pHeader[2] << 24) |
+                    ((std::uint32_t)pHeader[3] << 16) |
+                    ((std::uint32_t)pHeader[4] << 8) |
+                    (std::uint32_t)pHeader[5]);
+        if(pduLength > m_maxReceivedPDULength)
+        {
+            abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
+            IMEBRA_THROW(AcseCorruptedMessageError, "Received a PDU of " << pduLength << " bytes, the maximum length is " << m_maxReceivedPDULength);
+        }
+        if(receivedSize - completeSize < pduHeaderSize + pduLength)
+        {
+            break;
+        }
+        completeSize += pduHeaderSize + pduLength;
+    }
+
+    // Decode the complete PDUs, keep the incomplete one
+    ///////////////////////////////////////////////////////////
+    if(completeSize != 0)
+    {
+        std::shared_ptr<streamReader> pPDUsReader(std::make_shared<streamReader>(std::make_shared<memoryStreamInput>(m_pReceivedBytes), 0, completeSize));
+        while(!pPDUsReader->endReached())
+        {
+            readPDataValues(pPDUsReader, m_pendingPData, m_numberOfLastPData);
+        }
+        pPDUsReader.reset();
+
+        ::memmove(m_pReceivedBytes->data(), m_pReceivedBytes->data() + completeSize, receivedSize - completeSize);
+        m_receivedBytesSize = receivedSize - completeSize;
+    }
+
+    if(bClosed)
+    {
+        IMEBRA_THROW(StreamClosedError, "The socket has been closed");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void associationBase::receiveMessage()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<receivedDataset> pReceivedDataset(decodePDU(m_pReceivingMessage == nullptr, m_pendingPData, m_numberOfLastPData));
+
+    if(pReceivedDataset->m_pDataset->bufferExists(0, 0, 0x100, 0))
+    {
+        {
+            std::unique_lock<std::mutex> lockCommandsResponses(m_lockCommandsResponses);
+
+            // We received a command or response dataset
+            ///////////////////////////////////////////////////////////
+            if( (pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) & 0x00008000) != 0)
+            {
+                // We received a response
+                ///////////////////////////////////////////////////////////
+
+                // Check for a partial response
                 ///////////////////////////////////////////////////////////
-                if(pMessage == nullptr)
+                if( (pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x900, 0, 0, 0) & 0x0000fff0) == 0xff00)
                 {
-                    abort(acsePDUAAbort::reason_t::serviceProviderUnexpectedPDU);
-                    IMEBRA_THROW(AcseCorruptedMessageError, "Payload received before a command");
+                    // We received a partial response
+                    ///////////////////////////////////////////////////////////
+                    if(m_waitingResponses.find(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0120, 0, 0)) == m_waitingResponses.end())
+                    {
+                        abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
+                        IMEBRA_THROW(AcseWrongResponseIdError, "Received a partial response with a wrong ID");
+                    }
                 }
-                if(pMessage->getAbstractSyntax() != pReceivedDataset->m_presentationContext)
+                else if(m_waitingResponses.erase(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0120, 0, 0)) == 0)
                 {
                     abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
-                    IMEBRA_THROW(AcseCorruptedMessageError, "The payload has an abstract syntax different from the command");
+                    IMEBRA_THROW(AcseWrongResponseIdError, "Received a response with a wrong ID");
                 }
-                pMessage->addDataset(pReceivedDataset->m_pDataset);
             }
-
-            // If the message is complete then add it to the list of
-            // received messages
-            if(pMessage != nullptr && pMessage->isComplete())
+            else
             {
-                std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
-                m_readyDataSets.push_back(pMessage);
-                pMessage.reset();
-                m_notifyReadyDataSets.notify_all();
+                // We received a command (not cancel)
+                ///////////////////////////////////////////////////////////
+                if(pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) != 0x0fff)
+                {
+                    if(m_processingCommands.count(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0110, 0, 0)) != 0)
+                    {
+                        abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
+                        IMEBRA_THROW(AcseWrongCommandIdError, "Received a command with an ID from a command still being processed");
+                    }
+                    if(m_maxOperationsPerformed != 0 && m_processingCommands.size() == m_maxOperationsPerformed)
+                    {
+                        IMEBRA_THROW(AcseTooManyOperationsPerformedError, "Performing too many operations (max is " << m_maxOperationsPerformed << ")");
+                    }
+                    m_processingCommands.insert(pReceivedDataset->m_pDataset->getUnsignedLong(0, 0, 0x0110, 0, 0));
+                }
             }
+        }
+
+        // We already have an incomplete message for which
+        // the payload hasn't arrived yet
+        ///////////////////////////////////////////////////////////
+        if(m_pReceivingMessage != nullptr)
+        {
+            abort(acsePDUAAbort::reason_t::serviceProviderUnexpectedPDU);
+            IMEBRA_THROW(AcseCorruptedMessageError, "Payload expected");
+        }
+
+        // Create the new message
+        ///////////////////////////////////////////////////////////
+        m_pReceivingMessage = std::make_shared<associationMessage>(pReceivedDataset->m_presentationContext, pReceivedDataset->m_pDataset);
+
+        // In pass-through mode the C-STORE payload is written
+        // into the storage folder instead of being decoded
+        ///////////////////////////////////////////////////////////
+        if(!m_payloadStorageFolder.empty() &&
+                pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x100, 0, 0, 0) == 0x0001 &&
+                pReceivedDataset->m_pDataset->getUnsignedLong(0x0, 0, 0x800, 0, 0, 0x0101) != 0x0101)
+        {
+            // The reactor writes the payload as its PDUs arrive
+            ///////////////////////////////////////////////////////////
+            m_pStoringPayload.reset(new storingPayload(pReceivedDataset->m_pDataset));
+            storePendingPayload(m_pReactor == nullptr);
+        }
 
+    }
+    else
+    {
+        // We received the payload
+        ///////////////////////////////////////////////////////////
+        if(m_pReceivingMessage == nullptr)
+        {
+            abort(acsePDUAAbort::reason_t::serviceProviderUnexpectedPDU);
+            IMEBRA_THROW(AcseCorruptedMessageError, "Payload received before a command");
+        }
+        if(m_pReceivingMessage->getAbstractSyntax() != pReceivedDataset->m_presentationContext)
+        {
+            abort(acsePDUAAbort::reason_t::serviceProviderInvalidPDUParameterValue);
+            IMEBRA_THROW(AcseCorruptedMessageError, "The payload has an abstract syntax different from the command");
         }
+        m_pReceivingMessage->addDataset(pReceivedDataset->m_pDataset);
     }
-    catch(const StreamEOFError&)
+
+    // If the message is complete then add it to the list of
+    // received messages
+    if(m_pReceivingMessage != nullptr && m_pReceivingMessage->isComplete())
+    {
+        std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
+        addReadyMessage(m_pReceivingMessage);
+        m_pReceivingMessage.reset();
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void associationBase::setTerminated()
+{
+    std::function<void()> terminated;
     {
         // Set the terminated flag, release current getMessage()
         // operations
         std::unique_lock<std::mutex> lock(m_lockReadyDataSets);
         m_bTerminated = true;
-        m_notifyReadyDataSets.notify_all();
+        for(readyMessageWaiter* pWaiter: m_commandWaiters)
+        {
+            pWaiter->m_notify.notify_one();
+        }
+        for(const std::pair<const std::uint16_t, readyMessageWaiter*>& responseWaiter: m_responseWaiters)
+        {
+            responseWaiter.second->m_notify.notify_one();
+        }
+        m_notifyTerminated.notify_all();
+
+        // The listener is notified only once
+        terminated.swap(m_terminatedListener);
     }
 
+    if(terminated)
+    {
+        terminated();
+    }
 }
 
 associationSCU::associationSCU(
@@ -2395,8 +3455,9 @@ associationSCU::associationSCU(
         std::uint32_t maxOperationsWeCanPerform,
         std::shared_ptr<streamReader> pReader,
         std::shared_ptr<streamWriter> pWriter,
-        std::uint32_t dimseTimeout):
-    associationBase(role_t::scu, thisAET, otherAET, maxOperationsWeInvoke, maxOperationsWeCanPerform, pReader, pWriter, dimseTimeout)
+        std::uint32_t dimseTimeout,
+        std::uint32_t maxReceivedPDULength):
+    associationBase(role_t::scu, thisAET, otherAET, maxOperationsWeInvoke, maxOperationsWeCanPerform, pReader, pWriter, dimseTimeout, maxReceivedPDULength)
 
 {
     IMEBRA_FUNCTION_START();
@@ -2452,7 +3513,7 @@ associationSCU::associationSCU(
     const std::string implementationName(IMEBRA_IMPLEMENTATION_NAME);
     std::shared_ptr<acseItemUserInformation> pUserInformation(
                 std::make_shared<acseItemUserInformation>(
-                    m_maxPDULength,
+                    m_maxReceivedPDULength,
                     implementationUid,
                     implementationName,
                     m_maxOperationsInvoked,
@@ -2601,7 +3662,7 @@ associationSCU::associationSCU(
 
     IMEBRA_LOG_INFO("-- Terminated SCU association negotiation");
 
-    m_readDataSetsThread.reset(new std::thread(&associationBase::getMessagesThread, this));
+    startReceivingMessages();
 
     IMEBRA_FUNCTION_END();
 }
@@ -2615,11 +3676,15 @@ associationSCP::associationSCP(
         std::shared_ptr<streamReader> pReader,
         std::shared_ptr<streamWriter> pWriter,
         std::uint32_t dimseTimeout,
-        std::uint32_t artimTimeoutSeconds):
-    associationBase(role_t::scp, thisAET, "", maxOperationsWeInvoke, maxOperationsWeCanPerform, pReader, pWriter, dimseTimeout)
+        std::uint32_t artimTimeoutSeconds,
+        const std::string& payloadStorageFolder,
+        std::uint32_t maxReceivedPDULength):
+    associationBase(role_t::scp, thisAET, "", maxOperationsWeInvoke, maxOperationsWeCanPerform, pReader, pWriter, dimseTimeout, maxReceivedPDULength)
 {
     IMEBRA_FUNCTION_START();
 
+    m_payloadStorageFolder = payloadStorageFolder;
+
     IMEBRA_LOG_INFO("-- Starting SCP association negotiation");
 
     // Wait for association request PDU
@@ -2801,7 +3866,7 @@ associationSCP::associationSCP(
         }
     }
     std::shared_ptr<acseItemUserInformation> pUserInformationAC(std::make_shared<acseItemUserInformation>(
-                                                                    m_maxPDULength,
+                                                                    m_maxReceivedPDULength,
                                                                     IMEBRA_IMPLEMENTATION_CLASS_UID,
                                                                     IMEBRA_IMPLEMENTATION_NAME,
                                                                     m_maxOperationsPerformed,
@@ -2817,7 +3882,7 @@ associationSCP::associationSCP(
 
     IMEBRA_LOG_INFO("-- Terminated SCP association negotiation");
 
-    m_readDataSetsThread.reset(new std::thread(&associationBase::getMessagesThread, this));
+    startReceivingMessages();
 
     IMEBRA_FUNCTION_END_MODIFY(CodecCorruptedFileError, AcseCorruptedMessageError);
 }
@@ -24,14 +24,21 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <string>
 #include <memory>
 #include <list>
+#include <map>
 #include <vector>
 #include <set>
+#include <array>
 #include <atomic>
 #include <mutex>
 #include <condition_variable>
+#include <chrono>
 #include "configurationImpl.h"
 #include "streamReaderImpl.h"
 
+#if(!defined IMEBRA_PDATA_MEMORY_POOL_MAX_SIZE)
+    #define IMEBRA_PDATA_MEMORY_POOL_MAX_SIZE 4194304
+#endif
+
 namespace imebra
 {
 
@@ -42,6 +49,9 @@ class streamWriter;
 class streamReader;
 class memory;
 class dataSet;
+class pdataMemoryPool;
+class tcpReactor;
+class tcpSequenceStreamInput;
 
 ///
 /// @brief Base class for the Items encoded in the ACSE messages
@@ -647,7 +657,7 @@ public:
     /// \brief Memory object containing the PDATA value.
     ///
     //////////////////////////////////////////////////////////////////
-    std::shared_ptr<memory> m_pMemory;
+    std::shared_ptr<const memory> m_pMemory;
 
     ///
     /// \brief Offset in m_pMemory where the PDATA value starts.
@@ -697,6 +707,18 @@ public:
     //////////////////////////////////////////////////////////////////
     static std::shared_ptr<acsePDU> decodePDU(std::shared_ptr<streamReader> pReader);
 
+    ///
+    /// \brief Decode a PDU from a streamReader, allocating the
+    ///        PDATA values from a memory pool.
+    ///
+    /// \param pReader     the reader from which the PDU must be read
+    /// \param pMemoryPool the pool used to allocate the memory
+    ///                    for the PDATA values
+    /// \return the decoded PDU
+    ///
+    //////////////////////////////////////////////////////////////////
+    static std::shared_ptr<acsePDU> decodePDU(std::shared_ptr<streamReader> pReader, std::shared_ptr<pdataMemoryPool> pMemoryPool);
+
     ///
     /// \brief Encode the PDU into a streamWriter.
     ///
@@ -704,7 +726,7 @@ public:
     ///                be encoded
     ///
     //////////////////////////////////////////////////////////////////
-    void encodePDU(std::shared_ptr<streamWriter> pWriter) const;
+    virtual void encodePDU(std::shared_ptr<streamWriter> pWriter) const;
 
     ///
     /// \brief Return the PDU type.
@@ -935,6 +957,50 @@ protected:
 };
 
 
+///
+/// \brief Recycles the memory used to receive the PDATA
+///        values of an association.
+///
+/// The memory is allocated in size classes (powers of 2,
+/// starting from 1 KB), so PDATA values of similar size
+/// share the same memory objects. When a PDATA value
+/// releases its memory the memory goes back to the pool
+/// (up to IMEBRA_PDATA_MEMORY_POOL_MAX_SIZE bytes) and is
+/// reused for the following PDUs.
+///
+//////////////////////////////////////////////////////////////////
+class pdataMemoryPool: public std::enable_shared_from_this<pdataMemoryPool>
+{
+public:
+    pdataMemoryPool();
+
+    ///
+    /// \brief Return a memory object of at least the requested
+    ///        size.
+    ///
+    /// The returned memory goes back to the pool when it is
+    /// released.
+    ///
+    /// \param minimumSize the minimum size of the memory, in
+    ///                    bytes
+    /// \return a new or recycled memory object
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::shared_ptr<memory> getMemory(size_t minimumSize);
+
+private:
+    void reuseMemory(std::unique_ptr<memory> pMemory, size_t sizeClass);
+
+    static const size_t m_minimumClassSize = 1024;
+
+    std::mutex m_mutex;
+
+    std::array<std::vector<std::unique_ptr<memory> >, 15> m_unusedMemory;
+
+    size_t m_unusedSize;
+};
+
+
 ///
 /// \brief PDATA PDU.
 ///
@@ -942,6 +1008,18 @@ protected:
 class acsePDUPData: public acsePDU
 {
 public:
+    acsePDUPData();
+
+    ///
+    /// \brief Constructor used for the PDUs that are going to be
+    ///        decoded.
+    ///
+    /// \param pMemoryPool the pool from which the memory for the
+    ///                    decoded PDATA values is allocated
+    ///
+    //////////////////////////////////////////////////////////////////
+    acsePDUPData(std::shared_ptr<pdataMemoryPool> pMemoryPool);
+
     virtual pduType_t getPDUType() const override;
 
     ///
@@ -960,12 +1038,27 @@ public:
     /// \param offset     data offset in memory
     /// \param maxPDUSize maximum PDU size
     /// \param bCommand   true if the memory refers to a command
+    /// \param bLastMemory true if the memory contains the last
+    ///                   part of the command or payload
     /// \return           the number of added bytes. add
     ///                   this value to the offset for the
     ///                   next call
     ///
     //////////////////////////////////////////////////////////////////
-    size_t addItem(std::uint8_t presentationContextId, std::shared_ptr<memory> pData, size_t offset, size_t maxPDUSize, bool bCommand);
+    size_t addItem(std::uint8_t presentationContextId, std::shared_ptr<const memory> pData, size_t offset, size_t maxPDUSize, bool bCommand, bool bLastMemory);
+
+    ///
+    /// \brief Encode the PDU into a streamWriter.
+    ///
+    /// The PDU and PDV headers and the PDATA values are
+    /// handed to the writer as a list of buffers, so the
+    /// values are sent without being copied.
+    ///
+    /// \param pWriter the streamWriter into which the PDU must
+    ///                be encoded
+    ///
+    //////////////////////////////////////////////////////////////////
+    virtual void encodePDU(std::shared_ptr<streamWriter> pWriter) const override;
 
     ///
     /// \brief List of PDATA value items.
@@ -986,6 +1079,113 @@ protected:
     virtual void decodePDUPayload(std::shared_ptr<streamReader> pReader) override;
 
     pdataValues_t m_values;
+
+    const std::shared_ptr<pdataMemoryPool> m_pMemoryPool;
+};
+
+
+///
+/// \brief Output stream that sends the data written into it
+///        as P-DATA PDUs while a command or a payload dataset
+///        is being encoded.
+///
+/// A PDU is sent as soon as enough data to fill it has been
+/// written, so the encoding of the following data overlaps
+/// with the transmission and only about one PDU of encoded
+/// data is kept in memory.
+///
+/// Memory objects written with write(size_t,
+/// std::shared_ptr<const memory>) are referenced and sent
+/// without being copied.
+///
+/// flush() must be called once the dataset has been encoded:
+/// it sends the remaining data marked as the last fragment.
+///
+//////////////////////////////////////////////////////////////////
+class pdataStreamOutput: public baseStreamOutput
+{
+public:
+    ///
+    /// \brief Constructor.
+    ///
+    /// \param pWriter      the writer used to send the PDUs
+    /// \param presentationContextId the presentation context
+    /// \param bCommand     true if a command is being sent,
+    ///                     false for a payload
+    /// \param maxPDULength the maximum PDU length accepted by
+    ///                     the peer. 0 means unlimited, in which
+    ///                     case MAXIMUM_PDU_SIZE is used
+    ///
+    //////////////////////////////////////////////////////////////////
+    pdataStreamOutput(std::shared_ptr<streamWriter> pWriter, std::uint8_t presentationContextId, bool bCommand, std::uint32_t maxPDULength);
+
+    using baseStreamOutput::write;
+
+    virtual void write(size_t startPosition, const std::uint8_t* pBuffer, size_t bufferLength) override;
+
+    virtual void write(size_t startPosition, const std::shared_ptr<const memory>& pMemory) override;
+
+    ///
+    /// \brief Send the data not yet sent and mark it as the
+    ///        last fragment of the dataset.
+    ///
+    //////////////////////////////////////////////////////////////////
+    void flush();
+
+    ///
+    /// \brief Return the number of bytes written so far.
+    ///
+    /// \return the number of bytes written into the stream
+    ///
+    //////////////////////////////////////////////////////////////////
+    size_t getSize() const;
+
+    ///
+    /// \brief Return true if at least one PDU has been sent.
+    ///
+    /// \return true if part of the dataset has already been
+    ///         written into the writer
+    ///
+    //////////////////////////////////////////////////////////////////
+    bool isSent() const;
+
+private:
+    void checkPosition(size_t startPosition) const;
+
+    void sendFullPDUs();
+
+    void sendPDU(bool bLast);
+
+    const std::shared_ptr<streamWriter> m_pWriter;
+    const std::uint8_t m_presentationContextId;
+    const bool m_bCommand;
+    const std::uint32_t m_maxPDULength;
+
+    ///
+    /// \brief Data written but not yet sent.
+    ///
+    //////////////////////////////////////////////////////////////////
+    struct pendingData
+    {
+        std::shared_ptr<const memory> m_pMemory;
+        size_t m_offset;
+    };
+    std::list<pendingData> m_pending;
+    size_t m_pendingSize;
+
+    ///
+    /// \brief Memory owned by the stream where the data is
+    ///        being copied. When not null it is referenced by
+    ///        the last item in m_pending.
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::shared_ptr<memory> m_pCurrentSegment;
+
+    size_t m_writtenSize;
+
+    bool m_bSent;
+
+    std::mutex m_mutex;
 };
 
 
@@ -1204,6 +1404,40 @@ public:
     //////////////////////////////////////////////////////////////////
     std::shared_ptr<associationMessage> getResponse(std::uint16_t messageId);
 
+    ///
+    /// \brief Sets the functions called for each received
+    ///        command and once the association has been
+    ///        terminated.
+    ///
+    /// The functions are called by the thread (or reactor
+    /// worker) that receives the messages, without locks held.
+    /// The commands already received are notified by the
+    /// calling thread, which also calls terminated if the
+    /// association has already been terminated.
+    ///
+    /// \param commandReady called once for each command that
+    ///                     can be retrieved with getCommand()
+    /// \param terminated   called once when the association
+    ///                     has been terminated
+    ///
+    //////////////////////////////////////////////////////////////////
+    void setListener(std::function<void()> commandReady, std::function<void()> terminated);
+
+    ///
+    /// \brief Wait until a command or the response to a
+    ///        specific command ID is available.
+    ///
+    /// The message is left in the queue: it can be retrieved
+    /// with getCommand() or getResponse() without blocking.
+    ///
+    /// \param messageId the command's ID to which the reply is
+    ///                  related
+    /// \return true if a command is available, false if the
+    ///         response is available
+    ///
+    //////////////////////////////////////////////////////////////////
+    bool waitCommandOrResponse(std::uint16_t messageId);
+
     ///
     /// \brief Abort the association. The other peer will not send
     ///        an acknowledgement.
@@ -1236,6 +1470,26 @@ public:
     //////////////////////////////////////////////////////////////////
     std::string getOtherAET() const;
 
+    ///
+    /// \brief Returns the negotiated maximum number of
+    ///        outstanding operations that we can invoke.
+    ///
+    /// \return the maximum number of operations we can invoke
+    ///         (0 = unlimited)
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::uint32_t getMaxOperationsInvoked() const;
+
+    ///
+    /// \brief Returns the negotiated maximum number of
+    ///        outstanding operations that we can perform.
+    ///
+    /// \return the maximum number of operations we can perform
+    ///         (0 = unlimited)
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::uint32_t getMaxOperationsPerformed() const;
+
     std::string getPresentationContextTransferSyntax(const std::string& abstractSyntax) const;
 
     std::vector<std::string> getPresentationContextTransferSyntaxes(const std::string& abstractSyntax) const;
@@ -1244,6 +1498,18 @@ public:
 
 protected:
 
+    ///
+    /// \brief Starts receiving the messages once the
+    ///        association has been negotiated.
+    ///
+    /// When the reactor is enabled and the association runs
+    /// on a TCP stream then the socket is handed to the
+    /// reactor, otherwise getMessagesThread() runs in a
+    /// dedicated thread.
+    ///
+    ///////////////////////////////////////////////////////////
+    void startReceivingMessages();
+
     associationBase(
             role_t role,
             const std::string& thisAET,
@@ -1252,7 +1518,8 @@ protected:
             std::uint32_t maxOperationsWeCanPerform,
             std::shared_ptr<streamReader> pReader,
             std::shared_ptr<streamWriter> pWriter,
-            std::uint32_t dimseTimeout);
+            std::uint32_t dimseTimeout,
+            std::uint32_t maxReceivedPDULength);
 
     std::shared_ptr<associationMessage> getMessage(std::uint16_t messageId, bool bResponse);
 
@@ -1280,13 +1547,57 @@ protected:
     ///////////////////////////////////////////////////////////
     std::atomic<int> m_bAssociated;
 
+    ///
+    /// \brief Maximum length of the PDUs sent to the peer, as
+    ///        declared by the peer during the negotiation.
+    ///
+    ///////////////////////////////////////////////////////////
     std::uint32_t m_maxPDULength;
 
+    ///
+    /// \brief Maximum length of the PDUs we accept from the
+    ///        peer, declared during the negotiation.
+    ///
+    ///////////////////////////////////////////////////////////
+    const std::uint32_t m_maxReceivedPDULength;
+
     std::shared_ptr<streamReader> m_pReader;
     std::shared_ptr<streamWriter> m_pWriter;
 
+    ///
+    /// \brief Memory recycled for the received PDATA values.
+    ///
+    ///////////////////////////////////////////////////////////
+    const std::shared_ptr<pdataMemoryPool> m_pPDataMemoryPool;
+
     std::unique_ptr<std::thread> m_readDataSetsThread;
 
+    ///
+    /// \brief The reactor that receives the messages when
+    ///        m_readDataSetsThread is not used.
+    ///
+    ///////////////////////////////////////////////////////////
+    std::shared_ptr<tcpReactor> m_pReactor;
+    std::uint64_t m_reactorSocketId;
+
+    ///
+    /// \brief With the reactor, the stream read without
+    ///        blocking and the received bytes that don't form
+    ///        a complete PDU yet (the first
+    ///        m_receivedBytesSize bytes of m_pReceivedBytes).
+    ///
+    ///////////////////////////////////////////////////////////
+    std::shared_ptr<tcpSequenceStreamInput> m_pReactorInput;
+    std::shared_ptr<memory> m_pReceivedBytes;
+    size_t m_receivedBytesSize;
+
+    ///
+    /// \brief When not empty then the C-STORE payloads are
+    ///        stored in this folder without being decoded.
+    ///
+    ///////////////////////////////////////////////////////////
+    std::string m_payloadStorageFolder;
+
 private:
 
     struct receivedDataset
@@ -1305,13 +1616,182 @@ private:
     ///////////////////////////////////////////////////////////
     std::shared_ptr<receivedDataset> decodePDU(bool bCommand, std::list<std::shared_ptr<acseItemPDataValue> >& pendingData, size_t& m_numberOfLastPData) const;
 
-    /// Datasets ready to be retrieved by getMessage()
+    ///
+    /// \brief Decodes the next PDU from pReader and appends
+    ///        its PDATA values to the pending ones
+    ///
+    ///////////////////////////////////////////////////////////
+    void readPDataValues(std::shared_ptr<streamReader> pReader, std::list<std::shared_ptr<acseItemPDataValue> >& pendingData, size_t& numberOfLastPData) const;
+
+    ///
+    /// \brief A C-STORE payload being written into
+    ///        m_payloadStorageFolder as its PDATA values
+    ///        arrive, without being decoded.
+    ///
+    /// The destructor removes the file if it has not been
+    /// completely written.
+    ///
+    ///////////////////////////////////////////////////////////
+    struct storingPayload
+    {
+        storingPayload(std::shared_ptr<const dataSet> pCommand);
+        ~storingPayload();
+        const std::string m_sopClassUid;
+        const std::string m_sopInstanceUid;
+        std::string m_temporaryFileName;
+        std::string m_transferSyntax;
+        std::shared_ptr<streamWriter> m_pFileWriter;
+    };
+
+    ///
+    /// \brief Writes the pending PDATA values of the payload
+    ///        being stored (m_pStoringPayload) into its file.
+    ///
+    /// Once the last value has been written the file is
+    /// renamed and the message being received, with a
+    /// payload that contains only the SOP class UID and the
+    /// SOP instance UID, becomes available to getMessage().
+    ///
+    /// \param bWaitForPayload true to read the PDUs until
+    ///                        the payload is complete, false
+    ///                        to write only the PDATA values
+    ///                        already received
+    /// \return true if the payload has been stored, false if
+    ///         more PDATA values are needed
+    ///
     ///////////////////////////////////////////////////////////
-    typedef std::list<std::shared_ptr<associationMessage> > readyDatasets_t;
-    readyDatasets_t m_readyDataSets;
+    bool storePendingPayload(bool bWaitForPayload);
+
+    ///
+    /// \brief Decodes the next dataset and, once a message is
+    ///        complete, makes it available to getMessage().
+    ///
+    ///////////////////////////////////////////////////////////
+    void receiveMessage();
+
+    ///
+    /// \brief Called by the reactor when the socket is
+    ///        readable: reads the received bytes without
+    ///        blocking, then decodes the complete PDUs and
+    ///        the datasets they complete.
+    ///
+    /// A PDU is decoded only once all its bytes have arrived,
+    /// so a slow peer doesn't hold the reactor's worker.
+    ///
+    /// \return true if the socket must be watched again,
+    ///         false if the association has been terminated
+    ///
+    ///////////////////////////////////////////////////////////
+    bool receiveAvailableMessages();
+
+    ///
+    /// \brief Appends the bytes available on the socket to
+    ///        m_pReceivedBytes, without blocking, and decodes
+    ///        the complete PDUs into m_pendingPData.
+    ///
+    /// Throws StreamEOFError if the peer closed the
+    /// connection, after decoding the complete PDUs.
+    ///
+    ///////////////////////////////////////////////////////////
+    void receiveAvailablePDUs();
+
+    ///
+    /// \brief Marks the association as terminated and wakes
+    ///        up the threads waiting for a message.
+    ///
+    ///////////////////////////////////////////////////////////
+    void setTerminated();
+
+    ///
+    /// \brief Calls the commandReady listener for the commands
+    ///        made ready since the last call.
+    ///
+    ///////////////////////////////////////////////////////////
+    void notifyReadyCommands();
+
+    /// State of the message being received, used only by the
+    /// thread (or reactor worker) receiving the messages
+    ///////////////////////////////////////////////////////////
+    std::shared_ptr<associationMessage> m_pReceivingMessage;
+    std::list<std::shared_ptr<acseItemPDataValue> > m_pendingPData;
+    size_t m_numberOfLastPData;
+    std::unique_ptr<storingPayload> m_pStoringPayload;
+
+    /// Commands ready to be retrieved by getMessage(), in
+    /// the order in which they arrived
+    ///////////////////////////////////////////////////////////
+    std::list<std::shared_ptr<associationMessage> > m_readyCommands;
+
+    /// Responses ready to be retrieved by getMessage(),
+    /// indexed by the ID of the message they respond to
+    ///////////////////////////////////////////////////////////
+    std::multimap<std::uint16_t, std::shared_ptr<associationMessage> > m_readyResponses;
+
+    ///
+    /// \brief A thread waiting for a command and/or for the
+    ///        responses to a specific message.
+    ///
+    /// Each waiter has its own condition variable, so a new
+    /// message wakes up only the threads waiting for it.
+    /// The constructor registers the waiter and the
+    /// destructor removes it: both must be called while
+    /// m_lockReadyDataSets is locked.
+    ///
+    ///////////////////////////////////////////////////////////
+    class readyMessageWaiter
+    {
+    public:
+        readyMessageWaiter(associationBase& association, bool bCommand, bool bResponse, std::uint16_t messageId);
+        ~readyMessageWaiter();
+
+        std::condition_variable m_notify;
+
+    private:
+        associationBase& m_association;
+        const bool m_bCommand;
+        const bool m_bResponse;
+        std::list<readyMessageWaiter*>::iterator m_commandWaiter;
+        std::multimap<std::uint16_t, readyMessageWaiter*>::iterator m_responseWaiter;
+    };
+
+    std::list<readyMessageWaiter*> m_commandWaiters;
+    std::multimap<std::uint16_t, readyMessageWaiter*> m_responseWaiters;
+
+    /// Listener set with setListener() and the number of
+    /// commands it has not been notified of yet
+    ///////////////////////////////////////////////////////////
+    std::function<void()> m_commandReadyListener;
+    std::function<void()> m_terminatedListener;
+    size_t m_commandsToNotify;
+
+    ///
+    /// \brief Store a complete message and wake up the
+    ///        threads waiting for it.
+    ///        Must be called while m_lockReadyDataSets is
+    ///        locked.
+    ///
+    ///////////////////////////////////////////////////////////
+    void addReadyMessage(std::shared_ptr<associationMessage> pMessage);
+
+    ///
+    /// \brief Remove and return the first ready command or
+    ///        response to the specified message.
+    ///        Must be called while m_lockReadyDataSets is
+    ///        locked.
+    ///
+    /// \return the message, or null if it is not ready yet
+    ///
+    ///////////////////////////////////////////////////////////
+    std::shared_ptr<associationMessage> takeReadyMessage(std::uint16_t messageId, bool bResponse);
+
+    void waitReadyMessage(std::unique_lock<std::mutex>& lock, readyMessageWaiter& waiter, const std::chrono::time_point<std::chrono::steady_clock>& endTime);
+
     std::atomic<bool> m_bTerminated;
     std::mutex m_lockReadyDataSets;
-    std::condition_variable m_notifyReadyDataSets;
+
+    /// Notified when the association is terminated
+    ///////////////////////////////////////////////////////////
+    std::condition_variable m_notifyTerminated;
 
     // Lock while writing commands (only one command at the
     // time may be sent to the other party)
@@ -1370,6 +1850,9 @@ public:
     ///                             sent
     /// \param dimseTimeoutSeconds  DIMSE timeout, in seconds. 0
     ///                             means infinite
+    /// \param maxReceivedPDULength maximum length of the PDUs that
+    ///                             the SCP may send to this SCU.
+    ///                             0 means MAXIMUM_PDU_SIZE
     ///
     //////////////////////////////////////////////////////////////////
     associationSCU(
@@ -1380,7 +1863,8 @@ public:
             std::uint32_t maxOperationsWeCanPerform,
             std::shared_ptr<streamReader> pReader,
             std::shared_ptr<streamWriter> pWriter,
-            std::uint32_t dimseTimeoutSeconds);
+            std::uint32_t dimseTimeoutSeconds,
+            std::uint32_t maxReceivedPDULength);
 
 };
 
@@ -1422,6 +1906,14 @@ public:
     /// \param artimTimeoutSeconds  maximum time, in seconds, that can
     ///                             pass before an association request
     ///                             arrives
+    /// \param payloadStorageFolder if not empty then the payloads of
+    ///                             the received C-STORE commands are
+    ///                             written as they arrive into
+    ///                             payloadStorageFolder/<SOP Instance UID>.dcm
+    ///                             instead of being decoded
+    /// \param maxReceivedPDULength maximum length of the PDUs that
+    ///                             the SCU may send to this SCP.
+    ///                             0 means MAXIMUM_PDU_SIZE
     ///
     //////////////////////////////////////////////////////////////////
     associationSCP(
@@ -1432,7 +1924,9 @@ public:
             std::shared_ptr<streamReader> pReader,
             std::shared_ptr<streamWriter> pWriter,
             std::uint32_t dimseTimeoutSeconds,
-            std::uint32_t artimTimeoutSeconds);
+            std::uint32_t artimTimeoutSeconds,
+            const std::string& payloadStorageFolder,
+            std::uint32_t maxReceivedPDULength);
 
 };
 
@@ -82,6 +82,52 @@ void baseSequenceStreamOutput::write(size_t startPosition, const std::uint8_t* p
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    seekForward(startPosition);
+
+    write(pBuffer, bufferLength);
+
+    m_currentPosition += bufferLength;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void baseSequenceStreamOutput::write(size_t startPosition, const outputBuffers_t& buffers)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    seekForward(startPosition);
+
+    write(buffers);
+
+    for(const outputBuffer& writtenBuffer: buffers)
+    {
+        m_currentPosition += writtenBuffer.m_bufferLength;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void baseSequenceStreamOutput::write(const outputBuffers_t& buffers)
+{
+    IMEBRA_FUNCTION_START();
+
+    for(const outputBuffer& writeBuffer: buffers)
+    {
+        write(writeBuffer.m_pBuffer, writeBuffer.m_bufferLength);
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void baseSequenceStreamOutput::seekForward(size_t startPosition)
+{
+    IMEBRA_FUNCTION_START();
+
     if(startPosition < m_currentPosition)
     {
         throw std::logic_error("Cannot seek backward while writing to a sequence stream");
@@ -103,9 +149,6 @@ void baseSequenceStreamOutput::write(size_t startPosition, const std::uint8_t* p
             m_currentPosition += writeSize;
         }
     }
-    write(pBuffer, bufferLength);
-
-    m_currentPosition += bufferLength;
 
     IMEBRA_FUNCTION_END();
 }
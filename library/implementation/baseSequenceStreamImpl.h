@@ -78,11 +78,33 @@ class baseSequenceStreamOutput: public baseStreamOutput
 public:
     baseSequenceStreamOutput();
 
+    using baseStreamOutput::write;
+
     virtual void write(size_t startPosition, const std::uint8_t* pBuffer, size_t bufferLength) override;
 
+    virtual void write(size_t startPosition, const outputBuffers_t& buffers) override;
+
     virtual void write(const std::uint8_t* pBuffer, size_t bufferLength) = 0;
 
+    /// \brief Writes several buffers one after the other.
+    ///
+    /// The default implementation calls
+    ///  write(const std::uint8_t*, size_t) for each buffer.
+    ///
+    /// @param buffers the buffers to write
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual void write(const outputBuffers_t& buffers);
+
 private:
+    /// \brief Pads the stream with zeros up to the specified
+    ///        position.
+    ///
+    /// Must be called with m_mutex locked.
+    ///
+    ///////////////////////////////////////////////////////////
+    void seekForward(size_t startPosition);
+
     size_t m_currentPosition;
 
     std::mutex m_mutex;
@@ -17,6 +17,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 */
 
 #include "baseStreamImpl.h"
+#include "memoryImpl.h"
 #include <list>
 
 namespace imebra
@@ -34,10 +35,47 @@ bool baseStreamInput::seekable() const
     return false;
 }
 
+size_t baseStreamInput::getPreferredBufferSize() const
+{
+    return IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE;
+}
+
+std::shared_ptr<const memory> baseStreamInput::getMemoryView(size_t /* startPosition */, size_t /* length */)
+{
+    return nullptr;
+}
+
 baseStreamOutput::~baseStreamOutput()
 {
 }
 
+size_t baseStreamOutput::getPreferredBufferSize() const
+{
+    return IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE;
+}
+
+void baseStreamOutput::write(size_t startPosition, const outputBuffers_t& buffers)
+{
+    IMEBRA_FUNCTION_START();
+
+    for(const outputBuffer& writeBuffer: buffers)
+    {
+        write(startPosition, writeBuffer.m_pBuffer, writeBuffer.m_bufferLength);
+        startPosition += writeBuffer.m_bufferLength;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+void baseStreamOutput::write(size_t startPosition, const std::shared_ptr<const memory>& pMemory)
+{
+    IMEBRA_FUNCTION_START();
+
+    write(startPosition, pMemory->data(), pMemory->size());
+
+    IMEBRA_FUNCTION_END();
+}
+
 
 ///////////////////////////////////////////////////////////
 //
@@ -30,12 +30,28 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <thread>
 #include <condition_variable>
 
+///
+/// \brief Default size of the buffer allocated by the
+///        streamReader and streamWriter objects.
+///
+/// The streams where each read or write operation costs a
+/// system call (files, sockets) ask for a larger buffer:
+/// see baseStreamInput::getPreferredBufferSize() and
+/// baseStreamOutput::getPreferredBufferSize().
+///
+///////////////////////////////////////////////////////////
+#if(!defined IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE)
+    #define IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE 4096
+#endif
+
 namespace imebra
 {
 
 namespace implementation
 {
 
+class memory;
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 /// \brief This class represents an input stream.
@@ -111,6 +127,38 @@ public:
     ///////////////////////////////////////////////////////////
     virtual bool seekable() const;
 
+    ///
+    /// \brief Return the size of the buffer that a
+    ///        streamReader connected to this stream should
+    ///        allocate.
+    ///
+    /// Reads larger than the buffer bypass it and are
+    /// handed directly to the stream.
+    ///
+    /// \return the preferred buffer size, in bytes. The
+    ///         default implementation returns
+    ///         IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual size_t getPreferredBufferSize() const;
+
+    ///
+    /// \brief Return a read only memory object that
+    ///        references the stream's data directly,
+    ///        without copying it.
+    ///
+    /// Streams that keep their whole content addressable
+    /// (e.g. memory mapped files) override this method.
+    ///
+    /// \param startPosition the position of the first byte
+    /// \param length        the number of bytes
+    /// \return a view on the requested bytes, or null if
+    ///         the stream cannot supply it. The default
+    ///         implementation returns null
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual std::shared_ptr<const memory> getMemoryView(size_t startPosition, size_t length);
+
 
 };
 
@@ -147,6 +195,60 @@ public:
     ///////////////////////////////////////////////////////////
     virtual void write(size_t startPosition, const std::uint8_t* pBuffer, size_t bufferLength) = 0;
 
+    /// \brief A buffer to be written by the gather version
+    ///        of write().
+    ///
+    ///////////////////////////////////////////////////////////
+    struct outputBuffer
+    {
+        const std::uint8_t* m_pBuffer;
+        size_t m_bufferLength;
+    };
+
+    typedef std::vector<outputBuffer> outputBuffers_t;
+
+    /// \brief Writes several buffers one after the other
+    ///        into the stream.
+    ///
+    /// The default implementation writes the buffers one by
+    ///  one; streams that support vectored I/O hand all the
+    ///  buffers to the operating system together.
+    ///
+    /// @param startPosition  the position in the file where
+    ///                        the first buffer has to be
+    ///                        written
+    /// @param buffers        the buffers to write
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual void write(size_t startPosition, const outputBuffers_t& buffers);
+
+    /// \brief Writes the content of a memory object into the
+    ///        stream.
+    ///
+    /// The default implementation copies the memory content;
+    ///  streams that collect the written data in memory may
+    ///  keep a reference to the memory object instead.
+    ///  The memory object must not be modified afterwards.
+    ///
+    /// @param startPosition  the position in the file where
+    ///                        the data has to be written
+    /// @param pMemory        the memory to write
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual void write(size_t startPosition, const std::shared_ptr<const memory>& pMemory);
+
+    ///
+    /// \brief Return the size of the buffer that a
+    ///        streamWriter connected to this stream should
+    ///        allocate.
+    ///
+    /// \return the preferred buffer size, in bytes. The
+    ///         default implementation returns
+    ///         IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE
+    ///
+    ///////////////////////////////////////////////////////////
+    virtual size_t getPreferredBufferSize() const;
+
 };
 
 
@@ -78,6 +78,8 @@ namespace implementation
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 buffer::buffer(const std::shared_ptr<const charsetsList_t>& pCharsets, streamController::tByteOrdering endianType):
+    m_bFrozen(false),
+    m_writingHandlers(0),
     m_byteOrdering(endianType),
     m_originalBufferPosition(0),
     m_originalBufferLength(0),
@@ -103,6 +105,8 @@ buffer::buffer(
         size_t wordLength,
         streamController::tByteOrdering endianType,
         const std::shared_ptr<const charsetsList_t>& pCharsets):
+        m_bFrozen(false),
+        m_writingHandlers(0),
         m_byteOrdering(endianType),
         m_originalStream(originalStream),
         m_originalBufferPosition(bufferPosition),
@@ -136,6 +140,18 @@ std::shared_ptr<const memory> buffer::getLocalMemory() const
     ///////////////////////////////////////////////////////////
     if(m_originalStream != nullptr)
     {
+        // Reference the stream's data directly when it doesn't
+        //  need any endian adjustment
+        ///////////////////////////////////////////////////////////
+        if(m_originalWordLength <= 1u || m_byteOrdering == streamController::getPlatformEndian())
+        {
+            std::shared_ptr<const memory> viewMemory(m_originalStream->getMemoryView(m_originalBufferPosition, m_originalBufferLength));
+            if(viewMemory != nullptr && isAligned(viewMemory->data(), m_originalWordLength))
+            {
+                return viewMemory;
+            }
+        }
+
         std::shared_ptr<memory> localMemory(std::make_shared<memory>(m_originalBufferLength));
         if(m_originalBufferLength != 0)
         {
@@ -208,7 +224,7 @@ std::shared_ptr<handlers::readingDataHandler> buffer::getReadingDataHandler(tagV
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     std::shared_ptr<const memory> localMemory(getLocalMemory());
 
@@ -323,6 +339,8 @@ std::shared_ptr<handlers::writingDataHandler> buffer::getWritingDataHandler(tagV
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     // Reset the pointer to the data handler
     ///////////////////////////////////////////////////////////
     std::shared_ptr<handlers::writingDataHandler> handler;
@@ -444,7 +462,7 @@ std::shared_ptr<handlers::writingDataHandler> buffer::getWritingDataHandler(tagV
 ///////////////////////////////////////////////////////////
 bool buffer::hasExternalStream() const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     return m_originalStream != nullptr;
 }
@@ -463,7 +481,7 @@ std::shared_ptr<streamReader> buffer::getStreamReader()
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     // If the object must be loaded from the original stream,
     //  then return the original stream
@@ -520,7 +538,7 @@ std::shared_ptr<handlers::readingDataHandlerRaw> buffer::getReadingDataHandlerRa
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     return std::make_shared<handlers::readingDataHandlerRaw>(getLocalMemory(), tagVR);
 
@@ -534,6 +552,8 @@ std::shared_ptr<handlers::writingDataHandlerRaw> buffer::getWritingDataHandlerRa
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     return std::make_shared<handlers::writingDataHandlerRaw>(shared_from_this(), size, tagVR);
 
     IMEBRA_FUNCTION_END();
@@ -587,6 +607,8 @@ void buffer::appendMemory(std::shared_ptr<const memory> pMemory)
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     m_memory.push_back(pMemory);
 
     IMEBRA_FUNCTION_END();
@@ -604,7 +626,7 @@ size_t buffer::getBufferSizeBytes() const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     // The buffer has not been loaded yet
     ///////////////////////////////////////////////////////////
@@ -638,12 +660,20 @@ streamController::tByteOrdering buffer::getEndianType() const
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-void buffer::commit(std::shared_ptr<memory> newMemory)
+void buffer::commit(std::shared_ptr<const memory> newMemory)
 {
     IMEBRA_FUNCTION_START();
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    // The readers of a frozen buffer don't lock it: keep
+    //  the frozen content
+    ///////////////////////////////////////////////////////////
+    if(m_bFrozen)
+    {
+        return;
+    }
+
     m_memory.clear();
     m_memory.push_back(newMemory);
     m_originalStream.reset();
@@ -652,6 +682,115 @@ void buffer::commit(std::shared_ptr<memory> newMemory)
 }
 
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Make the buffer immutable. The appended memory blocks
+//  are joined so the readers don't join them every time
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void buffer::freeze()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_bFrozen)
+    {
+        return;
+    }
+
+    // The data written by the handler would be discarded
+    ///////////////////////////////////////////////////////////
+    if(m_writingHandlers != 0)
+    {
+        IMEBRA_THROW(DataSetFrozenError, "The buffer cannot be frozen while a writing handler is in use");
+    }
+
+    if(m_memory.size() > 1)
+    {
+        std::shared_ptr<const memory> joinedMemory(joinMemory());
+        m_memory.clear();
+        m_memory.push_back(joinedMemory);
+    }
+
+    m_bFrozen = true;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Count the writing handlers. The count is incremented
+//  while getWritingDataHandler() holds the lock, so
+//  freeze() sees all the handlers obtained before it
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void buffer::addWritingHandler()
+{
+    ++m_writingHandlers;
+}
+
+void buffer::removeWritingHandler()
+{
+    --m_writingHandlers;
+}
+
+bool buffer::hasWritingHandlers() const
+{
+    return m_writingHandlers != 0;
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Lock the buffer, unless it is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::unique_lock<std::mutex> buffer::lockUnlessFrozen() const
+{
+    if(m_bFrozen)
+    {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(m_mutex);
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Throw if the buffer is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void buffer::throwIfFrozen() const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_bFrozen)
+    {
+        IMEBRA_THROW(DataSetFrozenError, "The buffer belongs to a frozen dataset and cannot be modified");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 } // namespace implementation
 
 } // namespace imebra
@@ -25,6 +25,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "../include/imebra/definitions.h"
 
 #include <mutex>
+#include <atomic>
 
 namespace imebra
 {
@@ -245,7 +246,45 @@ public:
 
     //@}
 
-    void commit(std::shared_ptr<memory> newMemory);
+    /// \brief Commit the memory written by a writing data
+    ///         handler.
+    ///
+    /// If the buffer has been frozen then the new memory is
+    ///  discarded: this function is called by the writing
+    ///  handlers' destructors and cannot throw.
+    ///
+    /// @param newMemory the memory that replaces the buffer's
+    ///                   content
+    ///
+    ///////////////////////////////////////////////////////////
+    void commit(std::shared_ptr<const memory> newMemory);
+
+    /// \brief Make the buffer immutable.
+    ///
+    /// After this call the reading functions don't lock the
+    ///  buffer anymore, while the writing handlers and
+    ///  appendMemory() throw DataSetFrozenError.
+    ///
+    /// Throws DataSetFrozenError if a writing handler
+    ///  obtained from the buffer has not been released yet.
+    ///
+    ///////////////////////////////////////////////////////////
+    void freeze();
+
+    /// \brief Called by the writing handlers when they are
+    ///         created and when they are destroyed.
+    ///
+    /// The handlers' count is checked by freeze().
+    ///
+    ///////////////////////////////////////////////////////////
+    void addWritingHandler();
+    void removeWritingHandler();
+
+    /// \brief Return true if a writing handler obtained from
+    ///         the buffer has not been released yet.
+    ///
+    ///////////////////////////////////////////////////////////
+    bool hasWritingHandlers() const;
 
 protected:
 
@@ -270,6 +309,20 @@ protected:
     ///////////////////////////////////////////////////////////
     std::shared_ptr<const memory> joinMemory() const;
 
+    /// \brief Lock the buffer, unless it has been frozen.
+    ///
+    /// @return a lock on m_mutex, or an empty lock if the
+    ///         buffer is frozen
+    ///
+    ///////////////////////////////////////////////////////////
+    std::unique_lock<std::mutex> lockUnlessFrozen() const;
+
+    /// \brief Throw DataSetFrozenError if the buffer has been
+    ///         frozen.
+    ///
+    ///////////////////////////////////////////////////////////
+    void throwIfFrozen() const;
+
     //
     // Attributes
     //
@@ -281,6 +334,14 @@ private:
 
     mutable std::mutex m_mutex;
 
+    // Set by freeze(): the buffer doesn't change anymore
+    ///////////////////////////////////////////////////////////
+    std::atomic<bool> m_bFrozen;
+
+    // Number of writing handlers not released yet
+    ///////////////////////////////////////////////////////////
+    std::atomic<std::uint32_t> m_writingHandlers;
+
     streamController::tByteOrdering m_byteOrdering; // < Byte ordering in the stream or memory
 
 protected:
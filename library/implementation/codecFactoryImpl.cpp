@@ -192,7 +192,7 @@ std::shared_ptr<codecFactory> codecFactory::getCodecFactory()
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-std::shared_ptr<dataSet> codecFactory::load(std::shared_ptr<streamReader> pStream, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */)
+std::shared_ptr<dataSet> codecFactory::load(std::shared_ptr<streamReader> pStream, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */, std::shared_ptr<const tagsFilter> pFilter /* = nullptr */)
 {
     IMEBRA_FUNCTION_START();
 
@@ -206,6 +206,14 @@ std::shared_ptr<dataSet> codecFactory::load(std::shared_ptr<streamReader> pStrea
         IMEBRA_THROW(std::logic_error, "The codec factory supports only file and memory streams")
     }
 
+    // When only the first tags are loaded then the stream is
+    //  read in small blocks
+    ///////////////////////////////////////////////////////////
+    if(pFilter != nullptr)
+    {
+        pStream->setBufferSize(IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE);
+    }
+
     std::uint8_t buffer[IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE];
 
     size_t startPosition = pStream->position();
@@ -233,9 +241,14 @@ std::shared_ptr<dataSet> codecFactory::load(std::shared_ptr<streamReader> pStrea
                                                          bufferSize);
         }
 
+        if(pFilter != nullptr)
+        {
+            pTempReader->setBufferSize(IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE);
+        }
+
         try
         {
-            std::shared_ptr<dataSet> pDataSet(scanCodecs->second->read(pTempReader, maxSizeBufferLoad));
+            std::shared_ptr<dataSet> pDataSet(scanCodecs->second->read(pTempReader, maxSizeBufferLoad, pFilter));
             return pDataSet;
         }
         catch(CodecWrongFormatError&)
@@ -48,6 +48,8 @@ namespace codecs
 
 class streamCodec;
 
+class tagsFilter;
+
 class imageCodec;
 
 ///////////////////////////////////////////////////////////
@@ -147,11 +149,16 @@ public:
 	///                 ignore this parameter.
 	///                Set to 0xffffffff to load all the 
 	///                 buffers immediatly
+    /// @param pFilter selects the tags to load. When it is
+    ///                 set the stream is read in small blocks,
+    ///                 so the data after the filter's last tag
+    ///                 is not read. Some codecs may ignore
+    ///                 this parameter
 	/// @return a pointer to the dataSet containing the parsed
 	///          data
 	///
 	///////////////////////////////////////////////////////////
-	std::shared_ptr<dataSet> load(std::shared_ptr<streamReader> pStream, std::uint32_t maxSizeBufferLoad = 0xffffffff);
+	std::shared_ptr<dataSet> load(std::shared_ptr<streamReader> pStream, std::uint32_t maxSizeBufferLoad = 0xffffffff, std::shared_ptr<const tagsFilter> pFilter = nullptr);
 
     /// \brief Set the maximum size of the images created by
     ///         the codec::getImage() function.
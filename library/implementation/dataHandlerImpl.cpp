@@ -19,6 +19,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "../include/imebra/exceptions.h"
 #include "exceptionImpl.h"
 #include "dataHandlerImpl.h"
+#include "bufferImpl.h"
 #include "memoryImpl.h"
 #include "dicomDictImpl.h"
 #include "dateImpl.h"
@@ -104,10 +105,20 @@ std::shared_ptr<unicodePatientName> readingDataHandler::getUnicodePatientName(co
 writingDataHandler::writingDataHandler(const std::shared_ptr<buffer> &pBuffer, tagVR_t dataType):
     m_dataType(dataType), m_buffer(pBuffer)
 {
+    if(m_buffer != nullptr)
+    {
+        m_buffer->addWritingHandler();
+    }
 }
 
 writingDataHandler::~writingDataHandler()
 {
+    // The derived classes have already committed the data
+    ///////////////////////////////////////////////////////////
+    if(m_buffer != nullptr)
+    {
+        m_buffer->removeWritingHandler();
+    }
 }
 
 ///////////////////////////////////////////////////////////
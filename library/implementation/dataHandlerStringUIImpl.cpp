@@ -108,7 +108,7 @@ std::string normalizeUid(const std::string& uid)
 ///////////////////////////////////////////////////////////
 
 readingDataHandlerStringUI::readingDataHandlerStringUI(const memory& parseMemory):
-    readingDataHandlerString(parseMemory, tagVR_t::UI, 0x0, 0x0)
+    readingDataHandlerString(parseMemory, tagVR_t::UI, '\\', 0x0)
 {
 }
 
@@ -150,7 +150,7 @@ double readingDataHandlerStringUI::getDouble(const size_t index) const
 
 
 writingDataHandlerStringUI::writingDataHandlerStringUI(const std::shared_ptr<buffer> &pBuffer):
-    writingDataHandlerString(pBuffer, tagVR_t::UI, 0x0, 0, 64)
+    writingDataHandlerString(pBuffer, tagVR_t::UI, '\\', 0, 64)
 {
 }
 
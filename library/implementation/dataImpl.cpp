@@ -60,7 +60,7 @@ namespace implementation
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 data::data(tagVR_t tagVR, const std::shared_ptr<charsetsList_t> pCharsets):
-    m_pCharsetsList(pCharsets), m_tagVR(tagVR)
+    m_pCharsetsList(pCharsets), m_tagVR(tagVR), m_bFrozen(false)
 {
 }
 
@@ -94,6 +94,8 @@ void data::setBuffer(size_t bufferId, const std::shared_ptr<buffer>& newBuffer)
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     // Assign the new buffer
     ///////////////////////////////////////////////////////////
     if(bufferId >= m_buffers.size())
@@ -135,7 +137,7 @@ size_t data::getBuffersCount() const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     // Returns the number of buffers
     ///////////////////////////////////////////////////////////
@@ -156,7 +158,7 @@ size_t data::getBuffersCount() const
 ///////////////////////////////////////////////////////////
 bool data::bufferExists(size_t bufferId) const
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     return bufferId < m_buffers.size() && m_buffers.at(bufferId) != nullptr;
 }
@@ -185,7 +187,7 @@ std::shared_ptr<buffer> data::getBuffer(size_t bufferId) const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     // Retrieve the buffer
     ///////////////////////////////////////////////////////////
@@ -206,6 +208,8 @@ std::shared_ptr<buffer> data::getBufferCreate(size_t bufferId)
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     // Retrieve the buffer
     ///////////////////////////////////////////////////////////
     if(bufferId < m_buffers.size() && m_buffers.at(bufferId) != nullptr)
@@ -232,6 +236,8 @@ std::shared_ptr<buffer> data::getBufferCreate(size_t bufferId, streamController:
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     // Retrieve the buffer
     ///////////////////////////////////////////////////////////
     if(bufferId < m_buffers.size() && m_buffers.at(bufferId) != nullptr)
@@ -263,6 +269,8 @@ std::shared_ptr<buffer> data::getBufferCreate(size_t bufferId,
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     std::shared_ptr<buffer> pNewBuffer(std::make_shared<buffer>(originalStream,
                                                                 bufferPosition,
                                                                 bufferLength,
@@ -558,7 +566,7 @@ std::shared_ptr<dataSet> data::getSequenceItem(size_t dataSetId) const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     if(m_embeddedDataSets.size() <= dataSetId)
     {
@@ -574,7 +582,7 @@ bool data::dataSetExists(size_t dataSetId) const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::mutex> lock(m_mutex);
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
 
     return m_embeddedDataSets.size() > dataSetId;
 
@@ -597,6 +605,8 @@ std::shared_ptr<dataSet> data::appendSequenceItem()
 
     std::lock_guard<std::mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     std::shared_ptr<dataSet> pDataSet(std::make_shared<dataSet>(m_pCharsetsList));
     m_embeddedDataSets.push_back(pDataSet);
 
@@ -606,6 +616,115 @@ std::shared_ptr<dataSet> data::appendSequenceItem()
 }
 
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Freeze the buffers and the embedded datasets, then the
+//  tag
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void data::freeze()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(m_bFrozen)
+    {
+        return;
+    }
+
+    for(const std::shared_ptr<buffer>& pBuffer: m_buffers)
+    {
+        if(pBuffer != nullptr)
+        {
+            pBuffer->freeze();
+        }
+    }
+
+    for(const std::shared_ptr<dataSet>& pDataSet: m_embeddedDataSets)
+    {
+        pDataSet->freeze();
+    }
+
+    m_bFrozen = true;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+bool data::hasWritingHandlers() const
+{
+    IMEBRA_FUNCTION_START();
+
+    std::unique_lock<std::mutex> lock(lockUnlessFrozen());
+
+    for(const std::shared_ptr<buffer>& pBuffer: m_buffers)
+    {
+        if(pBuffer != nullptr && pBuffer->hasWritingHandlers())
+        {
+            return true;
+        }
+    }
+
+    for(const std::shared_ptr<dataSet>& pDataSet: m_embeddedDataSets)
+    {
+        if(pDataSet->hasWritingHandlers())
+        {
+            return true;
+        }
+    }
+
+    return false;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Lock the tag, unless it is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::unique_lock<std::mutex> data::lockUnlessFrozen() const
+{
+    if(m_bFrozen)
+    {
+        return std::unique_lock<std::mutex>();
+    }
+    return std::unique_lock<std::mutex>(m_mutex);
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Throw if the tag is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void data::throwIfFrozen() const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_bFrozen)
+    {
+        IMEBRA_THROW(DataSetFrozenError, "The tag belongs to a frozen dataset and cannot be modified");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 } // namespace implementation
 
 } // namespace imebra
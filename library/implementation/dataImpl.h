@@ -28,6 +28,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <map>
 #include <vector>
 #include <mutex>
+#include <atomic>
 
 namespace imebra
 {
@@ -340,6 +341,32 @@ public:
     ///////////////////////////////////////////////////////////
     void setBuffer(size_t bufferId, const std::shared_ptr<buffer>& newBuffer);
 
+    /// \brief Make the tag, its buffers and its embedded
+    ///         datasets immutable.
+    ///
+    /// After this call the reading functions don't lock the
+    ///  tag anymore, while the functions that create buffers
+    ///  or sequence items throw DataSetFrozenError.
+    ///
+    ///////////////////////////////////////////////////////////
+    void freeze();
+
+    /// \brief Return true if a writing handler obtained from
+    ///         the tag's buffers or from its embedded datasets
+    ///         has not been released yet.
+    ///
+    ///////////////////////////////////////////////////////////
+    bool hasWritingHandlers() const;
+
+private:
+    // Lock the tag, unless it is frozen
+    ///////////////////////////////////////////////////////////
+    std::unique_lock<std::mutex> lockUnlessFrozen() const;
+
+    // Throw DataSetFrozenError if the tag is frozen
+    ///////////////////////////////////////////////////////////
+    void throwIfFrozen() const;
+
 protected:
 
     const std::shared_ptr<charsetsList_t> m_pCharsetsList;
@@ -358,6 +385,10 @@ protected:
     tEmbeddedDatasetsVector m_embeddedDataSets;
 
     mutable std::mutex m_mutex;
+
+    // Set by freeze(): the tag doesn't change anymore
+    ///////////////////////////////////////////////////////////
+    std::atomic<bool> m_bFrozen;
 };
 
 /// @}
@@ -38,10 +38,13 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "VOIDescriptionImpl.h"
 #include "overlayImpl.h"
 #include "dicomNativeImageCodecImpl.h"
+#include "dicomStreamCodecImpl.h"
 #include "codecFactoryImpl.h"
+#include "baseStreamImpl.h"
 #include <iostream>
 #include <string.h>
 #include <limits>
+#include <algorithm>
 
 
 namespace imebra
@@ -50,6 +53,28 @@ namespace imebra
 namespace implementation
 {
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Order of the tags in the dataSet's skeleton
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+static bool skeletonTagLess(const skeletonTag& left, const skeletonTag& right)
+{
+    if(left.groupId != right.groupId)
+    {
+        return left.groupId < right.groupId;
+    }
+    if(left.order != right.order)
+    {
+        return left.order < right.order;
+    }
+    return left.tagId < right.tagId;
+}
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
@@ -64,18 +89,19 @@ namespace implementation
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 
-dataSet::dataSet(const std::shared_ptr<charsetsList_t>& pCharsetsList): m_itemOffset(0), m_pCharsetsList(pCharsetsList)
+dataSet::dataSet(const std::shared_ptr<charsetsList_t>& pCharsetsList):
+    m_itemOffset(0), m_bSkeletonSorted(true), m_skeletonMaxSizeBufferLoad(0xffffffff), m_pCharsetsList(pCharsetsList), m_bFrozen(false)
 {
 }
 
 dataSet::dataSet(const std::string& transferSyntax, const std::shared_ptr<charsetsList_t>& pCharsetsList):
-    m_itemOffset(0), m_pCharsetsList(pCharsetsList)
+    m_itemOffset(0), m_bSkeletonSorted(true), m_skeletonMaxSizeBufferLoad(0xffffffff), m_pCharsetsList(pCharsetsList), m_bFrozen(false)
 {
     setString(0x0002, 0x0, 0x0010, 0, transferSyntax);
 }
 
 dataSet::dataSet(const std::string& transferSyntax, const charsetsList_t& charsetsList):
-    m_itemOffset(0), m_pCharsetsList(std::make_shared<charsetsList_t>(charsetsList))
+    m_itemOffset(0), m_bSkeletonSorted(true), m_skeletonMaxSizeBufferLoad(0xffffffff), m_pCharsetsList(std::make_shared<charsetsList_t>(charsetsList)), m_bFrozen(false)
 {
     setString(0x0002, 0x0, 0x0010, 0, transferSyntax);
 
@@ -104,26 +130,23 @@ std::shared_ptr<data> dataSet::getTag(std::uint16_t groupId, std::uint32_t order
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
-    tGroups::const_iterator findGroup(m_groups.find(groupId));
-    if(findGroup == m_groups.end())
-    {
-        IMEBRA_THROW(MissingGroupError, "The requested group is missing");
-    }
+    loadSkeletonTag(groupId, order, tagId);
 
-    if(findGroup->second.size() <= order)
+    const std::uint64_t key(getTagKey(groupId, order, tagId));
+    tTagsVector::const_iterator findTag(findTagKey(key));
+    if(findTag != m_tags.end() && findTag->key == key)
     {
-        IMEBRA_THROW(MissingGroupError, "The requested group is missing");
+        return findTag->pData;
     }
 
-    const tTags& tagsMap = findGroup->second.at(order);
-    tTags::const_iterator findTag(tagsMap.find(tagId));
-    if(findTag == tagsMap.end())
+    tTagsVector::const_iterator findGroup(findTagKey(getTagKey(groupId, order, 0)));
+    if(findGroup == m_tags.end() || (findGroup->key >> 16) != (key >> 16))
     {
-        IMEBRA_THROW(MissingTagError, "The requested tag is missing");
+        IMEBRA_THROW(MissingGroupError, "The requested group is missing");
     }
-    return findTag->second;
+    IMEBRA_THROW(MissingTagError, "The requested tag is missing");
 
     IMEBRA_FUNCTION_END();
 }
@@ -135,17 +158,27 @@ std::shared_ptr<data> dataSet::getTagCreate(std::uint16_t groupId, std::uint32_t
 
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
-    if(m_groups[groupId].size() <= order)
+    throwIfFrozen();
+
+    loadSkeletonTag(groupId, order, tagId);
+
+    const std::uint64_t key(getTagKey(groupId, order, tagId));
+
+    // The codecs create the tags in ascending order: append
+    //  them without searching
+    ///////////////////////////////////////////////////////////
+    if(m_tags.empty() || m_tags.back().key < key)
     {
-        m_groups[groupId].resize(order + 1);
+        m_tags.push_back(taggedData{key, std::make_shared<data>(tagVR, m_pCharsetsList)});
+        return m_tags.back().pData;
     }
 
-    if(m_groups[groupId][order][tagId] == nullptr)
+    tTagsVector::iterator findTag(m_tags.begin() + (findTagKey(key) - m_tags.cbegin()));
+    if(findTag->key != key)
     {
-        m_groups[groupId][order][tagId] = std::make_shared<data>(tagVR, m_pCharsetsList);
+        findTag = m_tags.insert(findTag, taggedData{key, std::make_shared<data>(tagVR, m_pCharsetsList)});
     }
-
-    return m_groups[groupId][order][tagId];
+    return findTag->pData;
 
     IMEBRA_FUNCTION_END();
 }
@@ -189,7 +222,7 @@ std::shared_ptr<image> dataSet::getImage(std::uint32_t frameNumber) const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
     // Retrieve the transfer syntax
     ///////////////////////////////////////////////////////////
@@ -398,7 +431,7 @@ std::shared_ptr<image> dataSet::getModalityImage(std::uint32_t frameNumber) cons
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
     std::shared_ptr<image> originalImage = getImage(frameNumber);
 
@@ -481,6 +514,8 @@ void dataSet::setImage(std::uint32_t frameNumber, std::shared_ptr<image> pImage,
 
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     // bDontChangeAttributes is true if some images already
     //  exist in the dataset and we must save the new image
     //  using the attributes already stored
@@ -973,7 +1008,7 @@ size_t dataSet::getFrameBufferIds(std::uint32_t frameNumber, std::uint32_t* pFir
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
     try
     {
@@ -1091,7 +1126,7 @@ std::shared_ptr<lut> dataSet::getLut(std::uint16_t groupId, std::uint16_t tagId,
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
     std::shared_ptr<dataSet> embeddedLUT = getSequenceItem(groupId, 0, tagId, lutId);
     std::shared_ptr<handlers::readingDataHandlerNumericBase> descriptorHandle = embeddedLUT->getReadingDataHandlerNumeric(0x0028, 0x0, 0x3002, 0x0);
@@ -1869,8 +1904,6 @@ tagVR_t dataSet::getDataType(std::uint16_t groupId, std::uint32_t order, std::ui
 ///////////////////////////////////////////////////////////
 void dataSet::setItemOffset(std::uint32_t offset)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-
     m_itemOffset = offset;
 }
 
@@ -1886,8 +1919,6 @@ void dataSet::setItemOffset(std::uint32_t offset)
 ///////////////////////////////////////////////////////////
 std::uint32_t dataSet::getItemOffset() const
 {
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-
     return m_itemOffset;
 }
 
@@ -1895,13 +1926,15 @@ dataSet::tGroupsIds dataSet::getGroups() const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
+
+    loadSkeleton();
 
     dataSet::tGroupsIds groups;
 
-    for(tGroups::const_iterator scanGroups(m_groups.begin()), endGroups(m_groups.end()); scanGroups != endGroups; ++scanGroups)
+    for(const taggedData& tag: m_tags)
     {
-        groups.insert(scanGroups->first);
+        groups.insert(groups.end(), (std::uint16_t)(tag.key >> 48));
     }
 
     return groups;
@@ -1913,50 +1946,450 @@ std::uint32_t dataSet::getGroupsNumber(uint16_t groupId) const
 {
     IMEBRA_FUNCTION_START();
 
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
 
-    dataSet::tGroups::const_iterator findGroup(m_groups.find(groupId));
+    loadSkeleton();
 
-    if(findGroup == m_groups.end())
+    // The last tag of the group has the highest order
+    ///////////////////////////////////////////////////////////
+    const std::uint64_t lastKey(getTagKey(groupId, 0xffffffff, 0xffff));
+    tTagsVector::const_iterator findNextGroup(findTagKey(lastKey));
+    if(findNextGroup != m_tags.end() && findNextGroup->key == lastKey)
+    {
+        ++findNextGroup;
+    }
+
+    if(findNextGroup == m_tags.begin() || ((findNextGroup - 1)->key >> 48) != groupId)
     {
         return 0;
     }
 
-    return static_cast<std::uint32_t>(findGroup->second.size());
+    return (std::uint32_t)(((findNextGroup - 1)->key >> 16) & 0xffffffff) + 1;
+
+    IMEBRA_FUNCTION_END();
+}
+
+dataSet::tTags dataSet::getGroupTags(std::uint16_t groupId, size_t groupOrder) const
+{
+    IMEBRA_FUNCTION_START();
+
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
+
+    loadSkeleton();
+
+    const std::uint64_t groupKey(getTagKey(groupId, (std::uint32_t)groupOrder, 0) >> 16);
+
+    dataSet::tTags tags;
+    for(tTagsVector::const_iterator scanTags(findTagKey(groupKey << 16)); scanTags != m_tags.end() && (scanTags->key >> 16) == groupKey; ++scanTags)
+    {
+        tags.emplace_back((std::uint16_t)(scanTags->key & 0xffff), scanTags->pData);
+    }
+
+    return tags;
 
     IMEBRA_FUNCTION_END();
 }
 
-const dataSet::tTags& dataSet::getGroupTags(std::uint16_t groupId, size_t groupOrder) const
+void dataSet::forEachGroup(const tGroupVisitor& visitor) const
 {
     IMEBRA_FUNCTION_START();
 
-    static const dataSet::tTags emptyTags;
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
+
+    loadSkeleton();
+
+    // The tags of a group share the group id and order in
+    //  the most significant bits of the key
+    ///////////////////////////////////////////////////////////
+    for(tTagsVector::const_iterator scanTags(m_tags.begin()), endTags(m_tags.end()); scanTags != endTags; )
+    {
+        const std::uint64_t groupKey(scanTags->key >> 16);
+        tTagsVector::const_iterator endGroup(scanTags + 1);
+        while(endGroup != endTags && (endGroup->key >> 16) == groupKey)
+        {
+            ++endGroup;
+        }
+        visitor((std::uint16_t)(groupKey >> 32), scanTags, endGroup);
+        scanTags = endGroup;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Build the key used to sort the tags
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::uint64_t dataSet::getTagKey(std::uint16_t groupId, std::uint32_t order, std::uint16_t tagId)
+{
+    return ((std::uint64_t)groupId << 48) | ((std::uint64_t)order << 16) | (std::uint64_t)tagId;
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Binary search of a tag's key
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+dataSet::tTagsVector::const_iterator dataSet::findTagKey(std::uint64_t key) const
+{
+    return std::lower_bound(m_tags.begin(), m_tags.end(), key, [](const taggedData& tag, std::uint64_t findKey)
+    {
+        return tag.key < findKey;
+    });
+}
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Record a tag skipped by the codec
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::addSkeletonTag(const std::shared_ptr<baseStreamInput>& pStream, std::uint32_t maxSizeBufferLoad, const skeletonTag& tag)
+{
+    IMEBRA_FUNCTION_START();
 
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
-    tGroups::const_iterator findGroup(m_groups.find(groupId));
-    if(findGroup == m_groups.end() || findGroup->second.size() <= groupOrder)
+    throwIfFrozen();
+
+    if(m_pSkeletonStream != pStream)
     {
-        return emptyTags;
+        m_pSkeletonStream = pStream;
     }
+    m_skeletonMaxSizeBufferLoad = maxSizeBufferLoad;
 
-    return findGroup->second.at(groupOrder);
+    if(!m_skeleton.empty() && !skeletonTagLess(m_skeleton.back(), tag))
+    {
+        m_bSkeletonSorted = false;
+    }
+    m_skeleton.push_back(tag);
 
     IMEBRA_FUNCTION_END();
 }
 
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Create the skipped tag, if it is in the skeleton
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::loadSkeletonTag(std::uint16_t groupId, std::uint32_t order, std::uint16_t tagId) const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_skeleton.empty())
+    {
+        return;
+    }
+
+    // Duplicate tags are sorted by their position in the
+    //  stream: the last one wins, as when the tags are loaded
+    ///////////////////////////////////////////////////////////
+    if(!m_bSkeletonSorted)
+    {
+        std::stable_sort(m_skeleton.begin(), m_skeleton.end(), skeletonTagLess);
+        m_bSkeletonSorted = true;
+    }
+
+    skeletonTag findTag;
+    findTag.groupId = groupId;
+    findTag.order = order;
+    findTag.tagId = tagId;
+    std::pair<std::vector<skeletonTag>::iterator, std::vector<skeletonTag>::iterator> range(
+                std::equal_range(m_skeleton.begin(), m_skeleton.end(), findTag, skeletonTagLess));
+    if(range.first == range.second)
+    {
+        return;
+    }
+
+    // Remove the tag from the skeleton before creating it:
+    //  parsing a sequence may look for the same tag again.
+    // If the tag cannot be created then its entry is put
+    //  back, so the error is reported again on the next access
+    ///////////////////////////////////////////////////////////
+    const skeletonTag tag(*(range.second - 1));
+    m_skeleton.erase(range.first, range.second);
+
+    try
+    {
+        createSkeletonTag(tag);
+    }
+    catch(...)
+    {
+        m_skeleton.insert(std::upper_bound(m_skeleton.begin(), m_skeleton.end(), tag, skeletonTagLess), tag);
+        throw;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Create all the skipped tags
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::loadSkeleton() const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_skeleton.empty())
+    {
+        return;
+    }
+
+    if(!m_bSkeletonSorted)
+    {
+        std::stable_sort(m_skeleton.begin(), m_skeleton.end(), skeletonTagLess);
+        m_bSkeletonSorted = true;
+    }
+
+    // Create the tags in ascending order, so they are
+    //  appended to the sorted tags. The skeleton is emptied
+    //  first: parsing a sequence may look for the same tag
+    //  again
+    ///////////////////////////////////////////////////////////
+    std::vector<skeletonTag> skeleton;
+    skeleton.swap(m_skeleton);
+
+    for(std::vector<skeletonTag>::const_iterator scanTags(skeleton.begin()), endTags(skeleton.end()); scanTags != endTags; ++scanTags)
+    {
+        // Duplicate tags: the last one wins
+        ///////////////////////////////////////////////////////////
+        if(scanTags + 1 != endTags && !skeletonTagLess(*scanTags, *(scanTags + 1)))
+        {
+            continue;
+        }
+        try
+        {
+            createSkeletonTag(*scanTags);
+        }
+        catch(...)
+        {
+            // Keep the tags not created yet, the failed one
+            //  included
+            ///////////////////////////////////////////////////////////
+            m_bSkeletonSorted = m_skeleton.empty();
+            m_skeleton.insert(m_skeleton.end(), scanTags, endTags);
+            throw;
+        }
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Create a skipped tag: the buffers are loaded on demand,
+//  the sequences are parsed immediately
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::createSkeletonTag(const skeletonTag& tag) const
+{
+    IMEBRA_FUNCTION_START();
+
+    // Loading the skeleton doesn't change the dataset's
+    //  content
+    ///////////////////////////////////////////////////////////
+    dataSet* pThis(const_cast<dataSet*>(this));
+
+    std::shared_ptr<data> pTag(pThis->getTagCreate(tag.groupId, tag.order, tag.tagId, tag.tagVR));
+
+    try
+    {
+        if(tag.tagVR == tagVR_t::SQ)
+        {
+            if(tag.length == 0)
+            {
+                return;
+            }
+
+            std::shared_ptr<streamReader> pReader(std::make_shared<streamReader>(m_pSkeletonStream, tag.position, tag.length));
+            codecs::dicomStreamCodec::parseSequence(
+                        pReader,
+                        pThis->shared_from_this(),
+                        tag.groupId,
+                        (std::uint16_t)tag.order,
+                        tag.tagId,
+                        tag.tagVR,
+                        tag.length,
+                        tag.bExplicitDataType,
+                        tag.endianType,
+                        tag.wordSize,
+                        m_skeletonMaxSizeBufferLoad,
+                        tag.depth);
+            return;
+        }
+
+        pTag->getBufferCreate(0, m_pSkeletonStream, tag.position, tag.length, tag.wordSize, tag.endianType);
+    }
+    catch(...)
+    {
+        // Remove the partially created tag: the caller keeps
+        //  its skeleton entry
+        ///////////////////////////////////////////////////////////
+        const std::uint64_t key(getTagKey(tag.groupId, tag.order, tag.tagId));
+        tTagsVector::const_iterator findTag(findTagKey(key));
+        if(findTag != m_tags.end() && findTag->key == key)
+        {
+            pThis->m_tags.erase(findTag);
+        }
+        throw;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 void dataSet::setCharsetsList(const charsetsList_t& charsets)
 {
     IMEBRA_FUNCTION_START();
 
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 
+    throwIfFrozen();
+
     *m_pCharsetsList = charsets;
 
     IMEBRA_FUNCTION_END();
 }
 
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Create the skipped tags and freeze them, then freeze
+//  the dataset
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::freeze()
+{
+    IMEBRA_FUNCTION_START();
+
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+
+    if(m_bFrozen)
+    {
+        return;
+    }
+
+    loadSkeleton();
+
+    // Checked before freezing anything, so a failure leaves
+    //  the dataset unchanged
+    ///////////////////////////////////////////////////////////
+    if(hasWritingHandlers())
+    {
+        IMEBRA_THROW(DataSetFrozenError, "The dataset cannot be frozen while a writing handler is in use");
+    }
+
+    for(const taggedData& tag: m_tags)
+    {
+        tag.pData->freeze();
+    }
+
+    m_bFrozen = true;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+bool dataSet::hasWritingHandlers() const
+{
+    IMEBRA_FUNCTION_START();
+
+    std::unique_lock<std::recursive_mutex> lock(lockUnlessFrozen());
+
+    for(const taggedData& tag: m_tags)
+    {
+        if(tag.pData->hasWritingHandlers())
+        {
+            return true;
+        }
+    }
+
+    return false;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+bool dataSet::isFrozen() const
+{
+    return m_bFrozen;
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Lock the dataset, unless it is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::unique_lock<std::recursive_mutex> dataSet::lockUnlessFrozen() const
+{
+    if(m_bFrozen)
+    {
+        return std::unique_lock<std::recursive_mutex>();
+    }
+    return std::unique_lock<std::recursive_mutex>(m_mutex);
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Throw if the dataset is frozen
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void dataSet::throwIfFrozen() const
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_bFrozen)
+    {
+        IMEBRA_THROW(DataSetFrozenError, "The dataset is frozen and cannot be modified");
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
 } // namespace implementation
 
 } // namespace imebra
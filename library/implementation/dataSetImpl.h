@@ -22,11 +22,14 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "exceptionImpl.h"
 #include "streamCodecImpl.h"
 #include "dataImpl.h"
+#include "streamControllerImpl.h"
 #include <vector>
 #include <memory>
 #include <set>
 #include <map>
 #include <mutex>
+#include <atomic>
+#include <functional>
 
 
 namespace imebra
@@ -44,6 +47,7 @@ class VOIDescription;
 class streamReader;
 class streamWriter;
 class overlay;
+class baseStreamInput;
 
 /// \addtogroup group_dataset Dicom data
 /// \brief The Dicom dataset is represented by the
@@ -53,6 +57,28 @@ class overlay;
 
 
 
+///////////////////////////////////////////////////////////
+/// \brief Position and type of a tag that has been parsed
+///         but not loaded yet.
+///
+/// See dataSet::addSkeletonTag().
+///
+///////////////////////////////////////////////////////////
+struct skeletonTag
+{
+    std::uint16_t groupId;
+    std::uint16_t tagId;
+    std::uint32_t order;
+    tagVR_t tagVR;
+    std::uint32_t length;
+    size_t position;        ///< position in the original stream
+    std::uint16_t depth;    ///< depth of the dataset (sequences)
+    std::uint8_t wordSize;
+    bool bExplicitDataType; ///< used to parse the sequences
+    streamController::tByteOrdering endianType;
+};
+
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 /// \brief A data set is a collection of groups of tags
@@ -886,6 +912,9 @@ public:
     ///        Tells the dataSet the position at which it has
     ///         been written into the stream
     ///
+    /// The offset is not part of the dataset's content and
+    ///  can be set also when the dataset is frozen.
+    ///
     /// @param offset   the position at which the dataSet has
     ///                  been written into the stream
     ///
@@ -903,9 +932,31 @@ public:
 
     //@}
 
-    typedef std::map<std::uint16_t, std::shared_ptr<data> > tTags;
-    typedef std::vector<tTags> tGroupsList;
-    typedef std::map<std::uint16_t, tGroupsList> tGroups;
+    /// \brief Called by codecs::dicomStreamCodec to record
+    ///         a tag that has been skipped while parsing the
+    ///         stream.
+    ///
+    /// The tag is created the first time it is accessed: its
+    ///  buffer is then loaded on demand from the original
+    ///  stream, while sequences are parsed when the tag is
+    ///  created.
+    /// Functions that enumerate the groups create all the
+    ///  recorded tags.
+    ///
+    /// @param pStream  the stream from which the tag can be
+    ///                  loaded
+    /// @param maxSizeBufferLoad the size above which the
+    ///                  tags embedded in the sequences are
+    ///                  skipped
+    /// @param tag      the tag's position and type
+    ///
+    ///////////////////////////////////////////////////////////
+    void addSkeletonTag(const std::shared_ptr<baseStreamInput>& pStream, std::uint32_t maxSizeBufferLoad, const skeletonTag& tag);
+
+    /// \brief The tags of a group, sorted by tag id.
+    ///
+    ///////////////////////////////////////////////////////////
+    typedef std::vector<std::pair<std::uint16_t, std::shared_ptr<data> > > tTags;
 
     typedef std::set<std::uint16_t> tGroupsIds;
 
@@ -913,11 +964,90 @@ public:
 
     std::uint32_t getGroupsNumber(std::uint16_t groupId) const;
 
-    const tTags& getGroupTags(std::uint16_t groupId, size_t groupOrder) const;
+    tTags getGroupTags(std::uint16_t groupId, size_t groupOrder) const;
+
+    /// \brief A tag and its key in m_tags.
+    ///
+    /// The key contains the group id in the 16 most
+    ///  significant bits, then the group order and the tag
+    ///  id in the 16 less significant bits, so the tags
+    ///  sorted by key are sorted by group, order and tag id.
+    ///
+    ///////////////////////////////////////////////////////////
+    struct taggedData
+    {
+        std::uint64_t key;
+        std::shared_ptr<data> pData;
+    };
+
+    typedef std::vector<taggedData> tTagsVector;
+
+    /// \brief Function called by forEachGroup() with the
+    ///         group id and the range of the group's tags.
+    ///
+    ///////////////////////////////////////////////////////////
+    typedef std::function<void(std::uint16_t groupId, tTagsVector::const_iterator firstTag, tTagsVector::const_iterator endTag)> tGroupVisitor;
+
+    /// \brief Call a function for each group, sorted by
+    ///         group id and order.
+    ///
+    /// The tags are not copied: the dataset stays locked
+    ///  while the function runs, unless it is frozen.
+    /// The tags recorded in the skeleton are created first.
+    ///
+    /// @param visitor the function called for each group
+    ///
+    ///////////////////////////////////////////////////////////
+    void forEachGroup(const tGroupVisitor& visitor) const;
 
     void setCharsetsList(const charsetsList_t& charsets);
 
+    /// \brief Make the dataset, its tags, buffers and
+    ///         sequence items immutable.
+    ///
+    /// The tags recorded in the skeleton are created before
+    ///  the dataset is frozen.
+    /// After this call the reading functions don't lock the
+    ///  dataset anymore, so several threads can read it
+    ///  without contention, while the functions that modify
+    ///  it throw DataSetFrozenError.
+    ///
+    /// Throws DataSetFrozenError if a writing handler
+    ///  obtained from the dataset has not been released yet:
+    ///  the data it writes would be discarded.
+    ///
+    ///////////////////////////////////////////////////////////
+    void freeze();
+
+    /// \brief Return true if a writing handler obtained from
+    ///         the dataset's tags or sequence items has not
+    ///         been released yet.
+    ///
+    ///////////////////////////////////////////////////////////
+    bool hasWritingHandlers() const;
+
+    /// \brief Return true if the dataset has been frozen.
+    ///
+    /// @return true if freeze() has been called
+    ///
+    ///////////////////////////////////////////////////////////
+    bool isFrozen() const;
+
 private:
+    /// \brief Lock the dataset, unless it is frozen.
+    ///
+    /// @return a lock on m_mutex, or an empty lock if the
+    ///         dataset is frozen
+    ///
+    ///////////////////////////////////////////////////////////
+    std::unique_lock<std::recursive_mutex> lockUnlessFrozen() const;
+
+    /// \brief Throw DataSetFrozenError if the dataset is
+    ///         frozen.
+    ///
+    ///////////////////////////////////////////////////////////
+    void throwIfFrozen() const;
+
     /// \brief Get a frame's offset from the offset table.
     ///
     /// @param frameNumber the number of the frame for which
@@ -939,7 +1069,7 @@ private:
     // Position of the sequence item in the stream. Used to
     //  parse DICOMDIR items
     ///////////////////////////////////////////////////////////
-    std::uint32_t m_itemOffset;
+    std::atomic<std::uint32_t> m_itemOffset;
 
     /// \brief Get the id of the buffer that starts at the
     ///         specified offset.
@@ -952,11 +1082,47 @@ private:
     ///////////////////////////////////////////////////////////
     std::uint32_t getFrameBufferId(std::uint32_t offset) const;
 
-    tGroups m_groups;
+    /// \brief Create the tag recorded in the skeleton, if
+    ///         any.
+    ///
+    ///////////////////////////////////////////////////////////
+    void loadSkeletonTag(std::uint16_t groupId, std::uint32_t order, std::uint16_t tagId) const;
+
+    /// \brief Create all the tags recorded in the skeleton.
+    ///
+    ///////////////////////////////////////////////////////////
+    void loadSkeleton() const;
+
+    void createSkeletonTag(const skeletonTag& tag) const;
+
+    static std::uint64_t getTagKey(std::uint16_t groupId, std::uint32_t order, std::uint16_t tagId);
+
+    /// \brief Returns the first tag with a key equal or
+    ///         greater than the specified one.
+    ///
+    ///////////////////////////////////////////////////////////
+    tTagsVector::const_iterator findTagKey(std::uint64_t key) const;
+
+    // All the tags, in a contiguous vector sorted by key:
+    //  the parsed tags are appended at the end
+    ///////////////////////////////////////////////////////////
+    tTagsVector m_tags;
+
+    // Tags skipped by the codec, sorted by group, order and
+    //  tag id when m_bSkeletonSorted is true
+    ///////////////////////////////////////////////////////////
+    mutable std::vector<skeletonTag> m_skeleton;
+    mutable bool m_bSkeletonSorted;
+    std::shared_ptr<baseStreamInput> m_pSkeletonStream;
+    std::uint32_t m_skeletonMaxSizeBufferLoad;
 
     std::shared_ptr<charsetsList_t> m_pCharsetsList;
 
     mutable std::recursive_mutex m_mutex;
+
+    // Set by freeze(): the dataset doesn't change anymore
+    ///////////////////////////////////////////////////////////
+    std::atomic<bool> m_bFrozen;
 };
 
 
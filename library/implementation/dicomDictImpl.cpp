@@ -282,6 +282,20 @@ tagVR_t dicomDictionary::getTagType(std::uint16_t groupId, std::uint16_t tagId)
 }
 
 
+tagVR_t dicomDictionary::getTagType(std::uint16_t groupId, std::uint16_t tagId, tagVR_t defaultType) const
+{
+    std::uint32_t tagDWordId=(((std::uint32_t)groupId)<<16) | (std::uint32_t)tagId;
+
+    tDicomDictionary::const_iterator findIterator = m_dicomDict.find(tagDWordId);
+    if(findIterator == m_dicomDict.end())
+    {
+        return defaultType;
+    }
+
+    return findIterator->second.m_vr0;
+}
+
+
 bool dicomDictionary::isDataTypeValid(const std::string& dataType) const
 {
     try
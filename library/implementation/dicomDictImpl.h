@@ -102,6 +102,21 @@ public:
     ///////////////////////////////////////////////////////////
     tagVR_t getTagType(std::uint16_t groupId, std::uint16_t tagId) const;
 
+    /// \brief Retrieve a tag's default data type, or the
+    ///         specified type if the tag is not in the
+    ///         dictionary.
+    ///
+    /// Used by the codecs to avoid throwing an exception
+    ///  for each private tag.
+    ///
+    /// @param groupId   The group which the tag belongs to
+    /// @param tagId     The tag's id
+    /// @param defaultType the type returned for unknown tags
+    /// @return          The tag's data type
+    ///
+    ///////////////////////////////////////////////////////////
+    tagVR_t getTagType(std::uint16_t groupId, std::uint16_t tagId, tagVR_t defaultType) const;
+
     /// \brief Retrieve the only valid instance of this class.
     ///
     /// @return a pointer to the dicom dictionary
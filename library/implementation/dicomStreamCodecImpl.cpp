@@ -18,6 +18,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 
 #include <list>
 #include <vector>
+#include <algorithm>
 #include <string.h>
 #include "exceptionImpl.h"
 #include "streamReaderImpl.h"
@@ -97,6 +98,35 @@ void dicomStreamCodec::writeStream(std::shared_ptr<streamWriter> pStream, std::s
 }
 
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Replace or insert a tag in a group, keeping the tags
+//  sorted
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+static void setGroupTag(dataSet::tTagsVector& tags, std::uint16_t tagId, const std::shared_ptr<data>& pData)
+{
+    // The tags of a group differ only in the tag id, stored
+    //  in the 16 less significant bits of the key
+    ///////////////////////////////////////////////////////////
+    const std::uint64_t key((tags.front().key & ~std::uint64_t(0xffff)) | tagId);
+    dataSet::tTagsVector::iterator findTag(std::lower_bound(tags.begin(), tags.end(), key, [](const dataSet::taggedData& tag, std::uint64_t findKey)
+    {
+        return tag.key < findKey;
+    }));
+    if(findTag != tags.end() && findTag->key == key)
+    {
+        findTag->pData = pData;
+        return;
+    }
+    tags.insert(findTag, dataSet::taggedData{key, pData});
+}
+
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 //
@@ -110,56 +140,51 @@ void dicomStreamCodec::buildStream(std::shared_ptr<streamWriter> pStream, std::s
 {
     IMEBRA_FUNCTION_START();
 
-    dataSet::tGroupsIds groups = pDataSet->getGroups();
-
-    for(dataSet::tGroupsIds::const_iterator scanGroups(groups.begin()), endGroups(groups.end()); scanGroups != endGroups; ++scanGroups)
+    // The groups are written while the dataset is locked,
+    //  without copying their tags
+    ///////////////////////////////////////////////////////////
+    pDataSet->forEachGroup([&](std::uint16_t groupId, dataSet::tTagsVector::const_iterator firstTag, dataSet::tTagsVector::const_iterator endTag)
     {
-        size_t numGroups = pDataSet->getGroupsNumber(*scanGroups);
-        for(size_t scanGroupsNumber(0); scanGroupsNumber != numGroups; ++scanGroupsNumber)
+        if(groupId == 0x0002)
         {
-            const dataSet::tTags& tags(pDataSet->getGroupTags(*scanGroups, scanGroupsNumber));
-
-            if(*scanGroups == 0x0002)
+            // When writing a media storage file, the tag 0002,0001 must be 0,1 (OB)
+            ////////////////////////////////////////////////////////////////////////
+            if(streamType == streamType_t::mediaStorage)
             {
-                // When writing a media storage file, the tag 0002,0001 must be 0,1 (OB)
-                ////////////////////////////////////////////////////////////////////////
-                if(streamType == streamType_t::mediaStorage)
+                dataSet::tTagsVector temporaryTags(firstTag, endTag);
+                const std::shared_ptr<charsetsList_t> charsets(std::make_shared<charsetsList_t>());
+                std::shared_ptr<data> metaInformationTag(std::make_shared<data>(tagVR_t::OB, charsets));
                 {
-                    dataSet::tTags temporaryTags(tags);
-                    const std::shared_ptr<charsetsList_t> charsets(std::make_shared<charsetsList_t>());
-                    std::shared_ptr<data> metaInformationTag(std::make_shared<data>(tagVR_t::OB, charsets));
-                    {
-                        std::shared_ptr<handlers::writingDataHandler> handler(metaInformationTag->getWritingDataHandler(0));
-                        handler->setUnsignedLong(0, 0);
-                        handler->setUnsignedLong(1, 1);
-                    }
-                    temporaryTags[1] = metaInformationTag;
-
-                    // Set the implementation tags
-                    std::shared_ptr<data> implementationClassUidTag(std::make_shared<data>(tagVR_t::UI, charsets));
-                    {
-                        std::shared_ptr<handlers::writingDataHandler> handler(implementationClassUidTag->getWritingDataHandler(0));
-                        handler->setString(0, IMEBRA_IMPLEMENTATION_CLASS_UID);
-                    }
-                    temporaryTags[0x12] = implementationClassUidTag;
+                    std::shared_ptr<handlers::writingDataHandler> handler(metaInformationTag->getWritingDataHandler(0));
+                    handler->setUnsignedLong(0, 0);
+                    handler->setUnsignedLong(1, 1);
+                }
+                setGroupTag(temporaryTags, 1, metaInformationTag);
 
-                    // Set the implementation name
-                    std::shared_ptr<data> implementationNameTag(std::make_shared<data>(tagVR_t::SH, charsets));
-                    {
-                        std::shared_ptr<handlers::writingDataHandler> handler(implementationNameTag->getWritingDataHandler(0));
-                        handler->setString(0, IMEBRA_IMPLEMENTATION_NAME);
-                    }
-                    temporaryTags[0x13] = implementationNameTag;
+                // Set the implementation tags
+                std::shared_ptr<data> implementationClassUidTag(std::make_shared<data>(tagVR_t::UI, charsets));
+                {
+                    std::shared_ptr<handlers::writingDataHandler> handler(implementationClassUidTag->getWritingDataHandler(0));
+                    handler->setString(0, IMEBRA_IMPLEMENTATION_CLASS_UID);
+                }
+                setGroupTag(temporaryTags, 0x12, implementationClassUidTag);
 
-                    writeGroup(pStream, temporaryTags, *scanGroups, bExplicitDataType, endianType);
+                // Set the implementation name
+                std::shared_ptr<data> implementationNameTag(std::make_shared<data>(tagVR_t::SH, charsets));
+                {
+                    std::shared_ptr<handlers::writingDataHandler> handler(implementationNameTag->getWritingDataHandler(0));
+                    handler->setString(0, IMEBRA_IMPLEMENTATION_NAME);
                 }
-            }
-            else
-            {
-                writeGroup(pStream, tags, *scanGroups, bExplicitDataType, endianType);
+                setGroupTag(temporaryTags, 0x13, implementationNameTag);
+
+                writeGroup(pStream, temporaryTags.begin(), temporaryTags.end(), groupId, bExplicitDataType, endianType);
             }
         }
-    }
+        else
+        {
+            writeGroup(pStream, firstTag, endTag, groupId, bExplicitDataType, endianType);
+        }
+    });
 
     IMEBRA_FUNCTION_END();
 }
@@ -174,7 +199,7 @@ void dicomStreamCodec::buildStream(std::shared_ptr<streamWriter> pStream, std::s
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-void dicomStreamCodec::writeGroup(std::shared_ptr<streamWriter> pDestStream, const dataSet::tTags& tags, std::uint16_t groupId, bool bExplicitDataType, streamController::tByteOrdering endianType)
+void dicomStreamCodec::writeGroup(std::shared_ptr<streamWriter> pDestStream, dataSet::tTagsVector::const_iterator firstTag, dataSet::tTagsVector::const_iterator endTag, std::uint16_t groupId, bool bExplicitDataType, streamController::tByteOrdering endianType)
 {
     IMEBRA_FUNCTION_START();
 
@@ -194,7 +219,7 @@ void dicomStreamCodec::writeGroup(std::shared_ptr<streamWriter> pDestStream, con
     {
         // Calculate the group's length
         ///////////////////////////////////////////////////////////
-        std::uint32_t groupLength = getGroupLength(tags, bExplicitDataType);
+        std::uint32_t groupLength = getGroupLength(firstTag, endTag, bExplicitDataType);
 
         // Write the group length VR
         ///////////////////////////////////////////////////////////
@@ -228,15 +253,15 @@ void dicomStreamCodec::writeGroup(std::shared_ptr<streamWriter> pDestStream, con
 
     // Write all the tags
     ///////////////////////////////////////////////////////////
-    for(dataSet::tTags::const_iterator scanTags(tags.begin()), endTags(tags.end()); scanTags != endTags; ++scanTags)
+    for(dataSet::tTagsVector::const_iterator scanTags(firstTag); scanTags != endTag; ++scanTags)
     {
-        std::uint16_t tagId = scanTags->first;
+        std::uint16_t tagId = (std::uint16_t)(scanTags->key & 0xffff);
         if(tagId == 0)
         {
             continue;
         }
         pDestStream->write(reinterpret_cast<const std::uint8_t*>(&adjustedGroupId), 2u);
-        writeTag(pDestStream, scanTags->second, tagId, bExplicitDataType, endianType);
+        writeTag(pDestStream, scanTags->pData, tagId, bExplicitDataType, endianType);
     }
 
     IMEBRA_FUNCTION_END();
@@ -346,10 +371,12 @@ void dicomStreamCodec::writeTag(std::shared_ptr<streamWriter> pDestStream, std::
             }
 
             std::uint32_t wordSize = dicomDictionary::getDicomDictionary()->getWordSize(dataType);
-            if(pBuffer->hasExternalStream() && (wordSize < 2u || endianType == pBuffer->getEndianType()))
+            if(pBuffer->hasExternalStream() && (wordSize < 2u || (endianType == pBuffer->getEndianType() && endianType == streamController::getPlatformEndian())))
             {
                 // The buffer has a stream which is already with the
-                // requested byte endianess
+                // requested byte endianess (buffer::getStreamReader()
+                // returns the original stream only when it doesn't
+                // need an endian adjustment)
                 ///////////////////////////////////////////////////////////
                 std::shared_ptr<streamReader> pReader = pData->getStreamReader(scanBuffers);
 
@@ -390,7 +417,20 @@ void dicomStreamCodec::writeTag(std::shared_ptr<streamWriter> pDestStream, std::
                 ///////////////////////////////////////////////////////////
                 std::shared_ptr<handlers::readingDataHandlerRaw> pDataHandlerRaw = pData->getReadingDataHandlerRaw(scanBuffers);
 
-                if(wordSize > 1)
+                // The memory of the buffers loaded on demand has
+                //  already been adjusted to the platform's endianess
+                ///////////////////////////////////////////////////////////
+                const streamController::tByteOrdering memoryEndianType(pBuffer->hasExternalStream() ? streamController::getPlatformEndian() : pBuffer->getEndianType());
+
+                if(writeSize == bufferSize && (wordSize < 2u || memoryEndianType == endianType))
+                {
+                    // Hand the memory to the writer: streams that collect
+                    // the data in memory keep a reference to it instead
+                    // of copying it
+                    ///////////////////////////////////////////////////////////
+                    pDestStream->write(pDataHandlerRaw->getMemory());
+                }
+                else if(wordSize > 1)
                 {
                     std::vector<std::uint8_t> tempBuffer(writeSize);
                     ::memcpy(tempBuffer.data(), pDataHandlerRaw->getMemoryBuffer(), pDataHandlerRaw->getSize());
@@ -398,7 +438,7 @@ void dicomStreamCodec::writeTag(std::shared_ptr<streamWriter> pDestStream, std::
                     {
                         tempBuffer[bufferSize] = pData->getPaddingByte();
                     }
-                    if(pBuffer->getEndianType() != endianType)
+                    if(memoryEndianType != endianType)
                     {
                         streamController::reverseEndian(tempBuffer.data(), wordSize, writeSize / wordSize);
                     }
@@ -537,22 +577,22 @@ std::uint32_t dicomStreamCodec::getTagLength(const std::shared_ptr<data>& pData,
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-std::uint32_t dicomStreamCodec::getGroupLength(const dataSet::tTags& tags, bool bExplicitDataType)
+std::uint32_t dicomStreamCodec::getGroupLength(dataSet::tTagsVector::const_iterator firstTag, dataSet::tTagsVector::const_iterator endTag, bool bExplicitDataType)
 {
     IMEBRA_FUNCTION_START();
 
     std::uint32_t totalLength(0);
 
-    for(dataSet::tTags::const_iterator scanTags(tags.begin()), endTags(tags.end()); scanTags != endTags; ++scanTags)
+    for(dataSet::tTagsVector::const_iterator scanTags(firstTag); scanTags != endTag; ++scanTags)
     {
-        if(scanTags->first == 0)
+        if((scanTags->key & 0xffff) == 0)
         {
             continue;
         }
 
         std::uint32_t tagHeaderLength;
         bool bSequence;
-        totalLength += getTagLength(scanTags->second, bExplicitDataType, &tagHeaderLength, &bSequence);
+        totalLength += getTagLength(scanTags->pData, bExplicitDataType, &tagHeaderLength, &bSequence);
         totalLength += tagHeaderLength;
     }
 
@@ -596,7 +636,7 @@ std::uint32_t dicomStreamCodec::getDataSetLength(std::shared_ptr<dataSet> pDataS
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-void dicomStreamCodec::readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */) const
+void dicomStreamCodec::readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */, std::shared_ptr<const tagsFilter> pFilter /* = nullptr */) const
 {
     IMEBRA_FUNCTION_START();
 
@@ -659,7 +699,7 @@ void dicomStreamCodec::readStream(std::shared_ptr<streamReader> pStream, std::sh
 
     // Signature OK. Now scan all the tags.
     ///////////////////////////////////////////////////////////
-    parseStream(pStream, pDataSet, bExplicitDataType, endianType, maxSizeBufferLoad);
+    parseStream(pStream, pDataSet, bExplicitDataType, endianType, maxSizeBufferLoad, 0xffffffff, 0, 0, pFilter);
 
     IMEBRA_FUNCTION_END();
 }
@@ -680,7 +720,8 @@ void dicomStreamCodec::parseStream(std::shared_ptr<streamReader> pStream,
                              std::uint32_t maxSizeBufferLoad /* = 0xffffffff */,
                              std::uint32_t subItemLength /* = 0xffffffff */,
                              std::uint32_t* pReadSubItemLength /* = 0 */,
-                             std::uint32_t depth)
+                             std::uint32_t depth /* = 0 */,
+                             std::shared_ptr<const tagsFilter> pFilter /* = nullptr */)
 {
     IMEBRA_FUNCTION_START();
 
@@ -876,14 +917,7 @@ void dicomStreamCodec::parseStream(std::shared_ptr<streamReader> pStream,
             }
             else
             {
-                try
-                {
-                    tagType = dicomDictionary::getDicomDictionary()->getTagType(tagId, tagSubId);
-                }
-                catch(const DictionaryUnknownTagError&)
-                {
-                    tagType = tagVR_t::UN;
-                }
+                tagType = dicomDictionary::getDicomDictionary()->getTagType(tagId, tagSubId, tagVR_t::UN);
                 wordSize = dicomDictionary::getDicomDictionary()->getWordSize(tagType);
             }
         }
@@ -925,9 +959,48 @@ void dicomStreamCodec::parseStream(std::shared_ptr<streamReader> pStream,
         lastGroupId=tagId;
         lastTagId=tagSubId;
 
-        if(tagLengthDWord != 0xffffffff && tagType != tagVR_t::SQ)
+        ///////////////////////////////////////////////////////////
+        //
+        // Stop after the last requested tag and skip the tags
+        //  that have not been requested
+        //
+        ///////////////////////////////////////////////////////////
+        if(pFilter != nullptr)
+        {
+            if(pFilter->isAfterStopTag(tagId, tagSubId))
+            {
+                break;
+            }
+            if(!pFilter->isLoaded(tagId, tagSubId))
+            {
+                if(tagLengthDWord == 0xffffffff)
+                {
+                    std::uint32_t delimiterLength(0);
+                    (*pReadSubItemLength) += skipSequenceItems(pStream, bExplicitDataType, endianType, depth, &delimiterLength);
+                    (*pReadSubItemLength) += delimiterLength;
+                }
+                else
+                {
+                    pStream->seekForward(tagLengthDWord);
+                    (*pReadSubItemLength) += tagLengthDWord;
+                }
+                continue;
+            }
+        }
+
+        if(tagLengthDWord != 0xffffffff && (tagType != tagVR_t::SQ || tagLengthDWord > maxSizeBufferLoad))
         {
-            (*pReadSubItemLength) += readTag(pStream, pDataSet, tagLengthDWord, tagId, order, tagSubId, tagType, endianType, wordSize, 0, maxSizeBufferLoad);
+            // Tags and sequences bigger than the maximum loadable
+            //  size are only recorded in the dataset's skeleton
+            ///////////////////////////////////////////////////////////
+            if(tagLengthDWord > maxSizeBufferLoad)
+            {
+                (*pReadSubItemLength) += skipTag(pStream, pDataSet, tagLengthDWord, tagId, tagType == tagVR_t::SQ ? 0 : order, tagSubId, tagType, bExplicitDataType, endianType, wordSize, maxSizeBufferLoad, depth);
+            }
+            else
+            {
+                (*pReadSubItemLength) += readTag(pStream, pDataSet, tagLengthDWord, tagId, order, tagSubId, tagType, endianType, wordSize, 0, maxSizeBufferLoad);
+            }
 
             // We found the charsets list
             if(tagId == 0x0008 && tagSubId == 0x0005)
@@ -953,84 +1026,360 @@ void dicomStreamCodec::parseStream(std::shared_ptr<streamReader> pStream,
         //
         ///////////////////////////////////////////////////////////
 
-        // Parse all the sequence's items
+        // When only the skeleton is parsed then also the
+        //  undefined-length sequences are skipped
         ///////////////////////////////////////////////////////////
-        std::uint16_t subItemGroupId;
-        std::uint16_t subItemTagId;
-        std::uint32_t sequenceItemLength;
-        std::uint32_t bufferId = 0;
-        while(tagLengthDWord && !pStream->endReached())
+        if(tagType == tagVR_t::SQ && maxSizeBufferLoad == 0)
         {
-            // Add the tag to the dataset
-            ///////////////////////////////////////////////////////////
-            std::shared_ptr<data> sequenceTag = pDataSet->getTagCreate(tagId, 0x0, tagSubId, tagType);
+            (*pReadSubItemLength) += skipTag(pStream, pDataSet, tagLengthDWord, tagId, 0, tagSubId, tagType, bExplicitDataType, endianType, wordSize, maxSizeBufferLoad, depth);
+            continue;
+        }
 
-            // Remember the item's position (used by DICOMDIR
-            //  structures)
-            ///////////////////////////////////////////////////////////
-            std::uint32_t itemOffset((std::uint32_t)pStream->getControlledStreamPosition());
+        (*pReadSubItemLength) += parseSequence(pStream, pDataSet, tagId, order, tagSubId, tagType, tagLengthDWord, bExplicitDataType, endianType, wordSize, maxSizeBufferLoad, depth);
 
-            // Read the sequence item's group
-            ///////////////////////////////////////////////////////////
-            pStream->read((std::uint8_t*)&subItemGroupId, sizeof(subItemGroupId));
-            pStream->adjustEndian((std::uint8_t*)&subItemGroupId, sizeof(subItemGroupId), endianType);
-            (*pReadSubItemLength) += (std::uint32_t)sizeof(subItemGroupId);
+    } // End of the tags-read block
 
-            // Read the sequence item's id
-            ///////////////////////////////////////////////////////////
-            pStream->read((std::uint8_t*)&subItemTagId, sizeof(subItemTagId));
-            pStream->adjustEndian((std::uint8_t*)&subItemTagId, sizeof(subItemTagId), endianType);
-            (*pReadSubItemLength) += (std::uint32_t)sizeof(subItemTagId);
+    IMEBRA_FUNCTION_END();
 
-            // Read the sequence item's length
-            ///////////////////////////////////////////////////////////
-            pStream->read((std::uint8_t*)&sequenceItemLength, sizeof(sequenceItemLength));
-            pStream->adjustEndian((std::uint8_t*)&sequenceItemLength, sizeof(sequenceItemLength), endianType);
-            (*pReadSubItemLength) += (std::uint32_t)sizeof(sequenceItemLength);
+}
 
-            if(tagLengthDWord!=0xffffffff)
-            {
-                tagLengthDWord-=8;
-            }
 
-            // check for the end of the undefined length sequence
-            ///////////////////////////////////////////////////////////
-            if(subItemGroupId==0xfffe && subItemTagId==0xe0dd)
-            {
-                break;
-            }
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Parse the items of a sequence or the buffers of an
+//  undefined-length tag
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::uint32_t dicomStreamCodec::parseSequence(
+        std::shared_ptr<streamReader> pStream,
+        std::shared_ptr<dataSet> pDataSet,
+        std::uint16_t tagId,
+        std::uint16_t order,
+        std::uint16_t tagSubId,
+        tagVR_t tagType,
+        std::uint32_t tagLengthDWord,
+        bool bExplicitDataType,
+        streamController::tByteOrdering endianType,
+        size_t wordSize,
+        std::uint32_t maxSizeBufferLoad,
+        std::uint32_t depth)
+{
+    IMEBRA_FUNCTION_START();
 
-            ///////////////////////////////////////////////////////////
-            // Parse a sub element
-            ///////////////////////////////////////////////////////////
-            if((sequenceItemLength == 0xffffffff) || tagType == tagVR_t::SQ)
-            {
-                std::shared_ptr<dataSet> sequenceDataSet(sequenceTag->appendSequenceItem());
-                sequenceDataSet->setItemOffset(itemOffset);
-                std::uint32_t effectiveLength(0);
-                parseStream(pStream, sequenceDataSet, bExplicitDataType, endianType, maxSizeBufferLoad, sequenceItemLength, &effectiveLength, depth + 1);
-                (*pReadSubItemLength) += effectiveLength;
-                if(tagLengthDWord!=0xffffffff)
-                    tagLengthDWord-=effectiveLength;
+    std::uint32_t readLength(0);
 
-                continue;
-            }
+    // Parse all the sequence's items
+    ///////////////////////////////////////////////////////////
+    std::uint16_t subItemGroupId;
+    std::uint16_t subItemTagId;
+    std::uint32_t sequenceItemLength;
+    std::uint32_t bufferId = 0;
+    while(tagLengthDWord && !pStream->endReached())
+    {
+        // Add the tag to the dataset
+        ///////////////////////////////////////////////////////////
+        std::shared_ptr<data> sequenceTag = pDataSet->getTagCreate(tagId, 0x0, tagSubId, tagType);
 
-            ///////////////////////////////////////////////////////////
-            // Read a buffer's element
-            ///////////////////////////////////////////////////////////
-            sequenceItemLength = readTag(pStream, pDataSet, sequenceItemLength, tagId, order, tagSubId, tagType, endianType, wordSize, bufferId++, maxSizeBufferLoad);
-            (*pReadSubItemLength) += sequenceItemLength;
+        // Remember the item's position (used by DICOMDIR
+        //  structures)
+        ///////////////////////////////////////////////////////////
+        std::uint32_t itemOffset((std::uint32_t)pStream->getControlledStreamPosition());
+
+        // Read the sequence item's group
+        ///////////////////////////////////////////////////////////
+        pStream->read((std::uint8_t*)&subItemGroupId, sizeof(subItemGroupId));
+        pStream->adjustEndian((std::uint8_t*)&subItemGroupId, sizeof(subItemGroupId), endianType);
+        readLength += (std::uint32_t)sizeof(subItemGroupId);
+
+        // Read the sequence item's id
+        ///////////////////////////////////////////////////////////
+        pStream->read((std::uint8_t*)&subItemTagId, sizeof(subItemTagId));
+        pStream->adjustEndian((std::uint8_t*)&subItemTagId, sizeof(subItemTagId), endianType);
+        readLength += (std::uint32_t)sizeof(subItemTagId);
+
+        // Read the sequence item's length
+        ///////////////////////////////////////////////////////////
+        pStream->read((std::uint8_t*)&sequenceItemLength, sizeof(sequenceItemLength));
+        pStream->adjustEndian((std::uint8_t*)&sequenceItemLength, sizeof(sequenceItemLength), endianType);
+        readLength += (std::uint32_t)sizeof(sequenceItemLength);
+
+        if(tagLengthDWord!=0xffffffff)
+        {
+            tagLengthDWord-=8;
+        }
+
+        // check for the end of the undefined length sequence
+        ///////////////////////////////////////////////////////////
+        if(subItemGroupId==0xfffe && subItemTagId==0xe0dd)
+        {
+            break;
+        }
+
+        ///////////////////////////////////////////////////////////
+        // Parse a sub element
+        ///////////////////////////////////////////////////////////
+        if((sequenceItemLength == 0xffffffff) || tagType == tagVR_t::SQ)
+        {
+            std::shared_ptr<dataSet> sequenceDataSet(sequenceTag->appendSequenceItem());
+            sequenceDataSet->setItemOffset(itemOffset);
+            std::uint32_t effectiveLength(0);
+            parseStream(pStream, sequenceDataSet, bExplicitDataType, endianType, maxSizeBufferLoad, sequenceItemLength, &effectiveLength, depth + 1);
+            readLength += effectiveLength;
             if(tagLengthDWord!=0xffffffff)
+                tagLengthDWord-=effectiveLength;
+
+            continue;
+        }
+
+        ///////////////////////////////////////////////////////////
+        // Read a buffer's element
+        ///////////////////////////////////////////////////////////
+        sequenceItemLength = readTag(pStream, pDataSet, sequenceItemLength, tagId, order, tagSubId, tagType, endianType, wordSize, bufferId++, maxSizeBufferLoad);
+        readLength += sequenceItemLength;
+        if(tagLengthDWord!=0xffffffff)
+        {
+            tagLengthDWord -= sequenceItemLength;
+        }
+    }
+
+    return readLength;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Skip a tag and record its position in the dataset's
+//  skeleton
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::uint32_t dicomStreamCodec::skipTag(
+        std::shared_ptr<streamReader> pStream,
+        std::shared_ptr<dataSet> pDataSet,
+        std::uint32_t tagLengthDWord,
+        std::uint16_t tagId,
+        std::uint16_t order,
+        std::uint16_t tagSubId,
+        tagVR_t tagType,
+        bool bExplicitDataType,
+        streamController::tByteOrdering endianType,
+        size_t wordSize,
+        std::uint32_t maxSizeBufferLoad,
+        std::uint32_t depth)
+{
+    IMEBRA_FUNCTION_START();
+
+    size_t streamPosition(pStream->getControlledStreamPosition());
+    std::uint32_t tagLength(tagLengthDWord);
+    std::uint32_t readLength(tagLengthDWord);
+
+    if(tagLengthDWord == 0xffffffff)
+    {
+        // Undefined-length sequence: the skeleton records only
+        //  its items, without the sequence delimiter
+        ///////////////////////////////////////////////////////////
+        std::uint32_t delimiterLength(0);
+        tagLength = skipSequenceItems(pStream, bExplicitDataType, endianType, depth, &delimiterLength);
+        readLength = tagLength + delimiterLength;
+    }
+    else
+    {
+        size_t bufferPosition(pStream->position());
+        pStream->seekForward(tagLengthDWord);
+
+        if(pStream->position() - bufferPosition != tagLengthDWord)
+        {
+            IMEBRA_THROW(CodecCorruptedFileError, "dicomCodec::skipTag detected a corrupted tag");
+        }
+    }
+
+    skeletonTag tag;
+    tag.groupId = tagId;
+    tag.tagId = tagSubId;
+    tag.order = order;
+    tag.tagVR = tagType;
+    tag.length = tagLength;
+    tag.position = streamPosition;
+    tag.depth = (std::uint16_t)depth;
+    tag.wordSize = (std::uint8_t)wordSize;
+    tag.bExplicitDataType = bExplicitDataType;
+    tag.endianType = endianType;
+    pDataSet->addSkeletonTag(pStream->getControlledStream(), maxSizeBufferLoad, tag);
+
+    return readLength;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Skip the items of an undefined-length sequence, reading
+//  only the tags' headers
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::uint32_t dicomStreamCodec::skipSequenceItems(std::shared_ptr<streamReader> pStream, bool bExplicitDataType, streamController::tByteOrdering endianType, std::uint32_t depth, std::uint32_t* pDelimiterLength)
+{
+    IMEBRA_FUNCTION_START();
+
+    if(depth > IMEBRA_DATASET_MAX_DEPTH)
+    {
+        IMEBRA_THROW(DicomCodecDepthLimitReachedError, "Depth for embedded dataset reached");
+    }
+
+    std::uint16_t itemGroupId;
+    std::uint16_t itemTagId;
+    std::uint32_t itemLength;
+
+    std::uint32_t itemsLength(0);
+    *pDelimiterLength = 0;
+
+    while(!pStream->endReached())
+    {
+        pStream->read((std::uint8_t*)&itemGroupId, sizeof(itemGroupId));
+        pStream->adjustEndian((std::uint8_t*)&itemGroupId, sizeof(itemGroupId), endianType);
+        pStream->read((std::uint8_t*)&itemTagId, sizeof(itemTagId));
+        pStream->adjustEndian((std::uint8_t*)&itemTagId, sizeof(itemTagId), endianType);
+        pStream->read((std::uint8_t*)&itemLength, sizeof(itemLength));
+        pStream->adjustEndian((std::uint8_t*)&itemLength, sizeof(itemLength), endianType);
+
+        // End of the sequence
+        ///////////////////////////////////////////////////////////
+        if(itemGroupId == 0xfffe && itemTagId == 0xe0dd)
+        {
+            *pDelimiterLength = 8;
+            break;
+        }
+
+        itemsLength += 8;
+
+        if(itemLength == 0xffffffff)
+        {
+            itemsLength += skipDataSet(pStream, bExplicitDataType, endianType, depth + 1);
+            continue;
+        }
+
+        pStream->seekForward(itemLength);
+        itemsLength += itemLength;
+    }
+
+    return itemsLength;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Skip an undefined-length sequence item, reading only
+//  the tags' headers
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::uint32_t dicomStreamCodec::skipDataSet(std::shared_ptr<streamReader> pStream, bool bExplicitDataType, streamController::tByteOrdering endianType, std::uint32_t depth)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::uint16_t tagId;
+    std::uint16_t tagSubId;
+    std::uint16_t tagLengthWord;
+    std::uint32_t tagLengthDWord;
+
+    std::uint32_t readLength(0);
+
+    while(!pStream->endReached())
+    {
+        pStream->read((std::uint8_t*)&tagId, sizeof(tagId));
+        pStream->adjustEndian((std::uint8_t*)&tagId, sizeof(tagId), endianType);
+        pStream->read((std::uint8_t*)&tagSubId, sizeof(tagSubId));
+        pStream->adjustEndian((std::uint8_t*)&tagSubId, sizeof(tagSubId), endianType);
+        readLength += 4;
+
+        // End of the item
+        ///////////////////////////////////////////////////////////
+        if(tagId == 0xfffe && tagSubId == 0xe00d)
+        {
+            std::uint32_t dummyDWord;
+            pStream->read((std::uint8_t*)&dummyDWord, 4);
+            readLength += 4;
+            break;
+        }
+
+        // Read the tag's length as parseStream() does
+        ///////////////////////////////////////////////////////////
+        if(bExplicitDataType && tagId != 0xfffe)
+        {
+            std::string tagTypeString((size_t)2, ' ');
+            pStream->read((std::uint8_t*)&(tagTypeString[0]), 2);
+            pStream->read((std::uint8_t*)&tagLengthWord, sizeof(tagLengthWord));
+            pStream->adjustEndian((std::uint8_t*)&tagLengthWord, sizeof(tagLengthWord), endianType);
+            readLength += 4;
+
+            try
             {
-                tagLengthDWord -= sequenceItemLength;
+                tagVR_t tagType(dicomDictionary::getDicomDictionary()->stringDataTypeToEnum(tagTypeString));
+                tagLengthDWord = (std::uint32_t)tagLengthWord;
+                if(dicomDictionary::getDicomDictionary()->getLongLength(tagType))
+                {
+                    pStream->read((std::uint8_t*)&tagLengthDWord, sizeof(tagLengthDWord));
+                    pStream->adjustEndian((std::uint8_t*)&tagLengthDWord, sizeof(tagLengthDWord), endianType);
+                    readLength += 4;
+                }
+            }
+            catch(const DictionaryUnknownDataTypeError&)
+            {
+                bExplicitDataType = false;
+                if(endianType == streamController::lowByteEndian)
+                    tagLengthDWord=(((std::uint32_t)tagLengthWord)<<16) | ((std::uint32_t)tagTypeString[0]) | (((std::uint32_t)tagTypeString[1])<<8);
+                else
+                    tagLengthDWord=(std::uint32_t)tagLengthWord | (((std::uint32_t)tagTypeString[0])<<24) | (((std::uint32_t)tagTypeString[1])<<16);
             }
         }
+        else
+        {
+            pStream->read((std::uint8_t*)&tagLengthDWord, sizeof(tagLengthDWord));
+            pStream->adjustEndian((std::uint8_t*)&tagLengthDWord, sizeof(tagLengthDWord), endianType);
+            readLength += 4;
+        }
 
-    } // End of the tags-read block
+        // End of a sequence without the item's end
+        ///////////////////////////////////////////////////////////
+        if(tagId == 0xfffe && tagSubId == 0xe0dd)
+        {
+            break;
+        }
 
-    IMEBRA_FUNCTION_END();
+        if(tagLengthDWord == 0xffffffff)
+        {
+            std::uint32_t delimiterLength(0);
+            readLength += skipSequenceItems(pStream, bExplicitDataType, endianType, depth, &delimiterLength);
+            readLength += delimiterLength;
+            continue;
+        }
+
+        pStream->seekForward(tagLengthDWord);
+        readLength += tagLengthDWord;
+    }
+
+    return readLength;
 
+    IMEBRA_FUNCTION_END();
 }
 
 
@@ -1085,6 +1434,25 @@ std::uint32_t dicomStreamCodec::readTag(
         return (std::uint32_t)bufferLength;
     }
 
+    // If the stream can expose its content directly (memory
+    //  mapped files) and the tag doesn't need an endian
+    //  adjustment then the tag's buffer references the
+    //  stream's memory instead of copying it
+    ///////////////////////////////////////////////////////////
+    if(tagLengthDWord != 0 &&
+            !(tagId == 0xfffc && tagSubId == 0xfffc) &&
+            (wordSize <= 1 || endianType == streamController::getPlatformEndian()) &&
+            (pStream->getVirtualLength() == 0 || pStream->position() + tagLengthDWord <= pStream->getVirtualLength()))
+    {
+        std::shared_ptr<const memory> viewMemory(pStream->getControlledStream()->getMemoryView(pStream->getControlledStreamPosition(), tagLengthDWord));
+        if(viewMemory != nullptr && isAligned(viewMemory->data(), wordSize))
+        {
+            pStream->seekForward(tagLengthDWord);
+            pDataSet->getTagCreate(tagId, order, tagSubId, tagType)->getBufferCreate(bufferId)->commit(viewMemory);
+            return tagLengthDWord;
+        }
+    }
+
     // Allocate the tag's buffer
     ///////////////////////////////////////////////////////////
     std::shared_ptr<handlers::writingDataHandlerRaw> handler(pDataSet->getWritingDataHandlerRaw(tagId, order, tagSubId, bufferId, tagType));
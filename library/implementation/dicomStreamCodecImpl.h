@@ -94,8 +94,11 @@ public:
     ///                    not loaded immediatly but it will be
     ///                    loaded on demand. Some codecs may
     ///                    ignore this parameter.
-    ///                   Set to -1 to load all the buffers
-    ///                    immediatly
+    ///                   Sequences that exceede the size are
+    ///                    parsed when they are accessed.
+    ///                   Set to 0 to parse only the tags'
+    ///                    positions (skeleton), set to -1 to
+    ///                    load all the buffers immediatly
     /// @param pReadSubItemLength a pointer to a std::uint32_t
     ///                    that the function will fill with
     ///                    the number of bytes read
@@ -104,6 +107,10 @@ public:
     ///                    - >=1 = dataset embedded into
     ///                      another dataset. This value is
     ///                      used to prevent a stack overflow
+    /// @param pFilter    selects the tags to load. The
+    ///                    parsing stops after the filter's
+    ///                    last tag. When null all the tags
+    ///                    are loaded
     ///
     ///////////////////////////////////////////////////////////
     static void parseStream(
@@ -114,7 +121,46 @@ public:
         std::uint32_t maxSizeBufferLoad = 0xffffffff,
         std::uint32_t subItemLength = 0xffffffff,
         std::uint32_t* pReadSubItemLength = 0,
-        std::uint32_t depth = 0);
+        std::uint32_t depth = 0,
+        std::shared_ptr<const tagsFilter> pFilter = nullptr);
+
+    /// \brief Parse the items of a sequence or the buffers
+    ///         of an undefined-length tag.
+    ///
+    /// Called by parseStream() and by dataSet when a sequence
+    ///  recorded in its skeleton is accessed.
+    ///
+    /// @param pStream    the stream positioned after the
+    ///                    tag's length
+    /// @param pDataSet   the dataset that owns the tag
+    /// @param tagId      the tag's group
+    /// @param order      the group's order
+    /// @param tagSubId   the tag's id
+    /// @param tagType    the tag's data type
+    /// @param tagLengthDWord the tag's length, 0xffffffff
+    ///                    for undefined-length tags
+    /// @param bExplicitDataType true if the stream uses the
+    ///                    explicit data type
+    /// @param endianType the stream's endian type
+    /// @param wordSize   the size of the tag's words
+    /// @param maxSizeBufferLoad see parseStream()
+    /// @param depth      the current dataSet depth
+    /// @return the number of bytes read
+    ///
+    ///////////////////////////////////////////////////////////
+    static std::uint32_t parseSequence(
+        std::shared_ptr<streamReader> pStream,
+        std::shared_ptr<dataSet> pDataSet,
+        std::uint16_t tagId,
+        std::uint16_t order,
+        std::uint16_t tagSubId,
+        tagVR_t tagType,
+        std::uint32_t tagLengthDWord,
+        bool bExplicitDataType,
+        streamController::tByteOrdering endianType,
+        size_t wordSize,
+        std::uint32_t maxSizeBufferLoad,
+        std::uint32_t depth);
 
     /// \brief Indicates the type of DICOM stream to build
     ///
@@ -147,20 +193,34 @@ protected:
 
     // Load a dicom stream
     ///////////////////////////////////////////////////////////
-    virtual void readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t maxSizeBufferLoad = 0xffffffff) const;
+    virtual void readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t maxSizeBufferLoad = 0xffffffff, std::shared_ptr<const tagsFilter> pFilter = nullptr) const;
 
 protected:
     // Read a single tag
     ///////////////////////////////////////////////////////////
     static std::uint32_t readTag(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t tagLengthDWord, std::uint16_t tagId, std::uint16_t order, std::uint16_t tagSubId, tagVR_t tagType, streamController::tByteOrdering endianType, size_t wordSize, std::uint32_t bufferId, std::uint32_t maxSizeBufferLoad = 0xffffffff);
 
+    // Skip a tag or an undefined-length sequence and record
+    //  it in the dataset's skeleton
+    ///////////////////////////////////////////////////////////
+    static std::uint32_t skipTag(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t tagLengthDWord, std::uint16_t tagId, std::uint16_t order, std::uint16_t tagSubId, tagVR_t tagType, bool bExplicitDataType, streamController::tByteOrdering endianType, size_t wordSize, std::uint32_t maxSizeBufferLoad, std::uint32_t depth);
+
+    // Skip the items of an undefined-length sequence and
+    //  return their length
+    ///////////////////////////////////////////////////////////
+    static std::uint32_t skipSequenceItems(std::shared_ptr<streamReader> pStream, bool bExplicitDataType, streamController::tByteOrdering endianType, std::uint32_t depth, std::uint32_t* pDelimiterLength);
+
+    // Skip an undefined-length sequence item
+    ///////////////////////////////////////////////////////////
+    static std::uint32_t skipDataSet(std::shared_ptr<streamReader> pStream, bool bExplicitDataType, streamController::tByteOrdering endianType, std::uint32_t depth);
+
     // Calculate the tag's length
     ///////////////////////////////////////////////////////////
     static std::uint32_t getTagLength(const std::shared_ptr<data>& pData, bool bExplicitDataType, std::uint32_t* pHeaderLength, bool *pbSequence);
 
     // Calculate the group's length
     ///////////////////////////////////////////////////////////
-    static std::uint32_t getGroupLength(const dataSet::tTags& tags, bool bExplicitDataType);
+    static std::uint32_t getGroupLength(dataSet::tTagsVector::const_iterator firstTag, dataSet::tTagsVector::const_iterator endTag, bool bExplicitDataType);
 
     // Calculate the dataset's length
     ///////////////////////////////////////////////////////////
@@ -168,7 +228,7 @@ protected:
 
     // Write a single group
     ///////////////////////////////////////////////////////////
-    static void writeGroup(std::shared_ptr<streamWriter> pDestStream, const dataSet::tTags& tags, std::uint16_t groupId, bool bExplicitDataType, streamController::tByteOrdering endianType);
+    static void writeGroup(std::shared_ptr<streamWriter> pDestStream, dataSet::tTagsVector::const_iterator firstTag, dataSet::tTagsVector::const_iterator endTag, std::uint16_t groupId, bool bExplicitDataType, streamController::tByteOrdering endianType);
 
     // Write a single tag
     ///////////////////////////////////////////////////////////
@@ -2180,6 +2180,21 @@ std::shared_ptr<dimseNCommand> dimseService::getCommand()
 }
 
 
+//////////////////////////////////////////////////////////////////
+//
+// Wait for a command or for the response to a command ID
+//
+//////////////////////////////////////////////////////////////////
+bool dimseService::waitCommandOrResponse(std::uint16_t commandID)
+{
+    IMEBRA_FUNCTION_START();
+
+    return m_pAssociation->waitCommandOrResponse(commandID);
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 //////////////////////////////////////////////////////////////////
 //
 // Get a response for the specific command ID
@@ -1623,6 +1623,19 @@ public:
     //////////////////////////////////////////////////////////////////
     std::shared_ptr<dimseResponse> getResponse(std::uint16_t commandID);
 
+    ///
+    /// \brief Waits until a command or the response for a
+    ///        specific command is available, without
+    ///        retrieving it.
+    ///
+    /// \param commandID the ID of the command for which the
+    ///                  response is expected
+    /// \return true if a command is available, false if the
+    ///         response is available
+    ///
+    //////////////////////////////////////////////////////////////////
+    bool waitCommandOrResponse(std::uint16_t commandID);
+
     ///
     /// \brief Gets the response for a specific command.
     ///        Blocks until the response is available or an exception
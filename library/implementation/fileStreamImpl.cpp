@@ -219,6 +219,11 @@ void fileStreamOutput::write(size_t startPosition, const std::uint8_t* pBuffer,
     IMEBRA_FUNCTION_END();
 }
 
+size_t fileStreamOutput::getPreferredBufferSize() const
+{
+    return IMEBRA_FILE_STREAM_BUFFER_SIZE;
+}
+
 
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
@@ -261,6 +266,11 @@ bool fileStreamInput::seekable() const
     return true;
 }
 
+size_t fileStreamInput::getPreferredBufferSize() const
+{
+    return IMEBRA_FILE_STREAM_BUFFER_SIZE;
+}
+
 size_t fileStreamInput::getSize() const
 {
     IMEBRA_FUNCTION_START();
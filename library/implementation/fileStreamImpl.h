@@ -25,6 +25,15 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <stdio.h>
 #include <mutex>
 
+///
+/// \brief Size of the buffer allocated by the streamReader
+///        and streamWriter objects connected to a file.
+///
+///////////////////////////////////////////////////////////
+#if(!defined IMEBRA_FILE_STREAM_BUFFER_SIZE)
+    #define IMEBRA_FILE_STREAM_BUFFER_SIZE 65536
+#endif
+
 
 namespace imebra
 {
@@ -78,6 +87,8 @@ public:
 
     virtual bool seekable() const override;
 
+    virtual size_t getPreferredBufferSize() const override;
+
     ///////////////////////////////////////////////////////////
     //
     // Returns the file size
@@ -100,6 +111,8 @@ public:
     ///////////////////////////////////////////////////////////
     virtual void write(size_t startPosition, const std::uint8_t* pBuffer, size_t bufferLength) override;
 
+    virtual size_t getPreferredBufferSize() const override;
+
 };
 
 } // namespace implementation
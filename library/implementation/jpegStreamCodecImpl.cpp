@@ -131,7 +131,7 @@ void jpegStreamCodec::writeStream(std::shared_ptr<streamWriter> pStream, std::sh
 //
 /////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////
-void jpegStreamCodec::readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t /* maxSizeBufferLoad = 0xffffffff */) const
+void jpegStreamCodec::readStream(std::shared_ptr<streamReader> pStream, std::shared_ptr<dataSet> pDataSet, std::uint32_t /* maxSizeBufferLoad = 0xffffffff */, std::shared_ptr<const tagsFilter> /* pFilter = nullptr */) const
 {
     IMEBRA_FUNCTION_START();
 
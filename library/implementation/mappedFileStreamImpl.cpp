@@ -0,0 +1,326 @@
+/*
+Copyright 2005 - 2017 by Paolo Brandoli/Binarno s.p.
+
+Imebra is available for free under the GNU General Public License.
+
+The full text of the license is available in the file license.rst
+ in the project root folder.
+
+If you do not want to be bound by the GPL terms (such as the requirement
+ that your application must also be GPL), you may purchase a commercial
+ license for Imebra from the Imebra’s website (http://imebra.com).
+*/
+
+/*! \file mappedFileStreamImpl.cpp
+    \brief Implementation of the memory mapped file input stream.
+
+*/
+
+#include "mappedFileStreamImpl.h"
+#include "memoryImpl.h"
+#include "../include/imebra/exceptions.h"
+
+#include <cstring>
+#include <errno.h>
+#include <locale>
+#include <codecvt>
+
+#ifndef IMEBRA_WINDOWS
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace imebra
+{
+
+namespace implementation
+{
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Open and map a file
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+memoryMappedFile::memoryMappedFile(const std::string& fileName):
+#ifdef IMEBRA_WINDOWS
+    m_file(INVALID_HANDLE_VALUE),
+    m_mapping(0),
+#else
+    m_file(-1),
+#endif
+    m_pData(0),
+    m_size(0)
+{
+    IMEBRA_FUNCTION_START();
+
+#ifdef IMEBRA_WINDOWS
+    m_file = ::CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(m_file == INVALID_HANDLE_VALUE)
+    {
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::open failure - error code: " << ::GetLastError());
+    }
+#else
+    m_file = ::open(fileName.c_str(), O_RDONLY);
+    if(m_file < 0)
+    {
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::open failure - error code: " << errno);
+    }
+#endif
+
+    map();
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Open and map a file (unicode)
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+memoryMappedFile::memoryMappedFile(const std::wstring& fileName):
+#ifdef IMEBRA_WINDOWS
+    m_file(INVALID_HANDLE_VALUE),
+    m_mapping(0),
+#else
+    m_file(-1),
+#endif
+    m_pData(0),
+    m_size(0)
+{
+    IMEBRA_FUNCTION_START();
+
+#ifdef IMEBRA_WINDOWS
+    m_file = ::CreateFileW(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if(m_file == INVALID_HANDLE_VALUE)
+    {
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::open failure - error code: " << ::GetLastError());
+    }
+#else
+    // Convert the filename to UTF8
+    std::string utf8FileName(std::wstring_convert<std::codecvt_utf8<wchar_t>, wchar_t>{}.to_bytes(fileName));
+
+    m_file = ::open(utf8FileName.c_str(), O_RDONLY);
+    if(m_file < 0)
+    {
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::open failure - error code: " << errno);
+    }
+#endif
+
+    map();
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Map the opened file. Empty files are not mapped
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void memoryMappedFile::map()
+{
+    IMEBRA_FUNCTION_START();
+
+#ifdef IMEBRA_WINDOWS
+    LARGE_INTEGER fileSize;
+    if(!::GetFileSizeEx(m_file, &fileSize))
+    {
+        ::CloseHandle(m_file);
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::map failure - error code: " << ::GetLastError());
+    }
+    if(fileSize.QuadPart == 0)
+    {
+        return;
+    }
+    m_mapping = ::CreateFileMappingA(m_file, 0, PAGE_READONLY, 0, 0, 0);
+    const void* pData(m_mapping == 0 ? 0 : ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if(pData == 0)
+    {
+        const DWORD errorCode(::GetLastError());
+        if(m_mapping != 0)
+        {
+            ::CloseHandle(m_mapping);
+        }
+        ::CloseHandle(m_file);
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::map failure - error code: " << errorCode);
+    }
+    m_pData = (const std::uint8_t*)pData;
+    m_size = (size_t)fileSize.QuadPart;
+#else
+    struct stat fileInfo;
+    if(::fstat(m_file, &fileInfo) != 0)
+    {
+        const int errorCode(errno);
+        ::close(m_file);
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::map failure - error code: " << errorCode);
+    }
+    if(fileInfo.st_size == 0)
+    {
+        return;
+    }
+    void* pData(::mmap(0, (size_t)fileInfo.st_size, PROT_READ, MAP_PRIVATE, m_file, 0));
+    if(pData == MAP_FAILED)
+    {
+        const int errorCode(errno);
+        ::close(m_file);
+        IMEBRA_THROW(StreamOpenError, "memoryMappedFile::map failure - error code: " << errorCode);
+    }
+    m_pData = (const std::uint8_t*)pData;
+    m_size = (size_t)fileInfo.st_size;
+#endif
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Destructor
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+memoryMappedFile::~memoryMappedFile()
+{
+#ifdef IMEBRA_WINDOWS
+    if(m_pData != 0)
+    {
+        ::UnmapViewOfFile(m_pData);
+    }
+    if(m_mapping != 0)
+    {
+        ::CloseHandle(m_mapping);
+    }
+    ::CloseHandle(m_file);
+#else
+    if(m_pData != 0)
+    {
+        ::munmap((void*)m_pData, m_size);
+    }
+    ::close(m_file);
+#endif
+}
+
+
+const std::uint8_t* memoryMappedFile::data() const
+{
+    return m_pData;
+}
+
+
+size_t memoryMappedFile::size() const
+{
+    return m_size;
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Input stream
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+mappedFileStreamInput::mappedFileStreamInput(const std::string& fileName):
+    m_pMappedFile(std::make_shared<memoryMappedFile>(fileName))
+{
+}
+
+mappedFileStreamInput::mappedFileStreamInput(const std::wstring& fileName):
+    m_pMappedFile(std::make_shared<memoryMappedFile>(fileName))
+{
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Read raw data from the stream
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+size_t mappedFileStreamInput::read(size_t startPosition, std::uint8_t* pBuffer, size_t bufferLength)
+{
+    const size_t size(m_pMappedFile->size());
+    if(startPosition >= size)
+    {
+        return 0;
+    }
+
+    const size_t readBytes((bufferLength > size - startPosition) ? size - startPosition : bufferLength);
+    ::memcpy(pBuffer, m_pMappedFile->data() + startPosition, readBytes);
+    return readBytes;
+}
+
+
+void mappedFileStreamInput::terminate()
+{
+}
+
+bool mappedFileStreamInput::seekable() const
+{
+    return true;
+}
+
+size_t mappedFileStreamInput::getPreferredBufferSize() const
+{
+    return IMEBRA_FILE_STREAM_BUFFER_SIZE;
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Return a view on the mapped file. The view keeps the
+//  mapping alive
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+std::shared_ptr<const memory> mappedFileStreamInput::getMemoryView(size_t startPosition, size_t length)
+{
+    IMEBRA_FUNCTION_START();
+
+    const size_t size(m_pMappedFile->size());
+    if(startPosition > size || length > size - startPosition)
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<const memory>(std::static_pointer_cast<const void>(m_pMappedFile), m_pMappedFile->data() + startPosition, length);
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+size_t mappedFileStreamInput::getSize() const
+{
+    return m_pMappedFile->size();
+}
+
+} // namespace implementation
+
+} // namespace imebra
@@ -0,0 +1,131 @@
+/*
+Copyright 2005 - 2017 by Paolo Brandoli/Binarno s.p.
+
+Imebra is available for free under the GNU General Public License.
+
+The full text of the license is available in the file license.rst
+ in the project root folder.
+
+If you do not want to be bound by the GPL terms (such as the requirement
+ that your application must also be GPL), you may purchase a commercial
+ license for Imebra from the Imebra’s website (http://imebra.com).
+*/
+
+/*! \file mappedFileStreamImpl.h
+    \brief Declaration of the memory mapped file input stream.
+
+*/
+
+#if !defined(imebraMappedFileStream_5E0C41B7_2D9A_4F63_8B1E_7A4C93D0F2A6__INCLUDED_)
+#define imebraMappedFileStream_5E0C41B7_2D9A_4F63_8B1E_7A4C93D0F2A6__INCLUDED_
+
+#include "configurationImpl.h"
+#include "baseStreamImpl.h"
+#include "fileStreamImpl.h"
+
+#include <memory>
+#include <string>
+
+#ifdef IMEBRA_WINDOWS
+#include <windows.h>
+#endif
+
+
+namespace imebra
+{
+
+namespace implementation
+{
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+/// \brief Maps a whole file in memory, read only.
+///
+/// The mapping is released when the object is destroyed:
+///  the memory views on the file keep a reference to
+///  this object.
+///
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+class memoryMappedFile
+{
+public:
+    memoryMappedFile(const std::string& fileName);
+    memoryMappedFile(const std::wstring& fileName);
+
+    ~memoryMappedFile();
+
+    memoryMappedFile(const memoryMappedFile&) = delete;
+    memoryMappedFile& operator=(const memoryMappedFile&) = delete;
+
+    const std::uint8_t* data() const;
+
+    size_t size() const;
+
+private:
+    void map();
+
+#ifdef IMEBRA_WINDOWS
+    HANDLE m_file;
+    HANDLE m_mapping;
+#else
+    int m_file;
+#endif
+
+    const std::uint8_t* m_pData;
+    size_t m_size;
+};
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+/// \brief An input file stream that reads from a memory
+///        mapped file.
+///
+/// The buffers of the tags loaded from this stream
+///  reference the mapped file instead of copying its
+///  content, so loading a large file costs page faults
+///  instead of allocations and copies.
+///
+/// The file must not be truncated while it is mapped.
+///
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+class mappedFileStreamInput : public baseStreamInput
+{
+public:
+    mappedFileStreamInput(const std::string& fileName);
+    mappedFileStreamInput(const std::wstring& fileName);
+
+    ///////////////////////////////////////////////////////////
+    //
+    // Virtual stream's functions
+    //
+    ///////////////////////////////////////////////////////////
+    virtual size_t read(size_t startPosition, std::uint8_t* pBuffer, size_t bufferLength) override;
+
+    virtual void terminate() override;
+
+    virtual bool seekable() const override;
+
+    virtual size_t getPreferredBufferSize() const override;
+
+    virtual std::shared_ptr<const memory> getMemoryView(size_t startPosition, size_t length) override;
+
+    ///////////////////////////////////////////////////////////
+    //
+    // Returns the file size
+    //
+    ///////////////////////////////////////////////////////////
+    size_t getSize() const;
+
+private:
+    std::shared_ptr<const memoryMappedFile> m_pMappedFile;
+};
+
+} // namespace implementation
+
+} // namespace imebra
+
+
+#endif // !defined(imebraMappedFileStream_5E0C41B7_2D9A_4F63_8B1E_7A4C93D0F2A6__INCLUDED_)
@@ -51,21 +51,67 @@ namespace implementation
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 memory::memory():
-    m_pMemoryBuffer(new stringUint8())
+    m_pMemoryBuffer(new stringUint8()),
+    m_pView(0),
+    m_viewSize(0)
 {
 }
 
 memory::memory(stringUint8* pBuffer):
-    m_pMemoryBuffer(pBuffer)
+    m_pMemoryBuffer(pBuffer),
+    m_pView(0),
+    m_viewSize(0)
 {
 }
 
 memory::memory(size_t initialSize):
-    m_pMemoryBuffer(memoryPoolGetter::getMemoryPoolGetter().getMemoryPoolLocal().getMemory(initialSize))
+    m_pMemoryBuffer(memoryPoolGetter::getMemoryPoolGetter().getMemoryPoolLocal().getMemory(initialSize)),
+    m_pView(0),
+    m_viewSize(0)
+{
+}
+
+memory::memory(const std::shared_ptr<const void>& pViewOwner, const std::uint8_t* pView, size_t viewSize):
+    m_pView(pView),
+    m_viewSize(viewSize),
+    m_pViewOwner(pViewOwner)
 {
 }
 
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Copy the viewed data into an owned buffer before it
+//  gets modified
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+void memory::detachView()
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_pViewOwner == nullptr)
+    {
+        return;
+    }
+
+    std::unique_ptr<stringUint8> pBuffer(memoryPoolGetter::getMemoryPoolGetter().getMemoryPoolLocal().getMemory(m_viewSize));
+    if(m_viewSize != 0)
+    {
+        ::memcpy(&((*pBuffer)[0]), m_pView, m_viewSize);
+    }
+    m_pMemoryBuffer.reset(pBuffer.release());
+    m_pView = 0;
+    m_viewSize = 0;
+    m_pViewOwner.reset();
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 //
@@ -94,6 +140,7 @@ void memory::copyFrom(const std::shared_ptr<const memory>& sourceMemory)
 {
     IMEBRA_FUNCTION_START();
 
+    detachView();
     if(m_pMemoryBuffer.get() == 0)
     {
         m_pMemoryBuffer.reset(new stringUint8);
@@ -115,6 +162,9 @@ void memory::copyFrom(const std::shared_ptr<const memory>& sourceMemory)
 ///////////////////////////////////////////////////////////
 void memory::clear()
 {
+    m_pView = 0;
+    m_viewSize = 0;
+    m_pViewOwner.reset();
     if(m_pMemoryBuffer.get() != 0)
     {
         m_pMemoryBuffer->clear();
@@ -135,6 +185,7 @@ void memory::resize(size_t newSize)
 {
     IMEBRA_FUNCTION_START();
 
+    detachView();
     if(m_pMemoryBuffer.get() == 0)
     {
         m_pMemoryBuffer.reset(new stringUint8((size_t)newSize, (std::uint8_t)0));
@@ -161,6 +212,7 @@ void memory::reserve(size_t reserveSize)
 {
     IMEBRA_FUNCTION_START();
 
+    detachView();
     if(m_pMemoryBuffer.get() == 0)
     {
         m_pMemoryBuffer.reset(new stringUint8());
@@ -182,6 +234,10 @@ void memory::reserve(size_t reserveSize)
 ///////////////////////////////////////////////////////////
 size_t memory::size() const
 {
+    if(m_pViewOwner != nullptr)
+    {
+        return m_viewSize;
+    }
     if(m_pMemoryBuffer.get() == 0)
     {
         return 0;
@@ -201,6 +257,7 @@ size_t memory::size() const
 ///////////////////////////////////////////////////////////
 std::uint8_t* memory::data()
 {
+    detachView();
     if(m_pMemoryBuffer.get() == 0 || m_pMemoryBuffer->empty())
     {
         return 0;
@@ -210,6 +267,10 @@ std::uint8_t* memory::data()
 
 const std::uint8_t* memory::data() const
 {
+    if(m_pViewOwner != nullptr)
+    {
+        return m_viewSize == 0 ? 0 : m_pView;
+    }
     if(m_pMemoryBuffer.get() == 0 || m_pMemoryBuffer->empty())
     {
         return 0;
@@ -228,6 +289,10 @@ const std::uint8_t* memory::data() const
 ///////////////////////////////////////////////////////////
 bool memory::empty() const
 {
+    if(m_pViewOwner != nullptr)
+    {
+        return m_viewSize == 0;
+    }
     return m_pMemoryBuffer.get() == 0 || m_pMemoryBuffer->empty();
 }
 
@@ -245,6 +310,7 @@ void memory::assign(const std::uint8_t* pSource, const size_t sourceLength)
 {
     IMEBRA_FUNCTION_START();
 
+    detachView();
     if(m_pMemoryBuffer.get() == 0)
     {
         m_pMemoryBuffer.reset(new stringUint8);
@@ -258,6 +324,7 @@ void memory::assignRegion(const std::uint8_t* pSource, const size_t sourceLength
 {
     IMEBRA_FUNCTION_START();
 
+    detachView();
     if(m_pMemoryBuffer.get() == 0)
     {
         m_pMemoryBuffer.reset(new stringUint8);
@@ -19,6 +19,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #if !defined(imebraMemory_DE3F98A9_664E_47c0_A29B_B681F9AEB118__INCLUDED_)
 #define imebraMemory_DE3F98A9_664E_47c0_A29B_B681F9AEB118__INCLUDED_
 
+#include <cstdint>
 #include <list>
 #include <map>
 #include <memory>
@@ -94,6 +95,21 @@ public:
 	///////////////////////////////////////////////////////////
     memory(size_t initialSize);
 
+    /// \brief Constructs a read only view on data owned by
+    ///         another object (e.g. a memory mapped file).
+    ///
+    /// The data is not copied: pViewOwner is kept alive
+    ///  until the memory object is destroyed or modified.
+    /// Modifying the memory object copies the viewed data
+    ///  into an owned buffer first.
+    ///
+    /// @param pViewOwner the object that owns the data
+    /// @param pView      pointer to the first viewed byte
+    /// @param viewSize   number of viewed bytes
+    ///
+    ///////////////////////////////////////////////////////////
+    memory(const std::shared_ptr<const void>& pViewOwner, const std::uint8_t* pView, size_t viewSize);
+
     /// \brief Destruct the memory object.
     ///
     /// The owned buffer is passed to the memoryPool for
@@ -191,10 +207,39 @@ public:
 
 
 protected:
+    /// \brief Replaces the view with an owned copy of the
+    ///         viewed data. Does nothing if the object
+    ///         is not a view.
+    ///
+    ///////////////////////////////////////////////////////////
+    void detachView();
+
     std::unique_ptr<stringUint8> m_pMemoryBuffer;
+
+    // Read only view, see memory(pViewOwner, pView, viewSize)
+    const std::uint8_t* m_pView;
+    size_t m_viewSize;
+    std::shared_ptr<const void> m_pViewOwner;
 };
 
 
+///////////////////////////////////////////////////////////
+/// \brief Return true if the data can be accessed as an
+///         array of words of the specified length.
+///
+/// Used before using a memory view as the content of
+///  a numeric tag.
+///
+/// @param pData      pointer to the data
+/// @param wordLength the length of the words, in bytes
+///
+///////////////////////////////////////////////////////////
+inline bool isAligned(const std::uint8_t* pData, size_t wordLength)
+{
+    return wordLength <= 1u || (reinterpret_cast<std::uintptr_t>(pData) % wordLength) == 0;
+}
+
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 /// \brief Stores unused memory objects (see 
@@ -19,6 +19,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "exceptionImpl.h"
 #include "memoryStreamImpl.h"
 #include <string.h>
+#include <algorithm>
 
 namespace imebra
 {
@@ -158,6 +159,68 @@ bool memoryStreamInput::seekable() const
 }
 
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Chained memory regions
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+memoryChainStreamInput::memoryChainStreamInput(const fragments_t& fragments):
+    m_fragments(fragments)
+{
+    m_fragmentsEnd.reserve(m_fragments.size());
+    size_t position(0);
+    for(const fragment& scanFragments: m_fragments)
+    {
+        position += scanFragments.m_size;
+        m_fragmentsEnd.push_back(position);
+    }
+}
+
+
+size_t memoryChainStreamInput::read(size_t startPosition, std::uint8_t* pBuffer, size_t bufferLength)
+{
+    IMEBRA_FUNCTION_START();
+
+    // Find the fragment containing the start position
+    ///////////////////////////////////////////////////////////
+    size_t fragmentIndex(
+                (size_t)(std::upper_bound(m_fragmentsEnd.begin(), m_fragmentsEnd.end(), startPosition) - m_fragmentsEnd.begin()));
+
+    size_t readBytes(0);
+    while(readBytes != bufferLength && fragmentIndex != m_fragments.size())
+    {
+        const fragment& readFragment(m_fragments[fragmentIndex]);
+        const size_t fragmentStart(m_fragmentsEnd[fragmentIndex] - readFragment.m_size);
+        const size_t fragmentOffset(startPosition + readBytes - fragmentStart);
+        const size_t copySize(std::min(bufferLength - readBytes, readFragment.m_size - fragmentOffset));
+
+        ::memcpy(pBuffer + readBytes, readFragment.m_pMemory->data() + readFragment.m_offset + fragmentOffset, copySize);
+        readBytes += copySize;
+        ++fragmentIndex;
+    }
+
+    return readBytes;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void memoryChainStreamInput::terminate()
+{
+
+}
+
+
+bool memoryChainStreamInput::seekable() const
+{
+    return true;
+}
+
+
 } // namespace implementation
 
 } // namespace imebra
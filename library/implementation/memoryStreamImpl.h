@@ -22,6 +22,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "baseStreamImpl.h"
 #include "memoryImpl.h"
 #include <mutex>
+#include <vector>
 
 namespace imebra
 {
@@ -102,6 +103,62 @@ protected:
     std::mutex m_mutex;
 };
 
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+/// \brief An input stream that reads a list of memory
+///         regions as if they were one contiguous block.
+///
+/// Used to parse data received in several fragments
+///  without concatenating them first.
+///
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+class memoryChainStreamInput : public baseStreamInput
+{
+
+public:
+    /// \brief A memory region.
+    ///
+    ///////////////////////////////////////////////////////////
+    struct fragment
+    {
+        std::shared_ptr<const memory> m_pMemory; ///< memory containing the region
+        size_t m_offset;                         ///< offset of the region in m_pMemory
+        size_t m_size;                           ///< region size, in bytes
+    };
+
+    typedef std::vector<fragment> fragments_t;
+
+    /// \brief Construct the stream from a list of memory
+    ///         regions.
+    ///
+    /// The memory objects are kept referenced by the stream.
+    ///
+    /// @param fragments the regions that compose the stream,
+    ///                   in order
+    ///
+    ///////////////////////////////////////////////////////////
+    memoryChainStreamInput(const fragments_t& fragments);
+
+    ///////////////////////////////////////////////////////////
+    //
+    // Virtual stream's functions
+    //
+    ///////////////////////////////////////////////////////////
+    virtual size_t read(size_t startPosition, std::uint8_t* pBuffer, size_t bufferLength) override;
+
+    virtual void terminate() override;
+
+    virtual bool seekable() const override;
+
+protected:
+    const fragments_t m_fragments;
+
+    // Stream position where each fragment ends
+    std::vector<size_t> m_fragmentsEnd;
+};
+
 } // namespace implementation
 
 } // namespace imebra
@@ -35,6 +35,60 @@ namespace implementation
 namespace codecs
 {
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Tags filter that stops after the specified tag
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+tagsFilter::tagsFilter(std::uint16_t stopGroupId, std::uint16_t stopTagId):
+    m_stopTag(((std::uint32_t)stopGroupId << 16) | (std::uint32_t)stopTagId)
+{
+}
+
+
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+//
+//
+// Tags filter that loads only the specified tags
+//
+//
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+tagsFilter::tagsFilter(const std::set<std::pair<std::uint16_t, std::uint16_t> >& tags):
+    m_stopTag(0)
+{
+    for(const std::pair<std::uint16_t, std::uint16_t>& tag: tags)
+    {
+        m_tags.insert(((std::uint32_t)tag.first << 16) | (std::uint32_t)tag.second);
+    }
+    if(!m_tags.empty())
+    {
+        m_stopTag = *(m_tags.rbegin());
+    }
+}
+
+
+bool tagsFilter::isAfterStopTag(std::uint16_t groupId, std::uint16_t tagId) const
+{
+    return groupId != 0x0002 && (((std::uint32_t)groupId << 16) | (std::uint32_t)tagId) > m_stopTag;
+}
+
+
+bool tagsFilter::isLoaded(std::uint16_t groupId, std::uint16_t tagId) const
+{
+    if(m_tags.empty() || groupId == 0x0002 || (groupId == 0x0008 && tagId == 0x0005))
+    {
+        return true;
+    }
+    return m_tags.find(((std::uint32_t)groupId << 16) | (std::uint32_t)tagId) != m_tags.end();
+}
+
+
 streamCodec::~streamCodec()
 {
 }
@@ -49,7 +103,7 @@ streamCodec::~streamCodec()
 //
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
-std::shared_ptr<dataSet> streamCodec::read(std::shared_ptr<streamReader> pSourceStream, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */) const
+std::shared_ptr<dataSet> streamCodec::read(std::shared_ptr<streamReader> pSourceStream, std::uint32_t maxSizeBufferLoad /* = 0xffffffff */, std::shared_ptr<const tagsFilter> pFilter /* = nullptr */) const
 {
     IMEBRA_FUNCTION_START();
 
@@ -59,7 +113,7 @@ std::shared_ptr<dataSet> streamCodec::read(std::shared_ptr<streamReader> pSource
 
     // Read the stream
     ///////////////////////////////////////////////////////////
-    readStream(pSourceStream, pDestDataSet, maxSizeBufferLoad);
+    readStream(pSourceStream, pDestDataSet, maxSizeBufferLoad, pFilter);
 
     return pDestDataSet;
 
@@ -22,6 +22,8 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <stdexcept>
 #include <memory>
 #include <limits>
+#include <set>
+#include <utility>
 #include "memoryImpl.h"
 #include "../include/imebra/definitions.h"
 
@@ -53,6 +55,66 @@ namespace codecs
 ///
 /// @{
 
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+/// \brief Selects the tags that a stream codec loads
+///         from the root dataset.
+///
+/// The filter can specify a stop tag, after which the
+///  codec stops reading the stream, or a list of the tags
+///  to load: in the latter case the codec stops reading
+///  after the last tag in the list.
+///
+/// The tags in the group 0x0002 and the tag 0x0008,0x0005
+///  (charsets) are always loaded because they are
+///  necessary to decode the other tags.
+///
+///////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////
+class tagsFilter
+{
+public:
+    /// \brief Load all the tags up to the specified one,
+    ///         included.
+    ///
+    /// @param stopGroupId the group of the last tag to load
+    /// @param stopTagId   the id of the last tag to load
+    ///
+    ///////////////////////////////////////////////////////////
+    tagsFilter(std::uint16_t stopGroupId, std::uint16_t stopTagId);
+
+    /// \brief Load only the specified tags.
+    ///
+    /// @param tags the list of the tags to load. Each
+    ///              pair contains the tag's group and id
+    ///
+    ///////////////////////////////////////////////////////////
+    tagsFilter(const std::set<std::pair<std::uint16_t, std::uint16_t> >& tags);
+
+    /// \brief Returns true if the specified tag follows the
+    ///         last tag that has to be loaded.
+    ///
+    /// Because the tags in the root dataset are sorted, the
+    ///  codec can stop reading the stream when this function
+    ///  returns true.
+    ///
+    ///////////////////////////////////////////////////////////
+    bool isAfterStopTag(std::uint16_t groupId, std::uint16_t tagId) const;
+
+    /// \brief Returns true if the specified tag has to be
+    ///         loaded.
+    ///
+    ///////////////////////////////////////////////////////////
+    bool isLoaded(std::uint16_t groupId, std::uint16_t tagId) const;
+
+private:
+    std::uint32_t m_stopTag;
+
+    // Empty when all the tags up to m_stopTag are loaded
+    std::set<std::uint32_t> m_tags;
+};
+
+
 ///////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////
 /// \brief This is the base class for all the Imebra
@@ -127,10 +189,13 @@ public:
     ///                 ignore this parameter.
     ///                Set to -1 to load all the buffers
     ///                 immediatly
+    /// @param pFilter  selects the tags to load. When null
+    ///                 all the tags are loaded. Some codecs
+    ///                 may ignore this parameter.
     /// @return        a pointer to the loaded dataSet
     ///
     ///////////////////////////////////////////////////////////
-    std::shared_ptr<dataSet> read(std::shared_ptr<streamReader> pSourceStream, std::uint32_t maxSizeBufferLoad = std::numeric_limits<std::uint32_t>::max()) const;
+    std::shared_ptr<dataSet> read(std::shared_ptr<streamReader> pSourceStream, std::uint32_t maxSizeBufferLoad = std::numeric_limits<std::uint32_t>::max(), std::shared_ptr<const tagsFilter> pFilter = nullptr) const;
 
     /// \brief Write a dicom structure into a stream.
     ///
@@ -150,7 +215,7 @@ public:
     //@}
 
 protected:
-    virtual void readStream(std::shared_ptr<streamReader> pInputStream, std::shared_ptr<dataSet> pDestDataSet, std::uint32_t maxSizeBufferLoad = std::numeric_limits<std::uint32_t>::max()) const = 0;
+    virtual void readStream(std::shared_ptr<streamReader> pInputStream, std::shared_ptr<dataSet> pDestDataSet, std::uint32_t maxSizeBufferLoad = std::numeric_limits<std::uint32_t>::max(), std::shared_ptr<const tagsFilter> pFilter = nullptr) const = 0;
     virtual void writeStream(std::shared_ptr<streamWriter> pDestStream, std::shared_ptr<dataSet> pSourceDataSet) const = 0;
 };
 
@@ -18,6 +18,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 
 #include "streamControllerImpl.h"
 #include <memory.h>
+#include <algorithm>
 
 namespace imebra
 {
@@ -33,9 +34,9 @@ static const streamController::tByteOrdering m_platformByteOrder((*pBytePointer)
 // Constructor
 //
 ///////////////////////////////////////////////////////////
-streamController::streamController(size_t virtualStart /* =0 */, size_t virtualLength /* =0 */):
+streamController::streamController(size_t virtualStart, size_t virtualLength, size_t dataBufferSize):
     m_bJpegTags(false),
-        m_dataBuffer(size_t(IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE), 0),
+        m_dataBuffer(dataBufferSize, 0),
         m_virtualStart(virtualStart),
         m_virtualLength(virtualLength),
         m_dataBufferStreamPosition(0),
@@ -44,10 +45,10 @@ streamController::streamController(size_t virtualStart /* =0 */, size_t virtualL
 }
 
 
-streamController::streamController(size_t virtualStart, size_t virtualLength,
+streamController::streamController(size_t virtualStart, size_t virtualLength, size_t dataBufferSize,
                  std::uint8_t* pBuffer, size_t bufferSize):
     m_bJpegTags(false),
-        m_dataBuffer(size_t(IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE), 0),
+        m_dataBuffer(std::max(dataBufferSize, bufferSize), 0),
         m_virtualStart(virtualStart),
         m_virtualLength(virtualLength),
         m_dataBufferStreamPosition(0),
@@ -69,6 +70,21 @@ streamController::~streamController()
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Calculate the size of the data buffer
+//
+///////////////////////////////////////////////////////////
+size_t streamController::getDataBufferSize(size_t preferredSize, size_t virtualLength)
+{
+    if(virtualLength != 0 && virtualLength < preferredSize)
+    {
+        preferredSize = virtualLength;
+    }
+    return preferredSize == 0 ? 1 : preferredSize;
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Retrieve the current position
@@ -46,10 +46,6 @@ namespace imebra
 class streamController
 {
 
-#if(!defined IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE)
-    #define IMEBRA_STREAM_CONTROLLER_MEMORY_SIZE 4096
-#endif
-
 public:
     /// \brief Construct the stream controller and connect it
     ///         to a stream.
@@ -68,11 +64,21 @@ public:
     ///                          An EOF will be issued if the
     ///                           application tries to read
     ///                           beyond the virtual length
+    /// @param dataBufferSize    the size of the buffer used
+    ///                           for buffered IO
     ///
     ///////////////////////////////////////////////////////////
-    streamController(size_t virtualStart = 0, size_t virtualLength = 0);
+    streamController(size_t virtualStart, size_t virtualLength, size_t dataBufferSize);
 
-    streamController(size_t virtualStart, size_t virtualLength,
+    /// \brief Construct the stream controller and fill its
+    ///         buffer with data already read from the
+    ///         controlled stream.
+    ///
+    /// The buffer is enlarged to bufferSize if
+    ///  dataBufferSize is smaller.
+    ///
+    ///////////////////////////////////////////////////////////
+    streamController(size_t virtualStart, size_t virtualLength, size_t dataBufferSize,
                      std::uint8_t* pBuffer, size_t bufferSize);
 
     virtual ~streamController();
@@ -182,6 +188,19 @@ public:
 
 
 protected:
+    /// \brief Return the size of the buffer to allocate for
+    ///         a controller that sees virtualLength bytes.
+    ///
+    /// @param preferredSize the buffer size preferred by the
+    ///                       controlled stream
+    /// @param virtualLength the number of visible bytes, or 0
+    ///                       if all the bytes are visible
+    /// @return the smaller between preferredSize and
+    ///          virtualLength, at least 1
+    ///
+    ///////////////////////////////////////////////////////////
+    static size_t getDataBufferSize(size_t preferredSize, size_t virtualLength);
+
     /// \brief Used for buffered IO
     ///
     ///////////////////////////////////////////////////////////
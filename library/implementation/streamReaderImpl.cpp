@@ -20,6 +20,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "streamWriterImpl.h"
 #include <string.h>
 #include <vector>
+#include <algorithm>
 
 namespace imebra
 {
@@ -33,13 +34,13 @@ namespace implementation
 //
 ///////////////////////////////////////////////////////////
 streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream):
-    streamController(0, 0),
+    streamController(0, 0, getDataBufferSize(pControlledStream->getPreferredBufferSize(), 0)),
     m_pControlledStream(pControlledStream)
 {
 }
 
 streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream, size_t virtualStart, size_t virtualLength):
-    streamController(virtualStart, virtualLength),
+    streamController(virtualStart, virtualLength, getDataBufferSize(pControlledStream->getPreferredBufferSize(), virtualLength)),
     m_pControlledStream(pControlledStream)
 {
     IMEBRA_FUNCTION_START();
@@ -54,7 +55,7 @@ streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream, s
 
 
 streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream, size_t virtualStart, size_t virtualLength, std::uint8_t* pBuffer, size_t bufferLength):
-    streamController(virtualStart, virtualLength, pBuffer, bufferLength),
+    streamController(virtualStart, virtualLength, getDataBufferSize(pControlledStream->getPreferredBufferSize(), virtualLength), pBuffer, bufferLength),
     m_pControlledStream(pControlledStream)
 {
     IMEBRA_FUNCTION_START();
@@ -69,7 +70,7 @@ streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream, s
 
 
 streamReader::streamReader(std::shared_ptr<baseStreamInput> pControlledStream, size_t virtualStart, std::uint8_t* pBuffer, size_t bufferLength):
-    streamController(virtualStart, 0, pBuffer, bufferLength),
+    streamController(virtualStart, 0, getDataBufferSize(pControlledStream->getPreferredBufferSize(), 0), pBuffer, bufferLength),
     m_pControlledStream(pControlledStream)
 {
 }
@@ -165,6 +166,40 @@ bool streamReader::endReached()
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Return the amount of data already in the buffer
+//
+///////////////////////////////////////////////////////////
+size_t streamReader::getBufferedSize() const
+{
+    return m_dataBufferEnd - m_dataBufferCurrent;
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Resize the data buffer, keeping the data not yet
+//  consumed
+//
+///////////////////////////////////////////////////////////
+void streamReader::setBufferSize(size_t bufferSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    const size_t bufferedSize(m_dataBufferEnd - m_dataBufferCurrent);
+    std::basic_string<std::uint8_t> newBuffer(std::max(getDataBufferSize(bufferSize, m_virtualLength), bufferedSize), 0);
+    ::memcpy(&(newBuffer[0]), &(m_dataBuffer[m_dataBufferCurrent]), bufferedSize);
+
+    m_dataBuffer.swap(newBuffer);
+    m_dataBufferStreamPosition += m_dataBufferCurrent;
+    m_dataBufferCurrent = 0;
+    m_dataBufferEnd = bufferedSize;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Refill the data buffer
@@ -159,6 +159,26 @@ public:
     ///////////////////////////////////////////////////////////
     bool endReached();
 
+    /// \brief Returns the number of bytes already read from
+    ///         the controlled stream and not yet consumed.
+    ///
+    /// @return the number of bytes that can be read without
+    ///          accessing the controlled stream
+    ///
+    ///////////////////////////////////////////////////////////
+    size_t getBufferedSize() const;
+
+    /// \brief Change the size of the buffer used to read
+    ///         from the controlled stream.
+    ///
+    /// The data already buffered and not yet consumed is
+    ///  preserved. Reads larger than the buffer bypass it.
+    ///
+    /// @param bufferSize the new buffer size, in bytes
+    ///
+    ///////////////////////////////////////////////////////////
+    void setBufferSize(size_t bufferSize);
+
 private:
     friend class forwardStream;
 
@@ -17,6 +17,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 */
 
 #include "streamWriterImpl.h"
+#include "memoryImpl.h"
 #include <string.h>
 #include "../include/imebra/exceptions.h"
 
@@ -32,7 +33,7 @@ namespace implementation
 //
 ///////////////////////////////////////////////////////////
 streamWriter::streamWriter(std::shared_ptr<baseStreamOutput> pControlledStream):
-    streamController(0, 0),
+    streamController(0, 0, getDataBufferSize(pControlledStream->getPreferredBufferSize(), 0)),
     m_pControlledStream(pControlledStream),
     m_outBitsBuffer(0),
     m_outBitsNum(0)
@@ -46,7 +47,7 @@ streamWriter::streamWriter(std::shared_ptr<baseStreamOutput> pControlledStream):
 //
 ///////////////////////////////////////////////////////////
 streamWriter::streamWriter(std::shared_ptr<baseStreamOutput> pControlledStream, size_t virtualStart, size_t virtualLength):
-    streamController(virtualStart, virtualLength),
+    streamController(virtualStart, virtualLength, getDataBufferSize(pControlledStream->getPreferredBufferSize(), virtualLength)),
     m_pControlledStream(pControlledStream),
     m_outBitsBuffer(0),
     m_outBitsNum(0)
@@ -93,6 +94,22 @@ void streamWriter::flushDataBuffer()
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Resize the data buffer
+//
+///////////////////////////////////////////////////////////
+void streamWriter::setBufferSize(size_t bufferSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    flushDataBuffer();
+    m_dataBuffer.assign(getDataBufferSize(bufferSize, m_virtualLength), 0);
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Write into the stream
@@ -102,17 +119,35 @@ void streamWriter::write(const std::uint8_t* pBuffer, size_t bufferLength)
 {
     IMEBRA_FUNCTION_START();
 
+    // Writes larger than the buffer bypass it: the data
+    //  already in the buffer and the new one are handed
+    //  to the stream with a single call
+    ///////////////////////////////////////////////////////////
+    if(bufferLength >= m_dataBuffer.size())
+    {
+        if(m_dataBufferCurrent == 0)
+        {
+            m_pControlledStream->write(m_dataBufferStreamPosition + m_virtualStart, pBuffer, bufferLength);
+        }
+        else
+        {
+            baseStreamOutput::outputBuffers_t buffers(2);
+            buffers[0].m_pBuffer = m_dataBuffer.data();
+            buffers[0].m_bufferLength = m_dataBufferCurrent;
+            buffers[1].m_pBuffer = pBuffer;
+            buffers[1].m_bufferLength = bufferLength;
+            m_pControlledStream->write(m_dataBufferStreamPosition + m_virtualStart, buffers);
+        }
+        m_dataBufferStreamPosition += m_dataBufferCurrent + bufferLength;
+        m_dataBufferCurrent = 0;
+        return;
+    }
+
     while(bufferLength != 0)
     {
         if(m_dataBufferCurrent == m_dataBuffer.size())
         {
             flushDataBuffer();
-            if(bufferLength > (size_t)(m_dataBuffer.size() - m_dataBufferCurrent) )
-            {
-                m_pControlledStream->write(m_dataBufferStreamPosition + m_virtualStart, pBuffer, bufferLength);
-                m_dataBufferStreamPosition += bufferLength;
-                return;
-            }
         }
         size_t copySize = (size_t)(m_dataBuffer.size() - m_dataBufferCurrent);
         if(copySize > bufferLength)
@@ -128,6 +163,51 @@ void streamWriter::write(const std::uint8_t* pBuffer, size_t bufferLength)
     IMEBRA_FUNCTION_END();
 }
 
+
+///////////////////////////////////////////////////////////
+//
+// Write several buffers into the stream
+//
+///////////////////////////////////////////////////////////
+void streamWriter::write(const baseStreamOutput::outputBuffers_t& buffers)
+{
+    IMEBRA_FUNCTION_START();
+
+    flushDataBuffer();
+
+    m_pControlledStream->write(m_dataBufferStreamPosition + m_virtualStart, buffers);
+    for(const baseStreamOutput::outputBuffer& writtenBuffer: buffers)
+    {
+        m_dataBufferStreamPosition += writtenBuffer.m_bufferLength;
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+///////////////////////////////////////////////////////////
+//
+// Write a memory object into the stream
+//
+///////////////////////////////////////////////////////////
+void streamWriter::write(const std::shared_ptr<const memory>& pMemory)
+{
+    IMEBRA_FUNCTION_START();
+
+    if(pMemory->size() <= (size_t)(m_dataBuffer.size() - m_dataBufferCurrent))
+    {
+        write(pMemory->data(), pMemory->size());
+        return;
+    }
+
+    flushDataBuffer();
+
+    m_pControlledStream->write(m_dataBufferStreamPosition + m_virtualStart, pMemory);
+    m_dataBufferStreamPosition += pMemory->size();
+
+    IMEBRA_FUNCTION_END();
+}
+
 } // namespace implementation
 
 } // namespace imebra
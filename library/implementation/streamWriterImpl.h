@@ -78,6 +78,15 @@ public:
 	///////////////////////////////////////////////////////////
 	void flushDataBuffer();
 
+    /// \brief Flush the internal buffer and change its size.
+    ///
+    /// Writes larger than the buffer bypass it.
+    ///
+    /// @param bufferSize the new buffer size, in bytes
+    ///
+    ///////////////////////////////////////////////////////////
+    void setBufferSize(size_t bufferSize);
+
 	/// \brief Write raw data into the stream.
 	///
 	/// The data stored in the pBuffer parameter will be
@@ -95,6 +104,33 @@ public:
 	///////////////////////////////////////////////////////////
     void write(const std::uint8_t* pBuffer, size_t bufferLength);
 
+    /// \brief Write several buffers into the stream with a
+    ///         single call to the controlled stream.
+    ///
+    /// The internal buffer is flushed first, then the
+    ///  buffers are handed to the stream together, so
+    ///  streams that support vectored I/O can send them
+    ///  without copying.
+    ///
+    /// @param buffers the buffers to write
+    ///
+    ///////////////////////////////////////////////////////////
+    void write(const baseStreamOutput::outputBuffers_t& buffers);
+
+    /// \brief Write the content of a memory object into the
+    ///         stream.
+    ///
+    /// Small memory objects are copied into the internal
+    ///  buffer, larger ones are handed to the stream which
+    ///  may keep a reference to them instead of copying
+    ///  their content.
+    ///
+    /// @param pMemory the memory to write. Must not be
+    ///                modified afterwards
+    ///
+    ///////////////////////////////////////////////////////////
+    void write(const std::shared_ptr<const memory>& pMemory);
+
 	/// \brief Write the specified amount of bits to the
 	///         stream.
 	///
@@ -0,0 +1,378 @@
+/*
+Copyright 2005 - 2017 by Paolo Brandoli/Binarno s.p.
+
+Imebra is available for free under the GNU General Public License.
+
+The full text of the license is available in the file license.rst
+ in the project root folder.
+
+If you do not want to be bound by the GPL terms (such as the requirement
+ that your application must also be GPL), you may purchase a commercial
+ license for Imebra from the Imebra’s website (http://imebra.com).
+*/
+
+/*! \file tcpReactorImpl.cpp
+    \brief Implementation of the reactor that waits for
+           incoming data on several TCP sockets.
+
+*/
+
+#include "tcpReactorImpl.h"
+#include "exceptionImpl.h"
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+namespace imebra
+{
+
+namespace implementation
+{
+
+namespace
+{
+
+///////////////////////////////////////////////////////////
+//
+// Settings shared by all the associations
+//
+///////////////////////////////////////////////////////////
+struct reactorSettings
+{
+    reactorSettings():
+        m_workerThreads(IMEBRA_TCP_REACTOR_THREADS)
+    {
+    }
+
+    std::mutex m_lock;
+    size_t m_workerThreads;
+    std::shared_ptr<tcpReactor> m_pReactor;
+};
+
+reactorSettings& getReactorSettings()
+{
+    static reactorSettings settings;
+    return settings;
+}
+
+// Id reported by epoll when the reactor is being destroyed
+const std::uint64_t wakeUpId(0);
+
+}
+
+
+void tcpReactor::setWorkerThreads(size_t workerThreads)
+{
+    reactorSettings& settings(getReactorSettings());
+    std::unique_lock<std::mutex> lock(settings.m_lock);
+    if(settings.m_workerThreads != workerThreads)
+    {
+        settings.m_workerThreads = workerThreads;
+        settings.m_pReactor.reset();
+    }
+}
+
+
+std::shared_ptr<tcpReactor> tcpReactor::getReactor()
+{
+    IMEBRA_FUNCTION_START();
+
+#if defined(__linux__)
+    reactorSettings& settings(getReactorSettings());
+    std::unique_lock<std::mutex> lock(settings.m_lock);
+    if(settings.m_pReactor == nullptr && settings.m_workerThreads != 0)
+    {
+        settings.m_pReactor = std::make_shared<tcpReactor>(settings.m_workerThreads);
+    }
+    return settings.m_pReactor;
+#else
+    return nullptr;
+#endif
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+#if defined(__linux__)
+
+tcpReactor::tcpReactor(size_t workerThreads):
+    m_nextSocketId(wakeUpId + 1),
+    m_bTerminate(false),
+    m_epoll(epoll_create1(EPOLL_CLOEXEC)),
+    m_wakeUp(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+{
+    IMEBRA_FUNCTION_START();
+
+    if(m_epoll < 0 || m_wakeUp < 0)
+    {
+        if(m_epoll >= 0)
+        {
+            ::close(m_epoll);
+        }
+        if(m_wakeUp >= 0)
+        {
+            ::close(m_wakeUp);
+        }
+        IMEBRA_THROW(std::runtime_error, "Cannot create the epoll reactor");
+    }
+
+    epoll_event wakeUpEvent;
+    wakeUpEvent.events = EPOLLIN;
+    wakeUpEvent.data.u64 = wakeUpId;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeUp, &wakeUpEvent);
+
+    m_epollThread = std::thread(&tcpReactor::epollThread, this);
+    for(size_t scanThreads(0); scanThreads != workerThreads; ++scanThreads)
+    {
+        m_workerThreads.emplace_back(&tcpReactor::workerThread, this);
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+tcpReactor::~tcpReactor()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_bTerminate = true;
+    }
+    std::uint64_t wakeUp(1);
+    if(::write(m_wakeUp, &wakeUp, sizeof(wakeUp)) < 0)
+    {
+        // Cannot fail: the eventfd counter is far from overflowing
+    }
+    m_notifyReady.notify_all();
+
+    m_epollThread.join();
+    for(std::thread& workerThread: m_workerThreads)
+    {
+        workerThread.join();
+    }
+
+    ::close(m_wakeUp);
+    ::close(m_epoll);
+}
+
+
+std::uint64_t tcpReactor::addSocket(int socket, readHandler_t handler, bool bReadyNow)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    const std::uint64_t socketId(m_nextSocketId++);
+    watchedSocket& watched(m_sockets[socketId]);
+    watched.m_socket = socket;
+    watched.m_handler = handler;
+    watched.m_bRunning = false;
+    watched.m_bRemoved = false;
+
+    try
+    {
+        watch(socket, socketId, true, !bReadyNow);
+    }
+    catch(...)
+    {
+        m_sockets.erase(socketId);
+        throw;
+    }
+
+    if(bReadyNow)
+    {
+        // The socket stays disarmed until the handler has
+        // consumed the data already available
+        m_readySockets.push_back(socketId);
+        m_notifyReady.notify_one();
+    }
+
+    return socketId;
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void tcpReactor::removeSocket(std::uint64_t socketId)
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    std::map<std::uint64_t, watchedSocket>::iterator findSocket(m_sockets.find(socketId));
+    if(findSocket == m_sockets.end())
+    {
+        // Already removed by its handler
+        return;
+    }
+
+    findSocket->second.m_bRemoved = true;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, findSocket->second.m_socket, nullptr);
+
+    while(findSocket->second.m_bRunning)
+    {
+        m_notifyIdle.wait(lock);
+    }
+    m_sockets.erase(findSocket);
+}
+
+
+void tcpReactor::watch(int socket, std::uint64_t socketId, bool bAdd, bool bArm)
+{
+    IMEBRA_FUNCTION_START();
+
+    epoll_event event;
+    event.events = bArm ? (EPOLLIN | EPOLLRDHUP | EPOLLONESHOT) : EPOLLONESHOT;
+    event.data.u64 = socketId;
+    if(epoll_ctl(m_epoll, bAdd ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, socket, &event) < 0)
+    {
+        IMEBRA_THROW(std::runtime_error, "Cannot watch the socket with epoll, error " << errno);
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void tcpReactor::epollThread()
+{
+    epoll_event events[64];
+
+    for(;;)
+    {
+        int eventsCount(epoll_wait(m_epoll, events, sizeof(events) / sizeof(events[0]), -1));
+        if(eventsCount < 0 && errno != EINTR)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_lock);
+        if(m_bTerminate)
+        {
+            return;
+        }
+
+        for(int scanEvents(0); scanEvents < eventsCount; ++scanEvents)
+        {
+            const std::uint64_t socketId(events[scanEvents].data.u64);
+            if(socketId != wakeUpId && m_sockets.find(socketId) != m_sockets.end())
+            {
+                m_readySockets.push_back(socketId);
+                m_notifyReady.notify_one();
+            }
+        }
+    }
+}
+
+
+void tcpReactor::workerThread()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    for(;;)
+    {
+        while(!m_bTerminate && m_readySockets.empty())
+        {
+            m_notifyReady.wait(lock);
+        }
+        if(m_bTerminate)
+        {
+            return;
+        }
+
+        const std::uint64_t socketId(m_readySockets.front());
+        m_readySockets.pop_front();
+
+        // The entry stays in the map while the handler is
+        // running: removeSocket() waits for it
+        ///////////////////////////////////////////////////////////
+        std::map<std::uint64_t, watchedSocket>::iterator findSocket(m_sockets.find(socketId));
+        if(findSocket == m_sockets.end() || findSocket->second.m_bRemoved || findSocket->second.m_bRunning)
+        {
+            continue;
+        }
+        watchedSocket& watched(findSocket->second);
+        watched.m_bRunning = true;
+
+        lock.unlock();
+        bool bKeepWatching(false);
+        try
+        {
+            bKeepWatching = watched.m_handler();
+        }
+        catch(...)
+        {
+            // A worker serves all the sockets: a failing handler
+            // only stops watching its own socket
+        }
+        lock.lock();
+
+        watched.m_bRunning = false;
+        if(watched.m_bRemoved)
+        {
+            m_notifyIdle.notify_all();
+            continue;
+        }
+
+        if(bKeepWatching)
+        {
+            try
+            {
+                watch(watched.m_socket, socketId, false, true);
+                continue;
+            }
+            catch(...)
+            {
+            }
+        }
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, watched.m_socket, nullptr);
+        m_sockets.erase(findSocket);
+    }
+}
+
+#else
+
+tcpReactor::tcpReactor(size_t)
+{
+    IMEBRA_FUNCTION_START();
+
+    IMEBRA_THROW(std::logic_error, "The TCP reactor is available on Linux only");
+
+    IMEBRA_FUNCTION_END();
+}
+
+tcpReactor::~tcpReactor()
+{
+}
+
+std::uint64_t tcpReactor::addSocket(int, readHandler_t, bool)
+{
+    IMEBRA_FUNCTION_START();
+
+    IMEBRA_THROW(std::logic_error, "The TCP reactor is available on Linux only");
+
+    IMEBRA_FUNCTION_END();
+}
+
+void tcpReactor::removeSocket(std::uint64_t)
+{
+}
+
+void tcpReactor::watch(int, std::uint64_t, bool, bool)
+{
+}
+
+void tcpReactor::epollThread()
+{
+}
+
+void tcpReactor::workerThread()
+{
+}
+
+#endif
+
+} // namespace implementation
+
+} // namespace imebra
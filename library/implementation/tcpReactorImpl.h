@@ -0,0 +1,187 @@
+/*
+Copyright 2005 - 2017 by Paolo Brandoli/Binarno s.p.
+
+Imebra is available for free under the GNU General Public License.
+
+The full text of the license is available in the file license.rst
+ in the project root folder.
+
+If you do not want to be bound by the GPL terms (such as the requirement
+ that your application must also be GPL), you may purchase a commercial
+ license for Imebra from the Imebra’s website (http://imebra.com).
+*/
+
+/*! \file tcpReactorImpl.h
+    \brief Declaration of the reactor that waits for incoming
+           data on several TCP sockets.
+
+*/
+
+#if !defined(imebraTcpReactor_8D1E0C6A_3F7B_4C55_A2E4_5B9D1F0A7C31__INCLUDED_)
+#define imebraTcpReactor_8D1E0C6A_3F7B_4C55_A2E4_5B9D1F0A7C31__INCLUDED_
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "configurationImpl.h"
+
+///
+/// \brief Number of worker threads used by the reactor.
+///
+/// 0 disables the reactor: each association reads its
+/// messages in a dedicated thread.
+///
+///////////////////////////////////////////////////////////
+#if(!defined IMEBRA_TCP_REACTOR_THREADS)
+    #define IMEBRA_TCP_REACTOR_THREADS 0
+#endif
+
+namespace imebra
+{
+
+namespace implementation
+{
+
+///
+/// \brief Waits for incoming data on several sockets with a
+///        single epoll thread and runs the handler of the
+///        readable sockets on a fixed pool of worker threads.
+///
+/// A socket is watched in one-shot mode: while its handler
+/// runs the socket is not reported again, so the handler
+/// of a socket never runs on two threads at the same time.
+/// When the handler returns true the socket is watched
+/// again, when it returns false it is removed.
+///
+/// The reactor is available on Linux only: on the other
+/// platforms getReactor() always returns a null pointer.
+///
+///////////////////////////////////////////////////////////
+class tcpReactor
+{
+public:
+    typedef std::function<bool()> readHandler_t;
+
+    ///
+    /// \brief Constructor. Starts the epoll thread and the
+    ///        worker threads.
+    ///
+    /// \param workerThreads number of threads that run the
+    ///                      handlers
+    ///
+    ///////////////////////////////////////////////////////////
+    tcpReactor(size_t workerThreads);
+
+    ///
+    /// \brief Destructor. Stops and joins the threads.
+    ///
+    ///////////////////////////////////////////////////////////
+    ~tcpReactor();
+
+    ///
+    /// \brief Set the number of worker threads used by the
+    ///        reactor returned by the subsequent calls to
+    ///        getReactor().
+    ///
+    /// The sockets already added to a reactor keep using it.
+    ///
+    /// \param workerThreads number of worker threads. 0
+    ///                      disables the reactor
+    ///
+    ///////////////////////////////////////////////////////////
+    static void setWorkerThreads(size_t workerThreads);
+
+    ///
+    /// \brief Return the shared reactor.
+    ///
+    /// \return the shared reactor, or a null pointer if the
+    ///         reactor is disabled or not available on this
+    ///         platform
+    ///
+    ///////////////////////////////////////////////////////////
+    static std::shared_ptr<tcpReactor> getReactor();
+
+    ///
+    /// \brief Start watching a socket.
+    ///
+    /// \param socket   the socket to watch
+    /// \param handler  function called on a worker thread
+    ///                 when the socket becomes readable
+    ///                 (or is closed by the peer)
+    /// \param bReadyNow true if data is already available
+    ///                 (e.g. in the buffer of a reader), in
+    ///                 which case the handler is scheduled
+    ///                 immediately
+    /// \return an id to pass to removeSocket()
+    ///
+    ///////////////////////////////////////////////////////////
+    std::uint64_t addSocket(int socket, readHandler_t handler, bool bReadyNow);
+
+    ///
+    /// \brief Stop watching a socket.
+    ///
+    /// Waits for the socket's handler to return if it is
+    /// running: the caller should first cause the pending
+    /// reads to fail (e.g. by terminating the stream).
+    ///
+    /// \param socketId the id returned by addSocket()
+    ///
+    ///////////////////////////////////////////////////////////
+    void removeSocket(std::uint64_t socketId);
+
+private:
+    void epollThread();
+
+    void workerThread();
+
+    ///
+    /// \brief Add or modify the socket in the epoll set, in
+    ///        one-shot mode.
+    ///
+    /// \param socket   the socket
+    /// \param socketId the id reported by epoll
+    /// \param bAdd     true to add the socket, false to
+    ///                 modify it
+    /// \param bArm     true to watch for incoming data, false
+    ///                 to leave the socket disarmed
+    ///
+    ///////////////////////////////////////////////////////////
+    void watch(int socket, std::uint64_t socketId, bool bAdd, bool bArm);
+
+    struct watchedSocket
+    {
+        int m_socket;
+        readHandler_t m_handler;
+        bool m_bRunning;
+        bool m_bRemoved;
+    };
+
+    std::mutex m_lock;
+    std::condition_variable m_notifyReady;
+    std::condition_variable m_notifyIdle;
+
+    std::map<std::uint64_t, watchedSocket> m_sockets;
+    std::list<std::uint64_t> m_readySockets;
+    std::uint64_t m_nextSocketId;
+
+    bool m_bTerminate;
+
+    int m_epoll;
+    int m_wakeUp;
+
+    std::thread m_epollThread;
+    std::vector<std::thread> m_workerThreads;
+};
+
+} // namespace implementation
+
+} // namespace imebra
+
+#endif // !defined(imebraTcpReactor_8D1E0C6A_3F7B_4C55_A2E4_5B9D1F0A7C31__INCLUDED_)
@@ -19,6 +19,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "tcpSequenceStreamImpl.h"
 #include "../include/imebra/exceptions.h"
 #include <string.h>
+#include <algorithm>
 
 #ifdef IMEBRA_WINDOWS
 
@@ -28,10 +29,13 @@ If you do not want to be bound by the GPL terms (such as the requirement
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <poll.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 
 #endif
 
@@ -455,6 +459,42 @@ void tcpBaseSocket::setBlockingMode(bool bBlocking)
 }
 
 
+void tcpBaseSocket::setBufferSizes(std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    if(sendBufferSize != 0)
+    {
+        int size((int)sendBufferSize);
+        throwTcpException(setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, (const char*)&size, sizeof(size)));
+    }
+    if(receiveBufferSize != 0)
+    {
+        int size((int)receiveBufferSize);
+        throwTcpException(setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, (const char*)&size, sizeof(size)));
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+void tcpBaseSocket::setNoDelay(bool bNoDelay)
+{
+    IMEBRA_FUNCTION_START();
+
+    int noDelay(bNoDelay ? 1 : 0);
+    throwTcpException(setsockopt(m_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay)));
+
+    IMEBRA_FUNCTION_END();
+}
+
+
+int tcpBaseSocket::getSocket() const
+{
+    return m_socket;
+}
+
+
 void tcpBaseSocket::terminate()
 {
     m_bTerminate.store(true);
@@ -546,11 +586,24 @@ tcpSequenceStream::tcpSequenceStream(int tcpSocket, std::shared_ptr<tcpAddress>
 }
 
 tcpSequenceStream::tcpSequenceStream(std::shared_ptr<tcpAddress> pAddress):
+    tcpSequenceStream(pAddress, 0, 0, false)
+{
+}
+
+tcpSequenceStream::tcpSequenceStream(std::shared_ptr<tcpAddress> pAddress, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize, bool bNoDelay):
     tcpBaseSocket((int)throwTcpException(socket(pAddress->getFamily(), pAddress->getType(), pAddress->getProtocol()))),
     m_pAddress(pAddress)
 {
     IMEBRA_FUNCTION_START();
 
+    // The buffer sizes must be set before connecting, so the
+    // window scale is negotiated for them
+    setBufferSizes(sendBufferSize, receiveBufferSize);
+    if(bNoDelay)
+    {
+        setNoDelay(true);
+    }
+
 #if !defined(IMEBRA_WINDOWS) && (__linux__ != 1)
     // Disable SIGPIPE
     int sigpipe = 1;
@@ -644,6 +697,43 @@ size_t tcpSequenceStream::read(std::uint8_t* pBuffer, size_t bufferLength)
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Read the data already received by the socket, without
+// waiting
+//
+///////////////////////////////////////////////////////////
+size_t tcpSequenceStream::readAvailable(std::uint8_t* pBuffer, size_t bufferLength)
+{
+    IMEBRA_FUNCTION_START();
+
+    isTerminating();
+
+#if defined(MSG_DONTWAIT)
+    try
+    {
+        long receivedBytes(throwTcpException(recv(m_socket, (char*)pBuffer, bufferLength, MSG_DONTWAIT)));
+        if(receivedBytes == 0 && bufferLength != 0)
+        {
+            IMEBRA_THROW(StreamClosedError, "The socket has been closed");
+        }
+        return (size_t)receivedBytes;
+    }
+    catch(const SocketTimeout&)
+    {
+        // No data available
+        return 0;
+    }
+#else
+    (void)pBuffer;
+    (void)bufferLength;
+    IMEBRA_THROW(std::logic_error, "Non blocking reads are not supported on this platform");
+#endif
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Write into the TCP stream
@@ -693,6 +783,114 @@ void tcpSequenceStream::write(const std::uint8_t* pBuffer, size_t bufferLength)
 }
 
 
+///////////////////////////////////////////////////////////
+//
+// Send several buffers with one system call
+//
+///////////////////////////////////////////////////////////
+void tcpSequenceStream::write(const baseStreamOutput::outputBuffers_t& buffers)
+{
+    IMEBRA_FUNCTION_START();
+
+    tcpTerminateWaiting waiting(*this);
+
+#ifdef IMEBRA_WINDOWS
+    typedef WSABUF ioVector_t;
+    const size_t maxIoVectors(1024);
+#else
+    typedef struct iovec ioVector_t;
+#if defined(IOV_MAX)
+    const size_t maxIoVectors(IOV_MAX);
+#else
+    const size_t maxIoVectors(16);
+#endif
+#endif
+    std::vector<ioVector_t> ioVectors;
+    ioVectors.reserve(std::min(buffers.size(), maxIoVectors));
+
+    // Loop until all the buffers are sent or the termination
+    // is triggered
+    ///////////////////////////////////////////////////////////
+    size_t firstBuffer(0);
+    size_t firstBufferOffset(0);
+    while(firstBuffer != buffers.size())
+    {
+        // Skip the buffers already sent and the empty ones
+        ///////////////////////////////////////////////////////////
+        if(firstBufferOffset == buffers[firstBuffer].m_bufferLength)
+        {
+            ++firstBuffer;
+            firstBufferOffset = 0;
+            continue;
+        }
+
+        isTerminating();
+        try
+        {
+            poll(pollType_t::write);
+
+            ioVectors.clear();
+            for(size_t scanBuffers(firstBuffer); scanBuffers != buffers.size() && ioVectors.size() != maxIoVectors; ++scanBuffers)
+            {
+                const size_t offset(scanBuffers == firstBuffer ? firstBufferOffset : 0);
+                if(buffers[scanBuffers].m_bufferLength == offset)
+                {
+                    continue;
+                }
+                ioVector_t ioVector;
+#ifdef IMEBRA_WINDOWS
+                ioVector.buf = (CHAR*)(buffers[scanBuffers].m_pBuffer + offset);
+                ioVector.len = (ULONG)(buffers[scanBuffers].m_bufferLength - offset);
+#else
+                ioVector.iov_base = (void*)(buffers[scanBuffers].m_pBuffer + offset);
+                ioVector.iov_len = buffers[scanBuffers].m_bufferLength - offset;
+#endif
+                ioVectors.push_back(ioVector);
+            }
+
+            // Write anyway. (windows may not signal an error on the
+            // socket via poll, so we will get it via write)
+            ///////////////////////////////////////////////////////////
+#ifdef IMEBRA_WINDOWS
+            DWORD sentBytes(0);
+            throwTcpException((long)WSASend(m_socket, ioVectors.data(), (DWORD)ioVectors.size(), &sentBytes, 0, 0, 0));
+#else
+            struct msghdr message;
+            ::memset(&message, 0, sizeof(message));
+            message.msg_iov = ioVectors.data();
+            message.msg_iovlen = ioVectors.size();
+#if (__linux__ == 1)
+            long sentBytes = throwTcpException((long)sendmsg(m_socket, &message, MSG_NOSIGNAL));
+#else
+            long sentBytes = throwTcpException((long)sendmsg(m_socket, &message, 0));
+#endif
+#endif
+
+            // Advance past the sent data
+            ///////////////////////////////////////////////////////////
+            for(size_t remainingBytes((size_t)sentBytes); remainingBytes != 0; )
+            {
+                const size_t bufferBytes(buffers[firstBuffer].m_bufferLength - firstBufferOffset);
+                if(remainingBytes < bufferBytes)
+                {
+                    firstBufferOffset += remainingBytes;
+                    break;
+                }
+                remainingBytes -= bufferBytes;
+                ++firstBuffer;
+                firstBufferOffset = 0;
+            }
+        }
+        catch(const SocketTimeout&)
+        {
+            // Ignore timeout
+        }
+    }
+
+    IMEBRA_FUNCTION_END();
+}
+
+
 ///////////////////////////////////////////////////////////
 //
 // Get the address of the connected peer
@@ -720,6 +918,21 @@ size_t tcpSequenceStreamInput::read(std::uint8_t* pBuffer, size_t bufferLength)
     return m_pTcpStream->read(pBuffer, bufferLength);
 }
 
+int tcpSequenceStreamInput::getSocket() const
+{
+    return m_pTcpStream->getSocket();
+}
+
+size_t tcpSequenceStreamInput::readAvailable(std::uint8_t* pBuffer, size_t bufferLength)
+{
+    return m_pTcpStream->readAvailable(pBuffer, bufferLength);
+}
+
+size_t tcpSequenceStreamInput::getPreferredBufferSize() const
+{
+    return IMEBRA_TCP_STREAM_BUFFER_SIZE;
+}
+
 void tcpSequenceStreamInput::terminate()
 {
     m_pTcpStream->terminate();
@@ -735,6 +948,16 @@ void tcpSequenceStreamOutput::write(const std::uint8_t* pBuffer, size_t bufferLe
     m_pTcpStream->write(pBuffer, bufferLength);
 }
 
+void tcpSequenceStreamOutput::write(const outputBuffers_t& buffers)
+{
+    m_pTcpStream->write(buffers);
+}
+
+size_t tcpSequenceStreamOutput::getPreferredBufferSize() const
+{
+    return IMEBRA_TCP_STREAM_BUFFER_SIZE;
+}
+
 
 
 ///////////////////////////////////////////////////////////
@@ -743,10 +966,18 @@ void tcpSequenceStreamOutput::write(const std::uint8_t* pBuffer, size_t bufferLe
 //
 ///////////////////////////////////////////////////////////
 tcpListener::tcpListener(std::shared_ptr<tcpAddress> pAddress):
+    tcpListener(pAddress, 0, 0)
+{
+}
+
+tcpListener::tcpListener(std::shared_ptr<tcpAddress> pAddress, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize):
     tcpBaseSocket((int)throwTcpException(socket(pAddress->getFamily(), pAddress->getType(), pAddress->getProtocol())))
 {
     IMEBRA_FUNCTION_START();
 
+    // Set before listen() so the accepted sockets inherit them
+    setBufferSizes(sendBufferSize, receiveBufferSize);
+
     // Connect in non-blocking mode, then enable blocking
     setBlockingMode(false);
 
@@ -41,6 +41,20 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #define IMEBRA_TCP_TIMEOUT_MS 1000
 #endif
 
+///
+/// \brief Size of the buffer allocated by the streamReader
+///        and streamWriter objects connected to a TCP
+///        stream.
+///
+/// A larger buffer receives or sends more data with each
+/// system call; the reads return as soon as some data is
+/// available, so they don't wait for the buffer to fill.
+///
+///////////////////////////////////////////////////////////
+#ifndef IMEBRA_TCP_STREAM_BUFFER_SIZE
+#define IMEBRA_TCP_STREAM_BUFFER_SIZE 65536
+#endif
+
 namespace imebra
 {
 
@@ -137,6 +151,43 @@ public:
     ///////////////////////////////////////////////////////////
     void setBlockingMode(bool bBlocking);
 
+    ///
+    /// \brief Set the size of the socket send and receive
+    ///        buffers (SO_SNDBUF and SO_RCVBUF).
+    ///
+    /// On a listening socket the sizes are inherited by the
+    /// accepted connections; on an active socket they should
+    /// be set before connecting so that the TCP window scale
+    /// can be negotiated accordingly.
+    ///
+    /// \param sendBufferSize    size of the send buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    /// \param receiveBufferSize size of the receive buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    ///
+    ///////////////////////////////////////////////////////////
+    void setBufferSizes(std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize);
+
+    ///
+    /// \brief Enable or disable the Nagle algorithm
+    ///        (TCP_NODELAY).
+    ///
+    /// \param bNoDelay true to send the small segments
+    ///                 immediately, false to coalesce them
+    ///
+    ///////////////////////////////////////////////////////////
+    void setNoDelay(bool bNoDelay);
+
+    ///
+    /// \brief Returns the socket descriptor.
+    ///
+    /// \return the socket descriptor
+    ///
+    ///////////////////////////////////////////////////////////
+    int getSocket() const;
+
     ///
     /// \brief Forces a termination of pending and subsequent
     ///        read and write operations by causing them to
@@ -229,6 +280,27 @@ public:
     ///////////////////////////////////////////////////////////
     tcpSequenceStream(std::shared_ptr<tcpAddress> pAddress);
 
+    ///
+    /// \brief Constructor.
+    ///
+    /// Creates a socket, sets its buffer sizes and the
+    /// TCP_NODELAY option and then connects it to the
+    /// specified address in non-blocking mode.
+    ///
+    /// \param pAddress          the address to which the
+    ///                          socket must be connected
+    /// \param sendBufferSize    size of the send buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    /// \param receiveBufferSize size of the receive buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    /// \param bNoDelay          true to disable the Nagle
+    ///                          algorithm
+    ///
+    ///////////////////////////////////////////////////////////
+    tcpSequenceStream(std::shared_ptr<tcpAddress> pAddress, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize, bool bNoDelay);
+
     ///
     /// \brief Destructor.
     ///
@@ -248,12 +320,40 @@ public:
     ///////////////////////////////////////////////////////////
     std::shared_ptr<tcpAddress> getPeerAddress() const;
 
+    using tcpBaseSocket::setBufferSizes;
+    using tcpBaseSocket::setNoDelay;
+    using tcpBaseSocket::getSocket;
+
     void terminate();
 
 private:
     size_t read(std::uint8_t* pBuffer, size_t bufferLength);
+
+    ///
+    /// \brief Reads the data already received, without
+    ///        waiting for more.
+    ///
+    /// Throws StreamClosedError if the socket has been
+    /// closed or terminated.
+    ///
+    /// \return the number of read bytes, 0 if no data is
+    ///         available
+    ///
+    ///////////////////////////////////////////////////////////
+    size_t readAvailable(std::uint8_t* pBuffer, size_t bufferLength);
+
     void write(const std::uint8_t* pBuffer, size_t bufferLength);
 
+    ///
+    /// \brief Sends several buffers with vectored I/O
+    ///        (sendmsg or WSASend), without copying them
+    ///        into a single buffer first.
+    ///
+    /// \param buffers the buffers to send
+    ///
+    ///////////////////////////////////////////////////////////
+    void write(const baseStreamOutput::outputBuffers_t& buffers);
+
     const std::shared_ptr<tcpAddress> m_pAddress;
 };
 
@@ -267,6 +367,33 @@ public:
 
     virtual void terminate() override;
 
+    virtual size_t getPreferredBufferSize() const override;
+
+    ///
+    /// \brief Returns the descriptor of the socket from which
+    ///        the data is read.
+    ///
+    /// \return the socket descriptor
+    ///
+    ///////////////////////////////////////////////////////////
+    int getSocket() const;
+
+    ///
+    /// \brief Reads the data already received by the socket,
+    ///        without waiting for more.
+    ///
+    /// Available on Linux only.
+    ///
+    /// \param pBuffer      the buffer where the data is
+    ///                     copied
+    /// \param bufferLength the size of the buffer
+    /// \return the number of read bytes, 0 if no data is
+    ///         available. Throws StreamClosedError if the
+    ///         peer closed the connection
+    ///
+    ///////////////////////////////////////////////////////////
+    size_t readAvailable(std::uint8_t* pBuffer, size_t bufferLength);
+
 private:
     std::shared_ptr<tcpSequenceStream> m_pTcpStream;
 };
@@ -277,8 +404,14 @@ class tcpSequenceStreamOutput: public baseSequenceStreamOutput
 public:
     tcpSequenceStreamOutput(std::shared_ptr<tcpSequenceStream> pTcpStream);
 
+    using baseSequenceStreamOutput::write;
+
     void write(const std::uint8_t* pBuffer, size_t bufferLength) override;
 
+    void write(const outputBuffers_t& buffers) override;
+
+    virtual size_t getPreferredBufferSize() const override;
+
 private:
     std::shared_ptr<tcpSequenceStream> m_pTcpStream;
 };
@@ -301,6 +434,26 @@ public:
     ///////////////////////////////////////////////////////////
     tcpListener(std::shared_ptr<tcpAddress> pAddress);
 
+    ///
+    /// \brief Constructors. Creates a socket that listens for
+    ///        incoming connections at the specified address.
+    ///
+    /// The buffer sizes are set before the socket starts
+    /// listening and are inherited by the accepted
+    /// connections.
+    ///
+    /// \param pAddress          the address to which the socket
+    ///                          must be bound
+    /// \param sendBufferSize    size of the send buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    /// \param receiveBufferSize size of the receive buffer, in
+    ///                          bytes. 0 keeps the system
+    ///                          default
+    ///
+    ///////////////////////////////////////////////////////////
+    tcpListener(std::shared_ptr<tcpAddress> pAddress, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize);
+
     ///
     /// \brief Terminates pending waitForConnection() calls
     ///        and closes the socket.
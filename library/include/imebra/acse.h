@@ -269,6 +269,34 @@ public:
 
 
 
+///
+/// \brief Receives the notifications of an association, so its commands can
+///        be handled without a thread waiting in getCommand().
+///
+/// See AssociationBase::setListener().
+///
+///////////////////////////////////////////////////////////////////////////////
+class IMEBRA_API AssociationListener
+{
+public:
+    virtual ~AssociationListener();
+
+    ///
+    /// \brief Called once for each received command: the command can then be
+    ///        retrieved with AssociationBase::getCommand() without blocking.
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    virtual void commandReady() = 0;
+
+    ///
+    /// \brief Called once when the association has been released or aborted.
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    virtual void terminated() = 0;
+};
+
+
+
 ///
 /// \brief The AssociationBase class
 ///
@@ -305,6 +333,28 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     const AssociationMessage getResponse(std::uint16_t messageId);
 
+    ///
+    /// \brief Sets the listener notified when a command is received and when
+    ///        the association is terminated.
+    ///
+    /// The listener is called by the thread that receives the messages (or by
+    /// the reactor's workers, see setReactorThreads()) and must return
+    /// quickly without throwing: it should hand the commands over to other
+    /// threads.
+    /// The commands received before the call are notified immediately by the
+    /// calling thread; if the association has already been terminated then
+    /// terminated() is called immediately too.
+    /// The listener's methods may run concurrently: commandReady() may still
+    /// be called while or after terminated() runs for the commands received
+    /// before the termination, getCommand() then throws StreamClosedError.
+    ///
+    /// The listener must stay valid until the association is destroyed.
+    ///
+    /// \param listener the listener to notify
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    void setListener(AssociationListener& listener);
+
     ///
     /// \brief Send a DICOM message to the connected peer.
     ///
@@ -347,6 +397,28 @@ public:
     //////////////////////////////////////////////////////////////////
     std::string getOtherAET() const;
 
+    ///
+    /// \brief Returns the maximum number of outstanding operations that
+    ///        we can invoke on the connected peer, as negotiated during the
+    ///        association.
+    ///
+    /// \return the negotiated maximum number of outstanding operations that
+    ///         we can invoke. 0 means unlimited
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::uint32_t getMaxOperationsInvoked() const;
+
+    ///
+    /// \brief Returns the maximum number of outstanding operations that
+    ///        we can perform for the connected peer, as negotiated during
+    ///        the association.
+    ///
+    /// \return the negotiated maximum number of outstanding operations that
+    ///         we can perform. 0 means unlimited
+    ///
+    //////////////////////////////////////////////////////////////////
+    std::uint32_t getMaxOperationsPerformed() const;
+
     ///
     /// \brief Returns the transfer syntax negotiated for a specific
     ///        abstract syntax.
@@ -386,7 +458,29 @@ public:
     //////////////////////////////////////////////////////////////////
     std::vector<std::string> getTransferSyntaxes(const std::string& abstractSyntax) const;
 
-
+    ///
+    /// \brief Enables or disables the reactor that receives the messages of
+    ///        the associations running on a TCPStream.
+    ///
+    /// By default each association receives its messages in a dedicated
+    /// thread. With the reactor a single epoll thread watches the sockets of
+    /// all the associations and a fixed pool of worker threads decodes the
+    /// received PDUs, so idle associations don't hold a thread.
+    /// The sockets are read without blocking and a PDU is decoded only
+    /// once it has been completely received, so a slow peer doesn't hold
+    /// a worker; a PDU longer than the maximum length declared during the
+    /// negotiation aborts its association.
+    ///
+    /// The setting is process wide: it applies to the SCU and SCP
+    /// associations created afterwards. The
+    /// reactor is available on Linux only and is ignored on the other
+    /// platforms.
+    ///
+    /// \param workerThreads number of threads decoding the received PDUs.
+    ///                      0 disables the reactor
+    ///
+    //////////////////////////////////////////////////////////////////
+    static void setReactorThreads(std::uint32_t workerThreads);
 
 #ifndef SWIG
 protected:
@@ -457,6 +551,32 @@ public:
             StreamWriter& pOutput,
             std::uint32_t dimseTimeoutSeconds);
 
+    ///
+    /// \brief Initiates an association request declaring the
+    ///        maximum length of the PDUs that the SCP may send.
+    ///
+    /// Larger PDUs reduce the per-PDU overhead on links with a high
+    /// bandwidth-delay product.
+    ///
+    /// See the other constructor for the description of the remaining
+    /// parameters.
+    ///
+    /// \param maxPDULength         maximum length of the PDUs that this SCU
+    ///                             accepts. 0 means the library default
+    ///                             (MAXIMUM_PDU_SIZE)
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    AssociationSCU(
+            const std::string& thisAET,
+            const std::string& otherAET,
+            std::uint32_t invokedOperations,
+            std::uint32_t performedOperations,
+            const PresentationContexts& presentationContexts,
+            StreamReader& pInput,
+            StreamWriter& pOutput,
+            std::uint32_t dimseTimeoutSeconds,
+            std::uint32_t maxPDULength);
+
     ///
     /// \brief Copy constructor.
     ///
@@ -550,6 +670,64 @@ public:
             std::uint32_t dimseTimeoutSeconds,
             std::uint32_t artimTimeoutSeconds);
 
+    ///
+    /// \brief Listens for an association request and stores the payloads
+    ///        of the received C-STORE commands directly into a folder.
+    ///
+    /// The payloads of the C-STORE commands are not decoded: the preamble and
+    /// the meta information header are written into the file
+    /// payloadStorageFolder/<SOP Instance UID>.dcm, then the received PDV
+    /// fragments are appended to it as they arrive. The file is renamed to
+    /// its final name once the last fragment has been received.
+    ///
+    /// The payload returned by the received CStoreCommand contains only the
+    /// SOP Class UID and the SOP Instance UID.
+    ///
+    /// See the other constructor for the description of the remaining
+    /// parameters.
+    ///
+    /// \param payloadStorageFolder folder into which the C-STORE payloads are
+    ///                             written
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    AssociationSCP(
+            const std::string& thisAET,
+            std::uint32_t invokedOperations,
+            std::uint32_t performedOperations,
+            const PresentationContexts& presentationContexts,
+            StreamReader& pInput,
+            StreamWriter& pOutput,
+            std::uint32_t dimseTimeoutSeconds,
+            std::uint32_t artimTimeoutSeconds,
+            const std::string& payloadStorageFolder);
+
+    ///
+    /// \brief Listens for an association request, declaring the maximum
+    ///        length of the PDUs that the SCU may send.
+    ///
+    /// See the other constructors for the description of the remaining
+    /// parameters.
+    ///
+    /// \param payloadStorageFolder folder into which the C-STORE payloads are
+    ///                             written. If empty then the payloads are
+    ///                             decoded
+    /// \param maxPDULength         maximum length of the PDUs that this SCP
+    ///                             accepts. 0 means the library default
+    ///                             (MAXIMUM_PDU_SIZE)
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    AssociationSCP(
+            const std::string& thisAET,
+            std::uint32_t invokedOperations,
+            std::uint32_t performedOperations,
+            const PresentationContexts& presentationContexts,
+            StreamReader& pInput,
+            StreamWriter& pOutput,
+            std::uint32_t dimseTimeoutSeconds,
+            std::uint32_t artimTimeoutSeconds,
+            const std::string& payloadStorageFolder,
+            std::uint32_t maxPDULength);
+
     ///
     /// \brief Copy constructor.
     ///
@@ -23,6 +23,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include <string>
 #include <limits>
 #include "dataSet.h"
+#include "tagId.h"
 #include "streamReader.h"
 #include "streamWriter.h"
 #include "definitions.h"
@@ -52,7 +53,12 @@ public:
     ///                          immediately. Tags larger than maxSizeBufferLoad
     ///                          are left on the input stream and loaded only when
     ///                          a ReadingDataHandler or a WritingDataHandler
-    ///                          reference them.
+    ///                          reference them. Sequences larger than
+    ///                          maxSizeBufferLoad are parsed when they are
+    ///                          accessed. Set to 0 to parse only the tags'
+    ///                          positions, including all the sequences:
+    ///                          this is the fastest way to read a few tags
+    ///                          from a large dataset.
     /// \return a DataSet object representing the input stream's content
     ///
     ///////////////////////////////////////////////////////////////////////////////
@@ -69,7 +75,12 @@ public:
     ///                          immediately. Tags larger than maxSizeBufferLoad
     ///                          are left on the input stream and loaded only when
     ///                          a ReadingDataHandler or a WritingDataHandler
-    ///                          reference them.
+    ///                          reference them. Sequences larger than
+    ///                          maxSizeBufferLoad are parsed when they are
+    ///                          accessed. Set to 0 to parse only the tags'
+    ///                          positions, including all the sequences:
+    ///                          this is the fastest way to read a few tags
+    ///                          from a large dataset.
     /// \return a DataSet object representing the input file's content
     ///
     ///////////////////////////////////////////////////////////////////////////////
@@ -88,12 +99,124 @@ public:
     ///                          immediately. Tags larger than maxSizeBufferLoad
     ///                          are left on the input stream and loaded only when
     ///                          a ReadingDataHandler or a WritingDataHandler
-    ///                          reference them.
+    ///                          reference them. Sequences larger than
+    ///                          maxSizeBufferLoad are parsed when they are
+    ///                          accessed. Set to 0 to parse only the tags'
+    ///                          positions, including all the sequences:
+    ///                          this is the fastest way to read a few tags
+    ///                          from a large dataset.
     /// \return a DataSet object representing the input file's content
     ///
     ///////////////////////////////////////////////////////////////////////////////
     static const DataSet load(const std::string& fileName, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
 
+    /// \brief Parses the content of the input stream up to the specified tag
+    ///        and returns a DataSet representing it.
+    ///
+    /// The parsing stops after the specified tag, so the tags that follow it
+    /// (e.g. the pixel data) are not read from the stream. The tags in the
+    /// group 0x0002 and the tag 0x0008,0x0005 are always loaded.
+    ///
+    /// The read position of the StreamReader is undefined when this method
+    /// returns.
+    ///
+    /// \param reader            a StreamReader connected to the input stream
+    /// \param stopTag           the last tag to load. The tag's group order
+    ///                          is ignored
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately. See
+    ///                          load(StreamReader&, size_t)
+    /// \return a DataSet object containing the tags up to stopTag
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    static const DataSet load(StreamReader& reader, const TagId& stopTag, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+
+    /// \brief Parses the content of the input file up to the specified tag
+    ///        and returns a DataSet representing it.
+    ///
+    /// Only the beginning of the file is read: see
+    /// load(StreamReader&, const TagId&, size_t).
+    ///
+    /// \param fileName          the Unicode name of the input file to read
+    /// \param stopTag           the last tag to load
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately
+    /// \return a DataSet object containing the tags up to stopTag
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+#ifndef SWIG // Use Unicode strings only with SWIG
+    static const DataSet load(const std::wstring& fileName, const TagId& stopTag, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+#endif
+
+    /// \brief Parses the content of the input file up to the specified tag
+    ///        and returns a DataSet representing it.
+    ///
+    /// Only the beginning of the file is read: see
+    /// load(StreamReader&, const TagId&, size_t).
+    ///
+    /// \param fileName          the Utf8 name of the input file to read
+    /// \param stopTag           the last tag to load
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately
+    /// \return a DataSet object containing the tags up to stopTag
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    static const DataSet load(const std::string& fileName, const TagId& stopTag, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+
+    /// \brief Parses only the specified tags from the input stream and
+    ///        returns a DataSet containing them.
+    ///
+    /// The parsing stops after the last tag in the list, so the tags that
+    /// follow it (e.g. the pixel data) are not read from the stream.
+    /// The tags in the group 0x0002 and the tag 0x0008,0x0005 are always
+    /// loaded.
+    ///
+    /// The read position of the StreamReader is undefined when this method
+    /// returns.
+    ///
+    /// \param reader            a StreamReader connected to the input stream
+    /// \param tags              the tags to load. The tags' group order is
+    ///                          ignored
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately. See
+    ///                          load(StreamReader&, size_t)
+    /// \return a DataSet object containing the requested tags
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    static const DataSet load(StreamReader& reader, const tagsIds_t& tags, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+
+    /// \brief Parses only the specified tags from the input file and
+    ///        returns a DataSet containing them.
+    ///
+    /// Only the beginning of the file is read: see
+    /// load(StreamReader&, const tagsIds_t&, size_t).
+    ///
+    /// \param fileName          the Unicode name of the input file to read
+    /// \param tags              the tags to load
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately
+    /// \return a DataSet object containing the requested tags
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+#ifndef SWIG // Use Unicode strings only with SWIG
+    static const DataSet load(const std::wstring& fileName, const tagsIds_t& tags, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+#endif
+
+    /// \brief Parses only the specified tags from the input file and
+    ///        returns a DataSet containing them.
+    ///
+    /// Only the beginning of the file is read: see
+    /// load(StreamReader&, const tagsIds_t&, size_t).
+    ///
+    /// \param fileName          the Utf8 name of the input file to read
+    /// \param tags              the tags to load
+    /// \param maxSizeBufferLoad the maximum size of the tags that are loaded
+    ///                          immediately
+    /// \return a DataSet object containing the requested tags
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    static const DataSet load(const std::string& fileName, const tagsIds_t& tags, size_t maxSizeBufferLoad = std::numeric_limits<size_t>::max());
+
     static void saveImage(
             StreamWriter& destStream,
             const Image& sourceImage,
@@ -615,6 +615,33 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     tagVR_t getDataType(const TagId& tagId) const;
 
+    /// \brief Make the dataset immutable.
+    ///
+    /// A frozen dataset, its sequence items and its tags are read without
+    /// locking them, so several threads can read the dataset concurrently
+    /// without contention. Any attempt to modify the dataset (including
+    /// the modifications made through a MutableDataSet referencing the same
+    /// dataset) throws DataSetFrozenError.
+    ///
+    /// The writing data handlers obtained from the dataset must be released
+    /// before calling freeze(): while one of them is still alive freeze()
+    /// throws DataSetFrozenError and leaves the dataset unchanged.
+    ///
+    /// The buffers that are loaded lazily are still read from the original
+    /// stream when they are accessed: load the dataset with a
+    /// maxSizeBufferLoad large enough to keep all the tags in memory, or
+    /// from a MappedFileStreamInput, to avoid the stream's lock.
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    void freeze();
+
+    /// \brief Return true if the dataset has been frozen with freeze().
+    ///
+    /// \return true if the dataset is frozen, false otherwise
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    bool isFrozen() const;
+
 #ifndef SWIG
 protected:
     explicit DataSet(const std::shared_ptr<imebra::implementation::dataSet>& pDataSet);
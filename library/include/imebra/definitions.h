@@ -300,6 +300,7 @@ enum class dimseStatusCode_t: std::uint16_t
     unsupportedOptionalAttributes = 0x0001,                ///< Requested optional Attributes are not supported
     cannotUpdateperformedProcedureStepObject = 0x0110,     ///< Performed Procedure Step Object may no longer be updated
     unsupportedSOPClass = 0x0122,                          ///< SOP Class not Supported
+    unrecognizedOperation = 0x0211,                        ///< Unrecognized operation
     outOfResources = 0xa700,                               ///< Refused: Out of resources
     outOfResourcesCannotCalculateNumberOfMatches = 0xa701, ///< Refused: Out of Resources - Unable to calculate number of matches
     outOfResourcesCannotPerformSubOperations = 0xa702,     ///< Refused: Out of Resources - Unable to perform sub-operations
@@ -2074,6 +2074,25 @@ public:
     //////////////////////////////////////////////////////////////////
     const CGetResponse getCGetResponse(const CGetCommand& command);
 
+    ///
+    /// \brief Waits until either a command sent by the peer or the
+    ///        response for the specified command is available.
+    ///
+    /// The message is not retrieved: when the method returns true
+    /// getCommand() returns the command without blocking, otherwise
+    /// the response can be retrieved without blocking.
+    ///
+    /// This allows an SCU to serve the C-STORE sub-operations of a
+    /// C-GET and to collect the C-GET responses from the same thread.
+    ///
+    /// \param command the sent command for which a response is
+    ///                expected
+    /// \return true if a command is available, false if the response
+    ///         to the specified command is available
+    ///
+    //////////////////////////////////////////////////////////////////
+    bool waitCommandOrResponse(const DimseCommand& command);
+
     ///
     /// \brief Wait for the response for the specified C-FIND
     ///        command and returns it.
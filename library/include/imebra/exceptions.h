@@ -947,6 +947,28 @@ public:
     virtual ~DataSetCorruptedOffsetTableError();
 };
 
+/// \brief This exception is thrown when the client tries to modify a
+///        dataset that has been frozen with DataSet::freeze(), or to
+///        freeze a dataset while a writing data handler is still in use.
+///
+///////////////////////////////////////////////////////////////////////////////
+class IMEBRA_API DataSetFrozenError: public DataSetError
+{
+public:
+    /// \brief Constructor.
+    ///
+    /// \param message the message to store into the exception
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    explicit DataSetFrozenError(const std::string& message);
+
+    DataSetFrozenError(const DataSetFrozenError& source);
+
+    DataSetFrozenError& operator=(const DataSetFrozenError&) = delete;
+
+    virtual ~DataSetFrozenError();
+};
+
 
 /// \brief Base class from which the exceptions thrown by DicomDirEntry and
 ///        DicomDir classes.
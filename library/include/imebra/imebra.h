@@ -35,6 +35,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "fileStreamOutput.h"
 #include "image.h"
 #include "lut.h"
+#include "mappedFileStreamInput.h"
 #include "memory.h"
 #include "mutableMemory.h"
 #include "memoryPool.h"
@@ -0,0 +1,76 @@
+/*
+Copyright 2005 - 2017 by Paolo Brandoli/Binarno s.p.
+
+Imebra is available for free under the GNU General Public License.
+
+The full text of the license is available in the file license.rst
+ in the project root folder.
+
+If you do not want to be bound by the GPL terms (such as the requirement
+ that your application must also be GPL), you may purchase a commercial
+ license for Imebra from the Imebra’s website (http://imebra.com).
+*/
+
+/*! \file mappedFileStreamInput.h
+    \brief Declaration of the MappedFileStreamInput class.
+
+*/
+
+#if !defined(imebraMappedFileStreamInput_8318B15D_6133_4FBE_8BEF_CB215B2B1CAB__INCLUDED_)
+#define imebraMappedFileStreamInput_8318B15D_6133_4FBE_8BEF_CB215B2B1CAB__INCLUDED_
+
+#include <string>
+#include "baseStreamInput.h"
+#include "definitions.h"
+
+namespace imebra
+{
+
+///
+/// \brief Represents an input file stream that maps the whole file in memory.
+///
+/// The tags loaded from this stream reference the mapped file instead of
+/// copying its content: the file stays mapped until the stream and all the
+/// DataSet objects loaded from it have been deleted.
+///
+/// The file must not be truncated while it is mapped.
+///
+///////////////////////////////////////////////////////////////////////////////
+class IMEBRA_API MappedFileStreamInput : public BaseStreamInput
+{
+
+public:
+    /// \brief Constructor.
+    ///
+    /// \param name the path to the file to open in read mode
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+#ifndef SWIG // Use only UTF-8 strings with SWIG
+    explicit MappedFileStreamInput(const std::wstring& name);
+#endif
+
+    /// \brief Constructor.
+    ///
+    /// \param name the path to the file to open in read mode, in encoded in UTF8
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    explicit MappedFileStreamInput(const std::string& name);
+
+    ///
+    /// \brief Copy constructor.
+    ///
+    /// \param source source MappedFileStreamInput object
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    MappedFileStreamInput(const MappedFileStreamInput& source);
+
+    MappedFileStreamInput& operator=(const MappedFileStreamInput& source) = delete;
+
+    /// \brief Destructor. Releases the mapping when no DataSet references it.
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    ~MappedFileStreamInput();
+};
+
+}
+#endif // !defined(imebraMappedFileStreamInput_8318B15D_6133_4FBE_8BEF_CB215B2B1CAB__INCLUDED_)
@@ -150,6 +150,19 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     void terminate();
 
+    ///
+    /// \brief Change the size of the buffer used to read from the controlled
+    ///        stream.
+    ///
+    /// By default the buffer size is chosen by the controlled stream (e.g.
+    /// file and TCP streams use a larger buffer than memory streams).
+    /// Reads larger than the buffer bypass it.
+    ///
+    /// \param bufferSize the new buffer size, in bytes
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    void setBufferSize(size_t bufferSize);
+
     virtual ~StreamReader();
 
 #ifndef SWIG
@@ -111,6 +111,19 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     void flush();
 
+    ///
+    /// \brief Flush the unwritten data and change the size of the buffer used
+    ///        to write into the controlled stream.
+    ///
+    /// By default the buffer size is chosen by the controlled stream (e.g.
+    /// file and TCP streams use a larger buffer than memory streams).
+    /// Writes larger than the buffer bypass it.
+    ///
+    /// \param bufferSize the new buffer size, in bytes
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    void setBufferSize(size_t bufferSize);
+
     virtual ~StreamWriter();
 
 #ifndef SWIG
@@ -59,6 +59,22 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     explicit TCPListener(const TCPPassiveAddress& address);
 
+    /// \brief Constructor.
+    ///
+    /// Constructs a listening socket with the specified buffer sizes
+    /// (SO_SNDBUF and SO_RCVBUF) and starts listening for incoming
+    /// connections. The accepted connections inherit the buffer sizes.
+    ///
+    /// @param address           the address to which the listening socket
+    ///                          must be bound
+    /// @param sendBufferSize    size of the send buffer, in bytes. 0 keeps
+    ///                          the system default
+    /// @param receiveBufferSize size of the receive buffer, in bytes. 0 keeps
+    ///                          the system default
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    TCPListener(const TCPPassiveAddress& address, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize);
+
     ///
     /// \brief Copy constructor.
     ///
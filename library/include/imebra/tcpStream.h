@@ -57,6 +57,25 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     explicit TCPStream(const TCPActiveAddress& address);
 
+    ///
+    /// \brief Construct a TCP socket with the specified buffer sizes and
+    ///        Nagle behaviour and connects it to the destination address.
+    ///
+    /// The options are applied before the connection starts, so the TCP
+    /// window scale is negotiated for the requested receive buffer.
+    ///
+    /// \param address           the address to which the socket has to be
+    ///                          connected
+    /// \param sendBufferSize    size of the send buffer (SO_SNDBUF), in bytes.
+    ///                          0 keeps the system default
+    /// \param receiveBufferSize size of the receive buffer (SO_RCVBUF), in
+    ///                          bytes. 0 keeps the system default
+    /// \param bNoDelay          true to disable the Nagle algorithm
+    ///                          (TCP_NODELAY)
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    TCPStream(const TCPActiveAddress& address, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize, bool bNoDelay);
+
     ///
     /// \brief Copy constructor.
     ///
@@ -93,6 +112,15 @@ public:
     ///////////////////////////////////////////////////////////////////////////////
     BaseStreamOutput getStreamOutput();
 
+    ///
+    /// \brief Enable or disable the Nagle algorithm (TCP_NODELAY).
+    ///
+    /// \param bNoDelay true to send small segments immediately, false to
+    ///                 let the system coalesce them
+    ///
+    ///////////////////////////////////////////////////////////////////////////////
+    void setNoDelay(bool bNoDelay);
+
 #ifndef SWIG
 protected:
 
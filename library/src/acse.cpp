@@ -20,6 +20,7 @@ If you do not want to be bound by the GPL terms (such as the requirement
 #include "../include/imebra/streamWriter.h"
 #include "../include/imebra/dataSet.h"
 #include "../implementation/acseImpl.h"
+#include "../implementation/tcpReactorImpl.h"
 
 namespace imebra
 {
@@ -180,6 +181,16 @@ void MutableAssociationMessage::addDataSet(const DataSet& dataSet)
 }
 
 
+//
+// AssociationListener methods
+//
+///////////////////////////////////////////////////////////////////////////////
+
+AssociationListener::~AssociationListener()
+{
+}
+
+
 //
 // AssociationBase methods
 //
@@ -212,6 +223,17 @@ const AssociationMessage AssociationBase::getResponse(std::uint16_t messageId)
     IMEBRA_FUNCTION_END_LOG();
 }
 
+void AssociationBase::setListener(AssociationListener& listener)
+{
+    IMEBRA_FUNCTION_START();
+
+    m_pAssociation->setListener(
+                std::bind(&AssociationListener::commandReady, &listener),
+                std::bind(&AssociationListener::terminated, &listener));
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 void AssociationBase::sendMessage(const AssociationMessage& messageDataSet)
 {
     IMEBRA_FUNCTION_START();
@@ -257,6 +279,33 @@ std::string AssociationBase::getOtherAET() const
     IMEBRA_FUNCTION_END_LOG();
 }
 
+std::uint32_t AssociationBase::getMaxOperationsInvoked() const
+{
+    IMEBRA_FUNCTION_START();
+
+    return m_pAssociation->getMaxOperationsInvoked();
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+std::uint32_t AssociationBase::getMaxOperationsPerformed() const
+{
+    IMEBRA_FUNCTION_START();
+
+    return m_pAssociation->getMaxOperationsPerformed();
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+void AssociationBase::setReactorThreads(std::uint32_t workerThreads)
+{
+    IMEBRA_FUNCTION_START();
+
+    implementation::tcpReactor::setWorkerThreads((size_t)workerThreads);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 std::string AssociationBase::getTransferSyntax(const std::string &abstractSyntax) const
 {
     IMEBRA_FUNCTION_START();
@@ -300,7 +349,31 @@ AssociationSCU::AssociationSCU(
                 performedOperations,
                 pInput.m_pReader,
                 pOutput.m_pWriter,
-                        dimseTimeoutSeconds))
+                        dimseTimeoutSeconds,
+                        0))
+{
+}
+
+AssociationSCU::AssociationSCU(
+        const std::string& thisAET,
+        const std::string& otherAET,
+        std::uint32_t invokedOperations,
+        std::uint32_t performedOperations,
+        const PresentationContexts& presentationContexts,
+        StreamReader& pInput,
+        StreamWriter& pOutput,
+        std::uint32_t dimseTimeoutSeconds,
+        std::uint32_t maxPDULength):
+    AssociationBase(std::make_shared<implementation::associationSCU>(
+                        getPresentationContextsImplementation(presentationContexts),
+                thisAET,
+                otherAET,
+                invokedOperations,
+                performedOperations,
+                pInput.m_pReader,
+                pOutput.m_pWriter,
+                        dimseTimeoutSeconds,
+                        maxPDULength))
 {
 }
 
@@ -335,7 +408,58 @@ AssociationSCP::AssociationSCP(
                 pInput.m_pReader,
                 pOutput.m_pWriter,
                 dimseTimeoutSeconds,
-                        artimTimeoutSeconds))
+                        artimTimeoutSeconds,
+                        "",
+                        0))
+{
+}
+
+AssociationSCP::AssociationSCP(
+        const std::string& thisAET,
+        std::uint32_t invokedOperations,
+        std::uint32_t performedOperations,
+        const PresentationContexts& presentationContexts,
+        StreamReader& pInput,
+        StreamWriter& pOutput,
+        std::uint32_t dimseTimeoutSeconds,
+        std::uint32_t artimTimeoutSeconds,
+        const std::string& payloadStorageFolder):
+    AssociationBase(std::make_shared<implementation::associationSCP>(
+                        getPresentationContextsImplementation(presentationContexts),
+                thisAET,
+                invokedOperations,
+                performedOperations,
+                pInput.m_pReader,
+                pOutput.m_pWriter,
+                dimseTimeoutSeconds,
+                        artimTimeoutSeconds,
+                        payloadStorageFolder,
+                        0))
+{
+}
+
+AssociationSCP::AssociationSCP(
+        const std::string& thisAET,
+        std::uint32_t invokedOperations,
+        std::uint32_t performedOperations,
+        const PresentationContexts& presentationContexts,
+        StreamReader& pInput,
+        StreamWriter& pOutput,
+        std::uint32_t dimseTimeoutSeconds,
+        std::uint32_t artimTimeoutSeconds,
+        const std::string& payloadStorageFolder,
+        std::uint32_t maxPDULength):
+    AssociationBase(std::make_shared<implementation::associationSCP>(
+                        getPresentationContextsImplementation(presentationContexts),
+                thisAET,
+                invokedOperations,
+                performedOperations,
+                pInput.m_pReader,
+                pOutput.m_pWriter,
+                dimseTimeoutSeconds,
+                        artimTimeoutSeconds,
+                        payloadStorageFolder,
+                        maxPDULength))
 {
 }
 
@@ -63,6 +63,83 @@ const DataSet CodecFactory::load(const std::string& fileName, size_t maxSizeBuff
     IMEBRA_FUNCTION_END_LOG();
 }
 
+const DataSet CodecFactory::load(StreamReader& reader, const TagId& stopTag, size_t maxSizeBufferLoad /*  = std::numeric_limits<size_t>::max()) */)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::shared_ptr<implementation::codecs::tagsFilter> pFilter(std::make_shared<implementation::codecs::tagsFilter>(stopTag.getGroupId(), stopTag.getTagId()));
+
+    std::shared_ptr<imebra::implementation::codecs::codecFactory> factory(imebra::implementation::codecs::codecFactory::getCodecFactory());
+    return DataSet(factory->load(reader.m_pReader, (std::uint32_t)maxSizeBufferLoad, pFilter));
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+const DataSet CodecFactory::load(const std::wstring& fileName, const TagId& stopTag, size_t maxSizeBufferLoad)
+{
+    IMEBRA_FUNCTION_START();
+
+    FileStreamInput file(fileName);
+
+    StreamReader reader(file);
+    return load(reader, stopTag, maxSizeBufferLoad);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+const DataSet CodecFactory::load(const std::string& fileName, const TagId& stopTag, size_t maxSizeBufferLoad)
+{
+    IMEBRA_FUNCTION_START();
+
+    FileStreamInput file(fileName);
+
+    StreamReader reader(file);
+    return load(reader, stopTag, maxSizeBufferLoad);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+const DataSet CodecFactory::load(StreamReader& reader, const tagsIds_t& tags, size_t maxSizeBufferLoad /*  = std::numeric_limits<size_t>::max()) */)
+{
+    IMEBRA_FUNCTION_START();
+
+    std::set<std::pair<std::uint16_t, std::uint16_t> > filterTags;
+    for(const TagId& tag: tags)
+    {
+        filterTags.insert(std::make_pair(tag.getGroupId(), tag.getTagId()));
+    }
+    std::shared_ptr<implementation::codecs::tagsFilter> pFilter(std::make_shared<implementation::codecs::tagsFilter>(filterTags));
+
+    std::shared_ptr<imebra::implementation::codecs::codecFactory> factory(imebra::implementation::codecs::codecFactory::getCodecFactory());
+    return DataSet(factory->load(reader.m_pReader, (std::uint32_t)maxSizeBufferLoad, pFilter));
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+const DataSet CodecFactory::load(const std::wstring& fileName, const tagsIds_t& tags, size_t maxSizeBufferLoad)
+{
+    IMEBRA_FUNCTION_START();
+
+    FileStreamInput file(fileName);
+
+    StreamReader reader(file);
+    return load(reader, tags, maxSizeBufferLoad);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+const DataSet CodecFactory::load(const std::string& fileName, const tagsIds_t& tags, size_t maxSizeBufferLoad)
+{
+    IMEBRA_FUNCTION_START();
+
+    FileStreamInput file(fileName);
+
+    StreamReader reader(file);
+    return load(reader, tags, maxSizeBufferLoad);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 void CodecFactory::saveImage(
         StreamWriter& destStream,
         const Image& sourceImage,
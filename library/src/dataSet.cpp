@@ -376,6 +376,24 @@ tagVR_t DataSet::getDataType(const TagId& tagId) const
     IMEBRA_FUNCTION_END_LOG();
 }
 
+void DataSet::freeze()
+{
+    IMEBRA_FUNCTION_START();
+
+    m_pDataSet->freeze();
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+bool DataSet::isFrozen() const
+{
+    IMEBRA_FUNCTION_START();
+
+    return m_pDataSet->isFrozen();
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 MutableDataSet::MutableDataSet(const MutableDataSet &source): DataSet(source)
 {
 }
@@ -2270,6 +2270,21 @@ const CGetResponse DimseService::getCGetResponse(const CGetCommand& command)
 }
 
 
+//////////////////////////////////////////////////////////////////
+//
+// Wait for a command or for a response
+//
+//////////////////////////////////////////////////////////////////
+bool DimseService::waitCommandOrResponse(const DimseCommand& command)
+{
+    IMEBRA_FUNCTION_START();
+
+    return m_pDimseService->waitCommandOrResponse(command.getID());
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
+
 //////////////////////////////////////////////////////////////////
 //
 // Wait for a C-FIND response
@@ -372,6 +372,15 @@ DataSetCorruptedOffsetTableError::DataSetCorruptedOffsetTableError(const DataSet
 DataSetCorruptedOffsetTableError::~DataSetCorruptedOffsetTableError()
 {}
 
+DataSetFrozenError::DataSetFrozenError(const std::string& message): DataSetError(message)
+{}
+
+DataSetFrozenError::DataSetFrozenError(const DataSetFrozenError &source): DataSetError(source)
+{}
+
+DataSetFrozenError::~DataSetFrozenError()
+{}
+
 
 DicomDirError::DicomDirError(const std::string& message): std::runtime_error(message)
 {}
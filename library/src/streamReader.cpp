@@ -105,6 +105,15 @@ void StreamReader::terminate()
     IMEBRA_FUNCTION_END_LOG();
 }
 
+void StreamReader::setBufferSize(size_t bufferSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    m_pReader->setBufferSize(bufferSize);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 StreamReader::~StreamReader()
 {
 }
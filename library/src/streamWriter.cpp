@@ -71,6 +71,15 @@ void StreamWriter::flush()
     IMEBRA_FUNCTION_END_LOG();
 }
 
+void StreamWriter::setBufferSize(size_t bufferSize)
+{
+    IMEBRA_FUNCTION_START();
+
+    m_pWriter->setBufferSize(bufferSize);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 const std::shared_ptr<implementation::streamWriter>& getStreamWriterImplementation(const StreamWriter& streamWriter)
 {
     return streamWriter.m_pWriter;
@@ -29,6 +29,11 @@ TCPListener::TCPListener(const TCPPassiveAddress& address):
 {
 }
 
+TCPListener::TCPListener(const TCPPassiveAddress& address, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize):
+    m_pListener(std::make_shared<implementation::tcpListener>(address.m_pAddress, sendBufferSize, receiveBufferSize))
+{
+}
+
 TCPListener::TCPListener(const TCPListener &source): m_pListener(getTCPListenerImplementation(source))
 {
 }
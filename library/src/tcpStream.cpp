@@ -28,6 +28,11 @@ TCPStream::TCPStream(const TCPActiveAddress& address):
 {
 }
 
+TCPStream::TCPStream(const TCPActiveAddress& address, std::uint32_t sendBufferSize, std::uint32_t receiveBufferSize, bool bNoDelay):
+    m_pStream(std::make_shared<implementation::tcpSequenceStream>(address.m_pAddress, sendBufferSize, receiveBufferSize, bNoDelay))
+{
+}
+
 TCPStream::TCPStream(const std::shared_ptr<implementation::tcpSequenceStream>& pTcpStream):
     m_pStream(pTcpStream)
 {
@@ -74,6 +79,15 @@ BaseStreamOutput TCPStream::getStreamOutput()
     IMEBRA_FUNCTION_END_LOG();
 }
 
+void TCPStream::setNoDelay(bool bNoDelay)
+{
+    IMEBRA_FUNCTION_START();
+
+    m_pStream->setNoDelay(bNoDelay);
+
+    IMEBRA_FUNCTION_END_LOG();
+}
+
 
 }
 
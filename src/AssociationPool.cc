@@ -0,0 +1,273 @@
+#include "AssociationPool.h"
+
+#include "../library/include/imebra/imebra.h"
+#include "../library/include/imebra/tcpAddress.h"
+
+#include <algorithm>
+
+namespace ns {
+
+    namespace {
+        // idle associations are checked with a c-echo before being reused
+        const std::chrono::milliseconds healthCheckAfter(5000);
+    }
+
+    imebra::PresentationContexts sContexts::build() const
+    {
+        imebra::PresentationContexts presentationContexts;
+        auto add = [&](const std::string& abstractSyntax, bool scpRole) {
+            imebra::PresentationContext context(abstractSyntax, true, scpRole);
+            context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
+            context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
+            presentationContexts.addPresentationContext(context);
+        };
+        add(imebra::uidVerificationSOPClass_1_2_840_10008_1_1, false);
+        for (const std::string& abstractSyntax : abstractSyntaxes) {
+            if (abstractSyntax != imebra::uidVerificationSOPClass_1_2_840_10008_1_1) {
+                add(abstractSyntax, false);
+            }
+        }
+        for (const std::string& abstractSyntax : scpAbstractSyntaxes) {
+            add(abstractSyntax, true);
+        }
+        return presentationContexts;
+    }
+
+    std::string sContexts::key() const
+    {
+        std::string key;
+        for (const std::string& abstractSyntax : abstractSyntaxes) {
+            key += abstractSyntax + ",";
+        }
+        key += "/";
+        for (const std::string& abstractSyntax : scpAbstractSyntaxes) {
+            key += abstractSyntax + ",";
+        }
+        return key;
+    }
+
+    PooledAssociation::PooledAssociation(const sInput& in, const sContexts& contexts)
+        : lastUsed(std::chrono::steady_clock::now())
+        , idleTimeout(std::max(in.idleTimeout, 0))
+        , _tcpStream(imebra::TCPActiveAddress(in.target.ip, in.target.port), (std::uint32_t)std::max(in.sendBufferSize, 0), (std::uint32_t)std::max(in.receiveBufferSize, 0), in.noDelay)
+        , _readSCU(_tcpStream.getStreamInput())
+        , _writeSCU(_tcpStream.getStreamOutput())
+        , _scu(in.source.aet, in.target.aet, 1, 1, contexts.build(), _readSCU, _writeSCU, 10, (std::uint32_t)std::max(in.maxPduLength, 0))
+        , _dimse(_scu)
+    {
+    }
+
+    bool PooledAssociation::echo()
+    {
+        const std::string abstractSyntax = imebra::uidVerificationSOPClass_1_2_840_10008_1_1;
+        try {
+            imebra::CEchoCommand command(abstractSyntax,
+                _dimse.getNextCommandID(),
+                imebra::dimseCommandPriority_t::medium,
+                abstractSyntax);
+            _dimse.sendCommandOrResponse(command);
+            imebra::DimseResponse response(_dimse.getCEchoResponse(command));
+            return response.getStatus() == imebra::dimseStatus_t::success;
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    AssociationPool::Lease::Lease(AssociationPool* pool, const std::string& key, std::unique_ptr<PooledAssociation> association)
+        : _pool(pool)
+        , _key(key)
+        , _association(std::move(association))
+    {
+    }
+
+    AssociationPool::Lease::Lease(Lease&& source)
+        : _pool(source._pool)
+        , _key(std::move(source._key))
+        , _association(std::move(source._association))
+    {
+    }
+
+    AssociationPool::Lease::~Lease()
+    {
+        if (_association) {
+            _association.reset();
+            if (_pool != nullptr) {
+                _pool->discard(_key);
+            }
+        }
+    }
+
+    void AssociationPool::Lease::done()
+    {
+        if (!_association) {
+            return;
+        }
+        if (_pool != nullptr) {
+            _pool->giveBack(_key, std::move(_association));
+            return;
+        }
+        try {
+            _association->scu().release();
+        }
+        catch (const std::exception&) {
+            // the request already completed
+        }
+        _association.reset();
+    }
+
+    AssociationPool& AssociationPool::instance()
+    {
+        // never destroyed: the idle associations may outlive the other statics
+        static AssociationPool* pool = new AssociationPool();
+        return *pool;
+    }
+
+    AssociationPool::AssociationPool()
+        : _reaperRunning(false)
+        , _stopped(false)
+    {
+    }
+
+    AssociationPool::~AssociationPool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stopped = true;
+        }
+        _changed.notify_all();
+        if (_reaper.joinable()) {
+            _reaper.join();
+        }
+    }
+
+    AssociationPool::Lease AssociationPool::acquire(const sInput& in, const sContexts& contexts)
+    {
+        if (!in.keepAlive) {
+            std::unique_ptr<PooledAssociation> association(new PooledAssociation(in, contexts));
+            return Lease(nullptr, std::string(), std::move(association));
+        }
+
+        const std::string key = in.source.aet + "|" + in.target.aet + "|" + in.target.ip + ":" + in.target.port + "|" + contexts.key();
+        const size_t limit = (size_t)std::max(in.maxAssociations, 1);
+
+        for (;;) {
+            std::unique_ptr<PooledAssociation> association;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                for (;;) {
+                    std::list<std::unique_ptr<PooledAssociation> >& idle = _idle[key];
+                    if (!idle.empty()) {
+                        // the most recently used one is the most likely to be alive
+                        association = std::move(idle.back());
+                        idle.pop_back();
+                        break;
+                    }
+                    if (_open[key] < limit) {
+                        ++_open[key];
+                        break;
+                    }
+                    _changed.wait(lock);
+                }
+            }
+
+            if (!association) {
+                try {
+                    association.reset(new PooledAssociation(in, contexts));
+                }
+                catch (...) {
+                    discard(key);
+                    throw;
+                }
+                return Lease(this, key, std::move(association));
+            }
+
+            if (std::chrono::steady_clock::now() - association->lastUsed < healthCheckAfter || association->echo()) {
+                association->idleTimeout = std::chrono::milliseconds(std::max(in.idleTimeout, 0));
+                return Lease(this, key, std::move(association));
+            }
+
+            // the peer dropped it, try the next one
+            association.reset();
+            discard(key);
+        }
+    }
+
+    void AssociationPool::giveBack(const std::string& key, std::unique_ptr<PooledAssociation> association)
+    {
+        association->lastUsed = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle[key].push_back(std::move(association));
+            if (!_reaperRunning) {
+                if (_reaper.joinable()) {
+                    _reaper.join();
+                }
+                _reaperRunning = true;
+                _reaper = std::thread(&AssociationPool::reaperProc, this);
+            }
+        }
+        _changed.notify_all();
+    }
+
+    void AssociationPool::discard(const std::string& key)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (--_open[key] == 0) {
+                _open.erase(key);
+                _idle.erase(key);
+            }
+        }
+        _changed.notify_all();
+    }
+
+    void AssociationPool::reaperProc()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (!_stopped) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point next = now + std::chrono::hours(1);
+            std::list<std::unique_ptr<PooledAssociation> > expired;
+            bool waiting(false);
+            for (auto& idle : _idle) {
+                for (auto it = idle.second.begin(); it != idle.second.end();) {
+                    const std::chrono::steady_clock::time_point expiry = (*it)->lastUsed + (*it)->idleTimeout;
+                    if (expiry <= now) {
+                        expired.push_back(std::move(*it));
+                        it = idle.second.erase(it);
+                        if (--_open[idle.first] == 0) {
+                            _open.erase(idle.first);
+                        }
+                        continue;
+                    }
+                    next = std::min(next, expiry);
+                    waiting = true;
+                    ++it;
+                }
+            }
+
+            if (!expired.empty()) {
+                lock.unlock();
+                for (std::unique_ptr<PooledAssociation>& association : expired) {
+                    try {
+                        association->scu().release();
+                    }
+                    catch (const std::exception&) {
+                    }
+                }
+                expired.clear();
+                _changed.notify_all();
+                lock.lock();
+                continue;
+            }
+
+            if (!waiting) {
+                break;
+            }
+            _changed.wait_until(lock, next);
+        }
+        _reaperRunning = false;
+    }
+
+} // namespace ns
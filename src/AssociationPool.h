@@ -0,0 +1,126 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../library/include/imebra/acse.h"
+#include "../library/include/imebra/dimse.h"
+#include "../library/include/imebra/tcpStream.h"
+#include "../library/include/imebra/streamReader.h"
+#include "../library/include/imebra/streamWriter.h"
+
+#include "Utils.h"
+
+namespace ns {
+
+    // The presentation contexts proposed by an scu association. Each abstract
+    // syntax is proposed with the implicit and explicit little endian transfer
+    // syntaxes, the verification sop class is always added so that idle
+    // associations can be checked with a c-echo.
+    struct sContexts {
+        std::vector<std::string> abstractSyntaxes;
+        // abstract syntaxes for which the scp role is requested too (c-get storage)
+        std::vector<std::string> scpAbstractSyntaxes;
+
+        imebra::PresentationContexts build() const;
+
+        std::string key() const;
+    };
+
+    // An scu association together with the stream, reader and writer it runs on
+    class PooledAssociation {
+    public:
+        PooledAssociation(const sInput& in, const sContexts& contexts);
+
+        imebra::AssociationSCU& scu() {
+            return _scu;
+        }
+
+        imebra::DimseService& dimse() {
+            return _dimse;
+        }
+
+        // sends a c-echo, returns false if the association is no longer usable
+        bool echo();
+
+        std::chrono::steady_clock::time_point lastUsed;
+        std::chrono::milliseconds idleTimeout;
+
+    private:
+        imebra::TCPStream _tcpStream;
+        imebra::StreamReader _readSCU;
+        imebra::StreamWriter _writeSCU;
+        imebra::AssociationSCU _scu;
+        imebra::DimseService _dimse;
+    };
+
+    // Keeps the scu associations open between requests when keepAlive is set.
+    // The associations are keyed by calling aet, called aet, host, port and
+    // presentation contexts; an idle one is reused (after a c-echo if it has
+    // been idle for a while), otherwise a new one is opened as long as there
+    // are less than maxAssociations for the key. Idle associations are released
+    // after idleTimeout milliseconds.
+    class AssociationPool {
+    public:
+        // The association borrowed by a request. Unless done() is called the
+        // association is considered broken and is closed when the lease is destroyed
+        class Lease {
+        public:
+            Lease(AssociationPool* pool, const std::string& key, std::unique_ptr<PooledAssociation> association);
+            Lease(Lease&& source);
+            ~Lease();
+
+            Lease(const Lease&) = delete;
+            Lease& operator=(const Lease&) = delete;
+
+            imebra::AssociationSCU& scu() {
+                return _association->scu();
+            }
+
+            imebra::DimseService& dimse() {
+                return _association->dimse();
+            }
+
+            // the request completed, the association is returned to the pool or,
+            // if it is not pooled, released
+            void done();
+
+        private:
+            AssociationPool* _pool;
+            std::string _key;
+            std::unique_ptr<PooledAssociation> _association;
+        };
+
+        static AssociationPool& instance();
+
+        ~AssociationPool();
+
+        // returns a pooled association when in.keepAlive is set, a new one otherwise
+        Lease acquire(const sInput& in, const sContexts& contexts);
+
+    private:
+        AssociationPool();
+
+        void giveBack(const std::string& key, std::unique_ptr<PooledAssociation> association);
+
+        void discard(const std::string& key);
+
+        void reaperProc();
+
+        std::mutex _mutex;
+        std::condition_variable _changed;
+        std::map<std::string, std::list<std::unique_ptr<PooledAssociation> > > _idle;
+        std::map<std::string, size_t> _open;
+        std::thread _reaper;
+        bool _reaperRunning;
+        bool _stopped;
+    };
+
+} // namespace ns
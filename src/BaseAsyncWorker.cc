@@ -2,7 +2,18 @@
 
 #include "Utils.h"
 
-BaseAsyncWorker::BaseAsyncWorker(std::string data, Function &callback) : AsyncProgressWorker<char>(callback),
+namespace {
+    // Sent through the progress queue in place of a binary message, the
+    // json responses never start with a null character
+    const char binaryMarker = '\0';
+
+    void deleteMemory(Napi::Env, void*, imebra::MutableMemory* memory)
+    {
+        delete memory;
+    }
+}
+
+BaseAsyncWorker::BaseAsyncWorker(std::string data, Function &callback) : AsyncProgressQueueWorker<char>(callback),
                                                                            _input(data)
 {
 }
@@ -18,6 +29,20 @@ void BaseAsyncWorker::OnOK()
 void BaseAsyncWorker::OnProgress(const char *data, size_t size)
 {
         HandleScope scope(Env());
+        if (size == 1 && data[0] == binaryMarker) {
+                sBinaryMessage message;
+                {
+                        std::lock_guard<std::mutex> lock(_binaryMutex);
+                        message = std::move(_binaryMessages.front());
+                        _binaryMessages.pop();
+                }
+                size_t bufferSize(0);
+                char* bufferData = message.buffer->data(&bufferSize);
+                ArrayBuffer buffer = ArrayBuffer::New(Env(), bufferData, bufferSize, deleteMemory, message.buffer.release());
+                String o = String::New(Env(), message.response);
+                Callback().Call({o, buffer});
+                return;
+        }
         String o = String::New(Env(), data, size);
         Callback().Call({o});
 }
@@ -32,4 +57,16 @@ void BaseAsyncWorker::SendInfo(const std::string& msg, const ExecutionProgress&
 {
     std::string msg2 = ns::createJsonResponse(status, msg);
     progress.Send(msg2.c_str(), msg2.length());
-}
\ No newline at end of file
+}
+void BaseAsyncWorker::SendBinary(const std::string& msg, const imebra::MutableMemory& buffer, const ExecutionProgress& progress, const nlohmann::json& container, ns::eStatus status)
+{
+    sBinaryMessage message;
+    message.response = ns::createJsonResponse(status, msg, container);
+    // MutableMemory copies share the same data
+    message.buffer.reset(new imebra::MutableMemory(buffer));
+    {
+        std::lock_guard<std::mutex> lock(_binaryMutex);
+        _binaryMessages.push(std::move(message));
+    }
+    progress.Send(&binaryMarker, 1);
+}
@@ -2,13 +2,18 @@
 
 #include <napi.h>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
 
 #include "json.h"
 #include "Utils.h"
 
+#include "../library/include/imebra/mutableMemory.h"
+
 using namespace Napi;
 
-class BaseAsyncWorker : public AsyncProgressWorker<char>
+class BaseAsyncWorker : public AsyncProgressQueueWorker<char>
 {
     public:
         BaseAsyncWorker(std::string data, Function &callback);
@@ -23,6 +28,20 @@ class BaseAsyncWorker : public AsyncProgressWorker<char>
 
         void SendInfo(const std::string& msg, const ExecutionProgress& progress, ns::eStatus status = ns::PENDING);
 
+        // Hands the buffer over to javascript as an external ArrayBuffer, the
+        // data is not copied. The callback receives the json response and the
+        // ArrayBuffer, the memory is released when the ArrayBuffer is collected.
+        void SendBinary(const std::string& msg, const imebra::MutableMemory& buffer, const ExecutionProgress& progress, const nlohmann::json& container = nlohmann::json(), ns::eStatus status = ns::PENDING);
+
         std::string _input;
         nlohmann::json _jsonOutput;
+
+    private:
+        struct sBinaryMessage {
+            std::string response;
+            std::unique_ptr<imebra::MutableMemory> buffer;
+        };
+
+        std::mutex _binaryMutex;
+        std::queue<sBinaryMessage> _binaryMessages;
 };
@@ -0,0 +1,132 @@
+#include "DiskWriter.h"
+
+#include "../library/include/imebra/imebra.h"
+#include "../library/include/imebra/codecFactory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <sstream>
+#include <sys/stat.h>
+
+#include "json.h"
+#include "Utils.h"
+
+using json = nlohmann::json;
+
+namespace ns {
+
+    DiskWriter::DiskWriter(const std::string& storagePath, size_t numThreads, size_t maxQueued, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress, written_t onWritten)
+        : _storagePath(storagePath)
+        , _progress(progress)
+        , _onWritten(onWritten)
+        , _bytesWritten(0)
+    {
+        if (numThreads > 0) {
+            _pool.reset(new ThreadPool(numThreads, maxQueued));
+        }
+    }
+
+    DiskWriter::~DiskWriter()
+    {
+        if (_pool) {
+            _pool->stop();
+        }
+    }
+
+    bool DiskWriter::store(const imebra::DataSet& payload, const std::string& sopInstanceUid, stored_t onStored)
+    {
+        if (!_pool) {
+            const bool stored = write(payload, sopInstanceUid);
+            if (onStored) {
+                onStored(stored);
+            }
+            return stored;
+        }
+        // DataSet copies share the same implementation object, the queued task keeps it alive
+        imebra::DataSet queued(payload);
+        const bool queuedOk = _pool->push([this, queued, sopInstanceUid, onStored]() {
+            const bool stored = write(queued, sopInstanceUid);
+            if (onStored) {
+                onStored(stored);
+            }
+        });
+        if (!queuedOk) {
+            std::string msg = createJsonResponse(FAILURE, "failed to queue " + sopInstanceUid + ": the writer has been stopped");
+            _progress.Send(msg.c_str(), msg.length());
+            if (onStored) {
+                onStored(false);
+            }
+        }
+        return queuedOk;
+    }
+
+    void DiskWriter::flush()
+    {
+        if (_pool) {
+            _pool->wait();
+        }
+    }
+
+    std::uint64_t DiskWriter::save(const imebra::DataSet& payload, const std::string& fileName)
+    {
+        std::ostringstream tmpName;
+        tmpName << fileName << "." << std::this_thread::get_id() << ".tmp";
+        try {
+            imebra::CodecFactory::save(payload, tmpName.str(), imebra::codecType_t::dicom);
+        }
+        catch (...) {
+            std::remove(tmpName.str().c_str());
+            throw;
+        }
+        struct stat info;
+        const std::uint64_t size = stat(tmpName.str().c_str(), &info) == 0 ? (std::uint64_t)info.st_size : 0;
+        if (std::rename(tmpName.str().c_str(), fileName.c_str()) != 0) {
+            std::remove(tmpName.str().c_str());
+            throw std::runtime_error("failed to rename " + tmpName.str() + " to " + fileName);
+        }
+        return size;
+    }
+
+    bool DiskWriter::write(const imebra::DataSet& payload, const std::string& sopInstanceUid)
+    {
+        // The UID sent by the peer becomes the file name: accept only valid
+        // UID characters, so it cannot point outside the storage path
+        if (sopInstanceUid.empty() || sopInstanceUid.find_first_not_of("0123456789.") != std::string::npos) {
+            std::string msg = createJsonResponse(FAILURE, "failed to write " + sopInstanceUid + ": invalid sop instance uid");
+            _progress.Send(msg.c_str(), msg.length());
+            return false;
+        }
+        const std::string fileName = _storagePath + "/" + sopInstanceUid + ".dcm";
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        try {
+            _bytesWritten += save(payload, fileName);
+        }
+        catch (const std::exception& e) {
+            std::string msg = createJsonResponse(FAILURE, "failed to write " + sopInstanceUid + ": " + std::string(e.what()));
+            _progress.Send(msg.c_str(), msg.length());
+            return false;
+        }
+        if (_onWritten) {
+            try {
+                _onWritten(fileName);
+            }
+            catch (const std::exception& e) {
+                std::string msg = createJsonResponse(FAILURE, "failed to index " + sopInstanceUid + ": " + std::string(e.what()));
+                _progress.Send(msg.c_str(), msg.length());
+            }
+        }
+        if (!_pool) {
+            return true;
+        }
+        double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        json stats = {
+            {"queueDepth", _pool->queued()},
+            {"writeLatencyMs", latency}
+        };
+        std::string msg = createJsonResponse(PENDING, "written: " + sopInstanceUid, stats);
+        _progress.Send(msg.c_str(), msg.length());
+        return true;
+    }
+
+} // namespace ns
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <napi.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "../library/include/imebra/dataSet.h"
+
+#include "ThreadPool.h"
+
+using namespace Napi;
+
+namespace ns {
+
+    // Persists received datasets into the storage folder.
+    // Files are written to a temporary name and renamed once complete so that
+    // readers of the storage folder never see partially written instances.
+    // With numThreads == 0 the datasets are written synchronously by store(),
+    // otherwise they are queued and written by a pool of writer threads.
+    // Either way the caller learns the outcome of each write through the
+    // stored_t callback passed to store().
+    class DiskWriter {
+    public:
+        // called with the name of each file once it is complete
+        typedef std::function<void(const std::string&)> written_t;
+
+        // called once the dataset passed to store() has been written (true)
+        // or could not be written (false). In asynchronous mode it is called
+        // by a writer thread
+        typedef std::function<void(bool)> stored_t;
+
+        DiskWriter(const std::string& storagePath, size_t numThreads, size_t maxQueued, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress, written_t onWritten = nullptr);
+
+        ~DiskWriter();
+
+        // stores the dataset under <storagePath>/<sopInstanceUid>.dcm. A uid
+        // that contains characters other than digits and dots is not stored.
+        // In asynchronous mode it returns as soon as the dataset is queued and
+        // blocks while the queue is full.
+        // Returns false if the dataset could not be written or, in
+        // asynchronous mode, could not be queued.
+        bool store(const imebra::DataSet& payload, const std::string& sopInstanceUid, stored_t onStored = nullptr);
+
+        // waits until all the queued datasets have been written
+        void flush();
+
+        bool isAsync() const {
+            return _pool != nullptr;
+        }
+
+        // size of the files written so far
+        std::uint64_t bytesWritten() const {
+            return _bytesWritten;
+        }
+
+        // writes the dataset to a temporary file renamed to fileName once
+        // complete, returns the size of the file
+        static std::uint64_t save(const imebra::DataSet& payload, const std::string& fileName);
+
+    private:
+        bool write(const imebra::DataSet& payload, const std::string& sopInstanceUid);
+
+        const std::string _storagePath;
+        const AsyncProgressQueueWorker<char>::ExecutionProgress& _progress;
+        const written_t _onWritten;
+        std::unique_ptr<ThreadPool> _pool;
+        std::atomic<std::uint64_t> _bytesWritten;
+    };
+
+} // namespace ns
@@ -22,6 +22,7 @@ using namespace imebra;
 
 #include "json.h"
 #include "Utils.h"
+#include "AssociationPool.h"
 
 using json = nlohmann::json;
 
@@ -45,31 +46,16 @@ void EchoAsyncWorker::Execute(const ExecutionProgress& progress)
 
     const std::string abstractSyntax = imebra::uidVerificationSOPClass_1_2_840_10008_1_1;
 
-    // Allocate a TCP stream that connects to the DICOM SCP
-    imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port));
+    // Presentation contexts proposed to the SCP, the association is reused
+    // between requests when keepAlive is set
+    ns::sContexts contexts;
+    contexts.abstractSyntaxes.push_back(abstractSyntax);
 
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
-
-     // Add all the abstract syntaxes and the supported transfer
-    // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
-    // called "presentation context")
-    imebra::PresentationContext context(abstractSyntax);
-    context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-    context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-    imebra::PresentationContexts presentationContexts;
-    presentationContexts.addPresentationContext(context);
-
-    // The AssociationSCU constructor will negotiate a connection through
-    // the readSCU and writeSCU stream reader and writer
-    imebra::AssociationSCU scu(in.source.aet, in.target.aet, 1, 1, presentationContexts, readSCU, writeSCU, 10);
+    ns::AssociationPool::Lease association(ns::AssociationPool::instance().acquire(in, contexts));
 
     // The DIMSE service will use the negotiated association to send and receive
     // DICOM commands
-    imebra::DimseService dimse(scu);
+    imebra::DimseService& dimse = association.dimse();
 
     imebra::CEchoCommand command( abstractSyntax,
         dimse.getNextCommandID(),
@@ -90,6 +76,7 @@ void EchoAsyncWorker::Execute(const ExecutionProgress& progress)
         {
                 SetErrorJson("Echo-scu request failed: " + std::to_string(response.getStatusCode()));
         }
+        association.done();
     }
     catch (std::exception &error)
     {
@@ -15,12 +15,14 @@
 
 #include "json.h"
 #include "Utils.h"
+#include "AssociationPool.h"
 
 #include <iostream>
 #include <sstream>
 #include <memory>
 #include <list>
 #include <iomanip>
+#include <algorithm>
 
 using namespace imebra;
 using json = nlohmann::json;
@@ -41,6 +43,30 @@ namespace {
             << std::hex << i;
     return str_toupper(stream.str());
     }
+
+    json toJson(const imebra::DataSet& data) {
+        imebra::tagsIds_t allTags = data.getTags();
+        json v = json::object();
+        for (imebra::tagsIds_t::iterator it = allTags.begin() ; it != allTags.end(); ++it) {
+            imebra::TagId tag(*it);
+            std::string value = data.getString(tag, 0);
+            std::string keyName =  int_to_hex(tag.getGroupId()) + int_to_hex(tag.getTagId());
+            imebra::tagVR_t tagVr = imebra::DicomDictionary::getTagType(tag);
+            std::string vr = ns::tagVrName(tagVr);
+            if (tagVr == imebra::tagVR_t::PN) {
+            v[keyName] = { 
+                {"Value", json::array({ json{{"Alphabetic", value}} }) },
+                {"vr", vr}
+            };
+            } else {
+            v[keyName] = { 
+                {"Value", json::array({value})},
+                {"vr", vr}
+            };
+            }
+        }
+        return v;
+    }
 }
 
 FindAsyncWorker::FindAsyncWorker(std::string data, Function &callback) : BaseAsyncWorker(data, callback)
@@ -68,31 +94,16 @@ void FindAsyncWorker::Execute(const ExecutionProgress& progress)
 
     const std::string abstractSyntax = uidStudyRootQueryRetrieveInformationModelFIND_1_2_840_10008_5_1_4_1_2_2_1;
 
-    // Allocate a TCP stream that connects to the DICOM SCP
-    imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port));
+    // Presentation contexts proposed to the SCP, the association is reused
+    // between requests when keepAlive is set
+    ns::sContexts contexts;
+    contexts.abstractSyntaxes.push_back(abstractSyntax);
 
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
-
-    // Add all the abstract syntaxes and the supported transfer
-    // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
-    // called "presentation context")
-    imebra::PresentationContext context(abstractSyntax);
-    context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-    context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-    imebra::PresentationContexts presentationContexts;
-    presentationContexts.addPresentationContext(context);
-
-    // The AssociationSCU constructor will negotiate a connection through
-    // the readSCU and writeSCU stream reader and writer
-    imebra::AssociationSCU scu(in.source.aet, in.target.aet, 1, 1, presentationContexts, readSCU, writeSCU, 10);
+    ns::AssociationPool::Lease association(ns::AssociationPool::instance().acquire(in, contexts));
 
     // The DIMSE service will use the negotiated association to send and receive
     // DICOM commands
-    imebra::DimseService dimse(scu);
+    imebra::DimseService& dimse = association.dimse();
 
     // Let's prepare a dataset to store on the SCP
     imebra::MutableDataSet payload; // We will use the negotiated transfer syntax
@@ -109,9 +120,49 @@ void FindAsyncWorker::Execute(const ExecutionProgress& progress)
         payload);
     dimse.sendCommandOrResponse(command);
 
+    // In stream (and binary) mode the results are sent through the progress callback in
+    // batches of batchSize as they arrive, instead of being collected
+    const size_t batchSize = (size_t)std::max(in.batchSize, 1);
+    size_t count(0);
+    json outJson = json::array();
+    auto flush = [&]() {
+        if (outJson.empty()) {
+            return;
+        }
+        std::string msg = ns::createJsonResponse(ns::PENDING, "results", outJson);
+        progress.Send(msg.c_str(), msg.length());
+        outJson = json::array();
+    };
+
+    // In binary mode the matches are encoded as DICOM files one after the
+    // other in a single buffer, the container lists where each one starts
+    std::unique_ptr<imebra::MutableMemory> batch;
+    std::unique_ptr<imebra::MemoryStreamOutput> batchStream;
+    std::unique_ptr<imebra::StreamWriter> batchWriter;
+    json offsets = json::array();
+    auto flushBinary = [&]() {
+        if (offsets.empty()) {
+            return;
+        }
+        batchWriter.reset();
+        SendBinary("results", *batch, progress, {{"offsets", offsets}});
+        batchStream.reset();
+        batch.reset();
+        offsets = json::array();
+    };
+    auto encode = [&](const imebra::DataSet& data) {
+        if (!batch) {
+            batch.reset(new imebra::MutableMemory());
+            batchStream.reset(new imebra::MemoryStreamOutput(*batch));
+            batchWriter.reset(new imebra::StreamWriter(*batchStream));
+        }
+        batchWriter->flush();
+        offsets.push_back(batch->size());
+        imebra::CodecFactory::save(data, *batchWriter, imebra::codecType_t::dicom);
+    };
+
     try
     {
-        json outJson = json::array();
         for (;;)
         {
 
@@ -126,27 +177,19 @@ void FindAsyncWorker::Execute(const ExecutionProgress& progress)
             imebra::DataSet data = rsp.getPayloadDataSet();
             try
             {
-                imebra::tagsIds_t allTags = data.getTags();
-                json v = json::object();
-                for (imebra::tagsIds_t::iterator it = allTags.begin() ; it != allTags.end(); ++it) {
-                    imebra::TagId tag(*it);
-                    std::string value = data.getString(tag, 0);
-                    std::string keyName =  int_to_hex(tag.getGroupId()) + int_to_hex(tag.getTagId());
-                    imebra::tagVR_t tagVr = imebra::DicomDictionary::getTagType(tag);
-                    std::string vr = ns::tagVrName(tagVr);
-                    if (tagVr == imebra::tagVR_t::PN) {
-                    v[keyName] = { 
-                        {"Value", json::array({ json{{"Alphabetic", value}} }) },
-                        {"vr", vr}
-                    };
-                    } else {
-                    v[keyName] = { 
-                        {"Value", json::array({value})},
-                        {"vr", vr}
-                    };
+                ++count;
+                if (in.binary) {
+                    encode(data);
+                    if (offsets.size() >= batchSize) {
+                        flushBinary();
+                    }
+                }
+                else {
+                    outJson.push_back(toJson(data));
+                    if (in.stream && outJson.size() >= batchSize) {
+                        flush();
                     }
                 }
-                outJson.push_back(v);
             }
             catch (std::exception & e)
             {
@@ -159,7 +202,18 @@ void FindAsyncWorker::Execute(const ExecutionProgress& progress)
             break;
         }
         }
-        _jsonOutput = outJson.dump();
+        association.done();
+        if (in.binary) {
+            flushBinary();
+            _jsonOutput = {{"count", count}};
+        }
+        else if (in.stream) {
+            flush();
+            _jsonOutput = {{"count", count}};
+        }
+        else {
+            _jsonOutput = outJson.dump();
+        }
     }
     catch (const StreamEOFError & error)
     {
@@ -15,49 +15,69 @@
 #include <sstream>
 #include <memory>
 #include <list>
-#include <thread>
-#include <future>
-#include <chrono>
 
 using namespace imebra;
 
 #include "json.h"
 #include "Utils.h"
+#include "SubOperationProgress.h"
+#include "DiskWriter.h"
+#include "AssociationPool.h"
 
 using json = nlohmann::json;
 
 namespace {
 
-        void StoreProc(imebra::DimseService* dimse, const AsyncProgressWorker<char>::ExecutionProgress& progress, std::string storagePath, std::future<void> futureObj)
-        {
-        while (futureObj.wait_for(std::chrono::milliseconds(1)) == std::future_status::timeout)
+    // Serves one C-STORE sub-operation of the C-GET.
+    // The response is sent once the instance has been written, by the writer
+    // thread when the writer is asynchronous, or once it is queued with
+    // ackOnQueue
+    void StoreInstance(imebra::DimseService& dimse, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress, ns::DiskWriter& diskWriter, bool ackOnQueue)
+    {
+        // receive a C-Store
+        imebra::CStoreCommand command(dimse.getCommand().getAsCStoreCommand());
+
+        try
         {
-                try
-                {
-                    // receive a C-Store
-                    imebra::CStoreCommand command(dimse->getCommand().getAsCStoreCommand());
-
-                    // The store command has a payload. We can do something with it, or we can
-                    // use the methods in CStoreCommand to get other data sent by the peer
-                    imebra::DataSet payload = command.getPayloadDataSet();
-
-                    // Do something with the payload
-                    std::string sop = payload.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0);
-                    imebra::CodecFactory::save(payload, storagePath + "/" + sop + std::string(".dcm"), imebra::codecType_t::dicom);
-                   
-                    std::string msg = ns::createJsonResponse(ns::PENDING, "storing: " + sop);
-                    progress.Send(msg.c_str(), msg.length());
+            // The store command has a payload. We can do something with it, or we can
+            // use the methods in CStoreCommand to get other data sent by the peer
+            imebra::DataSet payload = command.getPayloadDataSet();
+
+            // Do something with the payload
+            std::string sop = payload.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0);
+
+            std::string msg = ns::createJsonResponse(ns::PENDING, "storing: " + sop);
+            progress.Send(msg.c_str(), msg.length());
+
+            if (ackOnQueue && diskWriter.isAsync()) {
+                // A write that fails later is only reported through the
+                // progress messages
+                const bool queued = diskWriter.store(payload, sop);
+                dimse.sendCommandOrResponse(CStoreResponse(command, queued ? dimseStatusCode_t::success : dimseStatusCode_t::outOfResources));
+                return;
+            }
 
-                    // Send a response
-                    dimse->sendCommandOrResponse(CStoreResponse(command, dimseStatusCode_t::success));
+            diskWriter.store(payload, sop, [&dimse, command, sop, &progress](bool stored) {
+                try {
+                    dimse.sendCommandOrResponse(CStoreResponse(command, stored ? dimseStatusCode_t::success : dimseStatusCode_t::outOfResources));
                 }
-                catch (std::exception e)
-                {
-                    std::cerr << "exception: " << e.what() << std::endl;
-                    break;
+                catch (const std::exception& e) {
+                    std::string msg = ns::createJsonResponse(ns::FAILURE, "failed to send the response for " + sop + ": " + std::string(e.what()));
+                    progress.Send(msg.c_str(), msg.length());
                 }
-        }    
+            });
         }
+        catch (const StreamError&)
+        {
+            throw;
+        }
+        catch (const std::exception& e)
+        {
+            std::string msg = ns::createJsonResponse(ns::FAILURE, "store failed: " + std::string(e.what()));
+            progress.Send(msg.c_str(), msg.length());
+            dimse.sendCommandOrResponse(CStoreResponse(command, dimseStatusCode_t::unableToProcess));
+        }
+    }
 }
 
 GetAsyncWorker::GetAsyncWorker(std::string data, Function &callback) : BaseAsyncWorker(data, callback)
@@ -93,42 +113,28 @@ void GetAsyncWorker::Execute(const ExecutionProgress& progress)
         SendInfo("storage path not set, defaulting to " + in.storagePath, progress);
     }
 
-    const std::string abstractSyntax = uidStudyRootQueryRetrieveInformationModelGET_1_2_840_10008_5_1_4_1_2_2_3;
+    if (in.writerThreads < 0) {
+        in.writerThreads = 0;
+    }
 
-    // Allocate a TCP stream that connects to the DICOM SCP
-    imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port));
-
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
-
-    // Add all the abstract syntaxes and the supported transfer
-    // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
-    // called "presentation context")
-    imebra::PresentationContext context(abstractSyntax);
-    context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-    context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-    imebra::PresentationContexts presentationContexts;
-    presentationContexts.addPresentationContext(context);
-
-    std::vector<std::string> dcmLongSCUStorageSOPClassUIDs = ns::dcmLongSCUStorageSOPClassUIDs();
-    for (int j = 0; j < dcmLongSCUStorageSOPClassUIDs.size(); j++)
-    {
-        imebra::PresentationContext context(dcmLongSCUStorageSOPClassUIDs[j], true, true);
-        context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-        context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-        presentationContexts.addPresentationContext(context);
+    if (in.writerQueueSize < 0) {
+        in.writerQueueSize = 0;
     }
 
-    // The AssociationSCU constructor will negotiate a connection through
-    // the readSCU and writeSCU stream reader and writer
-    imebra::AssociationSCU scu(in.source.aet, in.target.aet, 1, 1, presentationContexts, readSCU, writeSCU, 10);
+    const std::string abstractSyntax = uidStudyRootQueryRetrieveInformationModelGET_1_2_840_10008_5_1_4_1_2_2_3;
+
+    // Presentation contexts proposed to the SCP, we act as scp for the
+    // storage sop classes. The association is reused between requests when
+    // keepAlive is set
+    ns::sContexts contexts;
+    contexts.abstractSyntaxes.push_back(abstractSyntax);
+    contexts.scpAbstractSyntaxes = ns::dcmLongSCUStorageSOPClassUIDs();
+
+    ns::AssociationPool::Lease association(ns::AssociationPool::instance().acquire(in, contexts));
 
     // The DIMSE service will use the negotiated association to send and receive
     // DICOM commands
-    imebra::DimseService dimse(scu);
+    imebra::DimseService& dimse = association.dimse();
 
     // Let's prepare a dataset to store on the SCP
     imebra::MutableDataSet payload; // We will use the negotiated transfer syntax
@@ -143,55 +149,52 @@ void GetAsyncWorker::Execute(const ExecutionProgress& progress)
         abstractSyntax,
         payload);
 
-    // Create a std::promise object
-	std::promise<void> exitSignal;
- 
-	//Fetch std::future object associated with promise
-	std::future<void> futureObj = exitSignal.get_future();
+    // Received instances are written either before the response is sent or,
+    // with writerThreads > 0, by the writer threads that then send the
+    // response. Declared after the association, so the pending responses are
+    // sent before the association is released
+    ns::DiskWriter diskWriter(in.storagePath, in.writerThreads, in.writerQueueSize, progress);
 
     dimse.sendCommandOrResponse(command);
-    std::thread storeProc(StoreProc, &dimse, progress, in.storagePath, std::move(futureObj));
+
+    // Sub-operation counters, sent at most every progressInterval milliseconds
+    ns::SubOperationProgress subOperations(progress, in.progressInterval);
 
     try
     {
 
         for (;;)
         {
-            imebra::DimseResponse response(dimse.getCGetResponse(command));
-            if (response.getStatus() == imebra::dimseStatus_t::success)
+            // The C-STORE sub-operations are served on this thread as they
+            // arrive, between the C-GET responses
+            if (dimse.waitCommandOrResponse(command))
             {
-                _jsonOutput = {};
-            	exitSignal.set_value();
+                StoreInstance(dimse, progress, diskWriter, in.ackOnQueue);
+                continue;
+            }
+
+            imebra::CGetResponse response(dimse.getCGetResponse(command));
+            // A final warning (0xB000) means that some sub-operations failed or
+            // completed with warnings: the counters report how many
+            if (response.getStatus() == imebra::dimseStatus_t::success || response.getStatus() == imebra::dimseStatus_t::warning)
+            {
+                subOperations.update(response, diskWriter.bytesWritten());
+                subOperations.flush();
+                _jsonOutput = subOperations.counters();
                 break;
             }
             else if (response.getStatus() == imebra::dimseStatus_t::pending)
             {
-                /*
-                imebra::DataSet data  = response.getPayloadDataSet();
-                try
-                {
-                    int remainNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfRemainingSuboperations_0000_1020), 0);
-                    int completeNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfCompletedSuboperations_0000_1021), 0);
-                    int faileNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfFailedSuboperations_0000_1022), 0);
-                    // int warnNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfWarningSuboperations_0000_1023), 0);
-                    _output = "remaining: " + std::to_string(remainNum) + " completed: " + std::to_string(completeNum);
-                    if (faileNum > 0 ) {
-                        _output += " failed: " + std::to_string(remainNum);
-                    }
-                } 
-                catch (std::exception &error)
-                {
-                    SetErrorJson("parse error: " + std::string(error.what()));
-                }
-                */
+                subOperations.update(response, diskWriter.bytesWritten());
             }
             else {
-                SetErrorJson("Get-scu request failed: " + response.getStatusCode());
-	            exitSignal.set_value();
+                SetErrorJson("Get-scu request failed: " + std::to_string(response.getStatusCode()));
                 break;
             }
         }
-        storeProc.join();
+        // The queued responses must be sent before the association is reused
+        diskWriter.flush();
+        association.done();
     }
     catch (const StreamEOFError & error)
     {
@@ -0,0 +1,814 @@
+#include "InstanceIndex.h"
+
+#include "../library/include/imebra/imebra.h"
+#include "../library/include/imebra/codecFactory.h"
+#include "../library/include/imebra/exceptions.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <set>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ThreadPool.h"
+#include "Utils.h"
+
+namespace {
+
+    enum eMatch {
+        WILDCARD, // single value or wildcards
+        NAME,     // like WILDCARD, case insensitive
+        RANGE,    // dates and times, single value or range
+        UID       // single uid, the lists are matched value by value
+    };
+
+    struct sKey {
+        std::uint16_t group;
+        std::uint16_t element;
+        ns::eLevel level;
+        eMatch matching;
+    };
+
+    // The attributes kept in the index, the records store their values in the same order
+    const sKey keys[] = {
+        {0x0010, 0x0020, ns::PATIENT, WILDCARD}, // PatientID
+        {0x0010, 0x0010, ns::PATIENT, NAME},     // PatientName
+        {0x0010, 0x0030, ns::PATIENT, RANGE},    // PatientBirthDate
+        {0x0010, 0x0040, ns::PATIENT, WILDCARD}, // PatientSex
+        {0x0020, 0x000D, ns::STUDY, UID},        // StudyInstanceUID
+        {0x0008, 0x0020, ns::STUDY, RANGE},      // StudyDate
+        {0x0008, 0x0030, ns::STUDY, RANGE},      // StudyTime
+        {0x0008, 0x0050, ns::STUDY, WILDCARD},   // AccessionNumber
+        {0x0020, 0x0010, ns::STUDY, WILDCARD},   // StudyID
+        {0x0008, 0x1030, ns::STUDY, NAME},       // StudyDescription
+        {0x0008, 0x0090, ns::STUDY, NAME},       // ReferringPhysicianName
+        {0x0020, 0x000E, ns::SERIES, UID},       // SeriesInstanceUID
+        {0x0008, 0x0060, ns::SERIES, WILDCARD},  // Modality
+        {0x0020, 0x0011, ns::SERIES, WILDCARD},  // SeriesNumber
+        {0x0008, 0x103E, ns::SERIES, NAME},      // SeriesDescription
+        {0x0008, 0x0018, ns::IMAGE, UID},        // SOPInstanceUID
+        {0x0008, 0x0016, ns::IMAGE, UID},        // SOPClassUID
+        {0x0020, 0x0013, ns::IMAGE, WILDCARD}    // InstanceNumber
+    };
+    const size_t keysCount = sizeof(keys) / sizeof(keys[0]);
+
+    // the fields of a record: the file name, the transfer syntax, then the keys
+    const size_t fileNameField = 0;
+    const size_t transferSyntaxField = 1;
+    const size_t firstKeyField = 2;
+    const size_t fieldsCount = firstKeyField + keysCount;
+
+    // The journal starts with a header, followed by the records:
+    //  - record size (uint32)
+    //  - checksum of the record data (uint32)
+    //  - record data: the lengths of the fields (uint16 each), then their values
+    // All the integers are little endian. The header holds the version and a
+    // hash of the keys table: a journal written with a different version or
+    // keys table is discarded
+    const char journalMagic[8] = {'D', 'I', 'M', 'S', 'E', 'I', 'D', 'X'};
+    const std::uint32_t journalVersion = 2;
+    const size_t journalHeaderSize = sizeof(journalMagic) + 8;
+    const size_t recordHeaderSize = 8;
+
+    // position in keys of the unique key of each level
+    const size_t uniqueKeys[] = {0, 4, 11, 15};
+    const size_t patientId = 0;
+    const size_t studyInstanceUid = 4;
+    const size_t seriesInstanceUid = 11;
+    const size_t modality = 12;
+    const size_t sopInstanceUid = 15;
+    const size_t sopClassUid = 16;
+
+    const char* levelNames[] = {"PATIENT", "STUDY", "SERIES", "IMAGE"};
+
+    const std::string implicitVRLittleEndian = imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2;
+
+    void putUint16(std::string& buffer, std::uint16_t value) {
+        buffer.push_back((char)(value & 0xff));
+        buffer.push_back((char)(value >> 8));
+    }
+
+    void putUint32(std::string& buffer, std::uint32_t value) {
+        for (size_t shift = 0; shift != 32; shift += 8) {
+            buffer.push_back((char)((value >> shift) & 0xff));
+        }
+    }
+
+    std::uint16_t getUint16(const unsigned char* pData) {
+        return (std::uint16_t)(pData[0] | (pData[1] << 8));
+    }
+
+    std::uint32_t getUint32(const unsigned char* pData) {
+        return (std::uint32_t)pData[0] | ((std::uint32_t)pData[1] << 8) | ((std::uint32_t)pData[2] << 16) | ((std::uint32_t)pData[3] << 24);
+    }
+
+    // FNV-1a, detects the records truncated or garbled by a crash
+    std::uint32_t checksum(const char* pData, size_t size) {
+        std::uint32_t hash = 2166136261u;
+        for (size_t position = 0; position != size; ++position) {
+            hash = (hash ^ (unsigned char)pData[position]) * 16777619u;
+        }
+        return hash;
+    }
+
+    // hash of the fields layout and of the tags and matching of each key
+    std::uint32_t keysHash() {
+        std::string layout;
+        putUint16(layout, (std::uint16_t)fieldsCount);
+        for (const sKey& key : keys) {
+            putUint16(layout, key.group);
+            putUint16(layout, key.element);
+            layout.push_back((char)key.level);
+            layout.push_back((char)key.matching);
+        }
+        return checksum(layout.data(), layout.size());
+    }
+
+    std::string journalHeader() {
+        std::string header(journalMagic, sizeof(journalMagic));
+        putUint32(header, journalVersion);
+        putUint32(header, keysHash());
+        return header;
+    }
+
+    void writeRecord(std::ostream& stream, const std::string& data) {
+        std::string header;
+        putUint32(header, (std::uint32_t)data.size());
+        putUint32(header, checksum(data.data(), data.size()));
+        stream.write(header.data(), (std::streamsize)header.size());
+        stream.write(data.data(), (std::streamsize)data.size());
+    }
+
+    // Read only view of a whole file, empty if the file cannot be opened
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path)
+            : _pData(nullptr)
+            , _size(0)
+        {
+#ifdef _WIN32
+            _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            _mapping = nullptr;
+            LARGE_INTEGER size;
+            if (_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+                return;
+            }
+            _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (_mapping == nullptr) {
+                return;
+            }
+            _pData = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (_pData != nullptr) {
+                _size = (size_t)size.QuadPart;
+            }
+#else
+            _file = open(path.c_str(), O_RDONLY);
+            struct stat info;
+            if (_file < 0 || fstat(_file, &info) != 0 || info.st_size == 0) {
+                return;
+            }
+            void* pData = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, _file, 0);
+            if (pData == MAP_FAILED) {
+                return;
+            }
+            madvise(pData, (size_t)info.st_size, MADV_SEQUENTIAL);
+            _pData = pData;
+            _size = (size_t)info.st_size;
+#endif
+        }
+
+        ~MappedFile()
+        {
+#ifdef _WIN32
+            if (_pData != nullptr) {
+                UnmapViewOfFile(_pData);
+            }
+            if (_mapping != nullptr) {
+                CloseHandle(_mapping);
+            }
+            if (_file != INVALID_HANDLE_VALUE) {
+                CloseHandle(_file);
+            }
+#else
+            if (_pData != nullptr) {
+                munmap(_pData, _size);
+            }
+            if (_file >= 0) {
+                close(_file);
+            }
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const unsigned char* data() const {
+            return (const unsigned char*)_pData;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+    private:
+#ifdef _WIN32
+        HANDLE _file;
+        HANDLE _mapping;
+#else
+        int _file;
+#endif
+        void* _pData;
+        size_t _size;
+    };
+
+    // all the values of a tag, none if the tag is missing or empty
+    std::vector<std::string> getValues(const imebra::DataSet& dataSet, std::uint16_t group, std::uint16_t element) {
+        std::vector<std::string> values;
+        try {
+            for (size_t index = 0; ; ++index) {
+                values.push_back(dataSet.getString(imebra::TagId(group, element), index));
+            }
+        }
+        catch (const imebra::MissingDataElementError&) {
+        }
+        return values;
+    }
+
+    std::string joinValues(const std::vector<std::string>& values) {
+        std::string joined;
+        for (const std::string& value : values) {
+            if (!joined.empty()) {
+                joined += "\\";
+            }
+            joined += value;
+        }
+        return joined;
+    }
+
+    bool sameChar(char a, char b, bool caseInsensitive) {
+        return a == b || (caseInsensitive && std::toupper((unsigned char)a) == std::toupper((unsigned char)b));
+    }
+
+    bool wildcardMatch(const char* pattern, const char* value, bool caseInsensitive) {
+        const char* star = nullptr;
+        const char* resume = nullptr;
+        while (*value != 0) {
+            if (*pattern == '*') {
+                star = pattern++;
+                resume = value;
+            }
+            else if (*pattern != 0 && (*pattern == '?' || sameChar(*pattern, *value, caseInsensitive))) {
+                ++pattern;
+                ++value;
+            }
+            else if (star != nullptr) {
+                pattern = star + 1;
+                value = ++resume;
+            }
+            else {
+                return false;
+            }
+        }
+        while (*pattern == '*') {
+            ++pattern;
+        }
+        return *pattern == 0;
+    }
+
+    bool valueMatches(eMatch matching, const std::string& query, const std::string& value) {
+        if (query == "*") {
+            return true;
+        }
+        switch (matching) {
+        case UID:
+            return query == value;
+        case RANGE: {
+            const size_t separator = query.find('-');
+            if (separator == std::string::npos) {
+                return query == value;
+            }
+            if (value.empty()) {
+                return false;
+            }
+            const std::string from = query.substr(0, separator);
+            const std::string to = query.substr(separator + 1);
+            return (from.empty() || value >= from) && (to.empty() || value.compare(0, to.size(), to) <= 0);
+        }
+        default:
+            return wildcardMatch(query.c_str(), value.c_str(), matching == NAME);
+        }
+    }
+
+    ns::eLevel getLevel(const imebra::DataSet& identifier) {
+        const std::string level = identifier.getString(imebra::TagId(imebra::tagId_t::QueryRetrieveLevel_0008_0052), 0, "");
+        for (size_t scan = 0; scan != sizeof(levelNames) / sizeof(levelNames[0]); ++scan) {
+            if (level == levelNames[scan]) {
+                return (ns::eLevel)scan;
+            }
+        }
+        throw std::runtime_error("unsupported query/retrieve level '" + level + "'");
+    }
+
+    void setValue(imebra::MutableDataSet& dataSet, std::uint16_t group, std::uint16_t element, const std::string& value) {
+        try {
+            dataSet.setString(imebra::TagId(group, element), value);
+        }
+        catch (const std::exception&) {
+            // unknown tag or not a string
+        }
+    }
+}
+
+namespace ns {
+
+    JournalIndex::JournalIndex(const std::string& storagePath)
+        : _storagePath(storagePath)
+        , _created(false)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        load();
+    }
+
+    const char* JournalIndex::journalName()
+    {
+        return "index.bin";
+    }
+
+    size_t JournalIndex::size() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _bySopInstance.size();
+    }
+
+    bool JournalIndex::created() const
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _created;
+    }
+
+    std::string JournalIndex::sRecord::field(size_t field) const
+    {
+        const unsigned char* pLengths = (const unsigned char*)data.data();
+        size_t offset = fieldsCount * 2;
+        for (size_t scan = 0; scan != field; ++scan) {
+            offset += getUint16(pLengths + scan * 2);
+        }
+        return data.substr(offset, getUint16(pLengths + field * 2));
+    }
+
+    std::string JournalIndex::sRecord::fileName() const
+    {
+        return field(fileNameField);
+    }
+
+    std::string JournalIndex::sRecord::transferSyntax() const
+    {
+        return field(transferSyntaxField);
+    }
+
+    std::string JournalIndex::sRecord::value(size_t key) const
+    {
+        return field(firstKeyField + key);
+    }
+
+    JournalIndex::sRecord JournalIndex::readRecord(const std::string& fileName, const std::string& storagePath)
+    {
+        // only the keys are loaded, the parsing stops after the last one
+        static const imebra::tagsIds_t keyTags = []() {
+            imebra::tagsIds_t tags;
+            for (size_t key = 0; key != keysCount; ++key) {
+                tags.push_back(imebra::TagId(keys[key].group, keys[key].element));
+            }
+            return tags;
+        }();
+        imebra::DataSet dataSet = imebra::CodecFactory::load(fileName, keyTags);
+
+        std::vector<std::string> fields(fieldsCount);
+
+        // the files written by the scp are stored relative to the storage folder
+        fields[fileNameField] = fileName;
+        if (fileName.compare(0, storagePath.size() + 1, storagePath + "/") == 0) {
+            fields[fileNameField] = fileName.substr(storagePath.size() + 1);
+        }
+        fields[transferSyntaxField] = dataSet.getString(imebra::TagId(imebra::tagId_t::TransferSyntaxUID_0002_0010), 0, implicitVRLittleEndian);
+        for (size_t key = 0; key != keysCount; ++key) {
+            fields[firstKeyField + key] = joinValues(getValues(dataSet, keys[key].group, keys[key].element));
+        }
+        if (fields[firstKeyField + sopInstanceUid].empty()) {
+            throw std::runtime_error("missing sop instance uid in " + fileName);
+        }
+
+        sRecord record;
+        for (std::string& value : fields) {
+            if (value.size() > 0xffff) {
+                value.resize(0xffff);
+            }
+            putUint16(record.data, (std::uint16_t)value.size());
+        }
+        for (const std::string& value : fields) {
+            record.data += value;
+        }
+        return record;
+    }
+
+    void JournalIndex::load()
+    {
+        const std::string journalPath = _storagePath + "/" + journalName();
+        const std::string header = journalHeader();
+
+        size_t validSize = 0;
+        bool damaged = false;
+        {
+            MappedFile journal(journalPath);
+            const unsigned char* pData = journal.data();
+            const size_t size = journal.size();
+            if (size >= journalHeaderSize && memcmp(pData, header.data(), header.size()) == 0) {
+                // a rough estimate, avoids most of the rehashing
+                _records.reserve(size / 256);
+                _bySopInstance.reserve(size / 256);
+
+                validSize = journalHeaderSize;
+                while (size - validSize >= recordHeaderSize) {
+                    const unsigned char* pRecord = pData + validSize;
+                    const size_t recordSize = getUint32(pRecord);
+                    if (recordSize < fieldsCount * 2 || size - validSize - recordHeaderSize < recordSize ||
+                            checksum((const char*)pRecord + recordHeaderSize, recordSize) != getUint32(pRecord + 4)) {
+                        // A crash while a record was being appended leaves it
+                        // at the end of the journal, and the records before it
+                        // are kept. A bad record followed by other data means
+                        // that the journal is damaged: the records after it
+                        // can't be located, so the index is rebuilt from the files
+                        damaged = size - validSize - recordHeaderSize > recordSize;
+                        break;
+                    }
+                    sRecord record;
+                    record.data.assign((const char*)pRecord + recordHeaderSize, recordSize);
+                    insert(record);
+                    validSize += recordHeaderSize + recordSize;
+                }
+            }
+            if (damaged) {
+                clear();
+                validSize = 0;
+            }
+            _created = validSize == 0;
+            if (validSize == size) {
+                _journal.open(journalPath, std::ios::app | std::ios::binary);
+                if (!_journal) {
+                    throw std::runtime_error("cannot open the index journal " + journalPath);
+                }
+                return;
+            }
+        }
+
+        // missing, outdated or truncated journal: rewrite the valid records.
+        // A damaged journal is replaced by an empty one until it is rebuilt
+        writeJournal(_records);
+    }
+
+    void JournalIndex::writeJournal(const std::vector<sRecord>& records)
+    {
+        const std::string journalPath = _storagePath + "/" + journalName();
+        const std::string temporaryPath = journalPath + ".tmp";
+        {
+            std::ofstream journal(temporaryPath, std::ios::trunc | std::ios::binary);
+            const std::string header = journalHeader();
+            journal.write(header.data(), (std::streamsize)header.size());
+            for (const sRecord& record : records) {
+                writeRecord(journal, record.data);
+            }
+            journal.close();
+            if (!journal) {
+                throw std::runtime_error("cannot write the index journal " + temporaryPath);
+            }
+        }
+
+        _journal.close();
+        std::remove(journalPath.c_str());
+        if (std::rename(temporaryPath.c_str(), journalPath.c_str()) != 0) {
+            throw std::runtime_error("cannot replace the index journal " + journalPath);
+        }
+        _journal.clear();
+        _journal.open(journalPath, std::ios::app | std::ios::binary);
+        if (!_journal) {
+            throw std::runtime_error("cannot open the index journal " + journalPath);
+        }
+    }
+
+    size_t JournalIndex::rebuild(size_t numThreads)
+    {
+        const std::string journalPath = _storagePath + "/" + journalName();
+        std::vector<std::string> files = listFiles(_storagePath);
+        files.erase(std::remove_if(files.begin(), files.end(), [&](const std::string& file) {
+            return file.compare(0, journalPath.size(), journalPath) == 0;
+        }), files.end());
+
+        // each thread fills the records of the files it reads
+        std::vector<sRecord> records(files.size());
+        std::vector<char> indexed(files.size(), 0);
+        {
+            ThreadPool readers(numThreads, numThreads);
+            for (size_t position = 0; position != files.size(); ++position) {
+                readers.push([&files, &records, &indexed, position, this]() {
+                    try {
+                        records[position] = readRecord(files[position], _storagePath);
+                        indexed[position] = 1;
+                    }
+                    catch (const std::exception&) {
+                        // not a dicom file
+                    }
+                });
+            }
+            readers.stop();
+        }
+
+        size_t valid = 0;
+        for (size_t position = 0; position != records.size(); ++position) {
+            if (indexed[position] != 0) {
+                records[valid++].data.swap(records[position].data);
+            }
+        }
+        records.resize(valid);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        writeJournal(records);
+        clear();
+        _records.reserve(records.size());
+        _bySopInstance.reserve(records.size());
+        for (const sRecord& record : records) {
+            insert(record);
+        }
+        _created = false;
+        return files.size() - valid;
+    }
+
+    void JournalIndex::add(const std::string& fileName)
+    {
+        const sRecord record = readRecord(fileName, _storagePath);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        writeRecord(_journal, record.data);
+        _journal.flush();
+        insert(record);
+    }
+
+    void JournalIndex::clear()
+    {
+        _records.clear();
+        _bySopInstance.clear();
+        _bySeries.clear();
+        _byStudy.clear();
+        _byPatient.clear();
+    }
+
+    void JournalIndex::insert(const sRecord& record)
+    {
+        const std::string sopInstance = record.value(sopInstanceUid);
+        size_t position = _records.size();
+        const sRecord* previous = nullptr;
+        std::unordered_map<std::string, size_t>::const_iterator found = _bySopInstance.find(sopInstance);
+        if (found != _bySopInstance.end()) {
+            position = found->second;
+            previous = &_records[position];
+        }
+
+        // a replaced instance stays in the lists of its previous parents, the
+        // matching discards it there
+        const std::pair<size_t, std::unordered_map<std::string, std::vector<size_t> >*> parents[] = {
+            {seriesInstanceUid, &_bySeries},
+            {studyInstanceUid, &_byStudy},
+            {patientId, &_byPatient}
+        };
+        for (const auto& parent : parents) {
+            const std::string value = record.value(parent.first);
+            if (previous == nullptr || previous->value(parent.first) != value) {
+                (*parent.second)[value].push_back(position);
+            }
+        }
+
+        if (previous != nullptr) {
+            _records[position] = record;
+            return;
+        }
+        _records.push_back(record);
+        _bySopInstance[sopInstance] = position;
+    }
+
+    std::vector<size_t> JournalIndex::select(const query_t& query) const
+    {
+        // start from the most specific uid list, otherwise from all the records
+        std::vector<size_t> candidates;
+        bool selected = false;
+        const std::pair<size_t, const std::unordered_map<std::string, std::vector<size_t> >*> lists[] = {
+            {seriesInstanceUid, &_bySeries},
+            {studyInstanceUid, &_byStudy},
+            {patientId, &_byPatient}
+        };
+        for (const auto& condition : query) {
+            if (condition.first != sopInstanceUid) {
+                continue;
+            }
+            for (const std::string& value : condition.second) {
+                std::unordered_map<std::string, size_t>::const_iterator found = _bySopInstance.find(value);
+                if (found != _bySopInstance.end()) {
+                    candidates.push_back(found->second);
+                }
+            }
+            selected = true;
+        }
+        for (size_t list = 0; list != sizeof(lists) / sizeof(lists[0]) && !selected; ++list) {
+            for (const auto& condition : query) {
+                if (condition.first != lists[list].first ||
+                        std::any_of(condition.second.begin(), condition.second.end(), [](const std::string& value) {
+                            return value.find_first_of("*?") != std::string::npos;
+                        })) {
+                    continue;
+                }
+                for (const std::string& value : condition.second) {
+                    std::unordered_map<std::string, std::vector<size_t> >::const_iterator found = lists[list].second->find(value);
+                    if (found != lists[list].second->end()) {
+                        candidates.insert(candidates.end(), found->second.begin(), found->second.end());
+                    }
+                }
+                selected = true;
+                break;
+            }
+        }
+        if (!selected) {
+            candidates.resize(_records.size());
+            for (size_t position = 0; position != candidates.size(); ++position) {
+                candidates[position] = position;
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        std::vector<size_t> matches;
+        for (size_t position : candidates) {
+            const sRecord& record = _records[position];
+            bool matched = true;
+            for (const auto& condition : query) {
+                matched = std::any_of(condition.second.begin(), condition.second.end(), [&](const std::string& value) {
+                    return valueMatches(keys[condition.first].matching, value, record.value(condition.first));
+                });
+                if (!matched) {
+                    break;
+                }
+            }
+            if (matched) {
+                matches.push_back(position);
+            }
+        }
+        return matches;
+    }
+
+    std::vector<size_t> JournalIndex::match(const imebra::DataSet& identifier, eLevel level) const
+    {
+        query_t query;
+        for (size_t key = 0; key != keysCount; ++key) {
+            if (keys[key].level > level) {
+                continue;
+            }
+            std::vector<std::string> values = getValues(identifier, keys[key].group, keys[key].element);
+            values.erase(std::remove(values.begin(), values.end(), std::string()), values.end());
+            if (!values.empty()) {
+                query.emplace_back(key, values);
+            }
+        }
+        return select(query);
+    }
+
+    std::vector<imebra::DataSet> JournalIndex::find(const imebra::DataSet& identifier)
+    {
+        const eLevel level = getLevel(identifier);
+        std::vector<std::string> modalitiesQuery = getValues(identifier, 0x0008, 0x0061);
+        modalitiesQuery.erase(std::remove(modalitiesQuery.begin(), modalitiesQuery.end(), std::string()), modalitiesQuery.end());
+        const imebra::tagsIds_t requested = identifier.getTags();
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // one group of instances for each entity at the query level
+        std::vector<std::vector<size_t> > groups;
+        std::map<std::string, size_t> groupsIndex;
+        for (size_t position : match(identifier, level)) {
+            const std::string unique = _records[position].value(uniqueKeys[level]);
+            std::map<std::string, size_t>::const_iterator found = groupsIndex.find(unique);
+            if (found == groupsIndex.end()) {
+                groupsIndex[unique] = groups.size();
+                groups.push_back(std::vector<size_t>(1, position));
+            }
+            else {
+                groups[found->second].push_back(position);
+            }
+        }
+
+        std::vector<imebra::DataSet> results;
+        for (const std::vector<size_t>& members : groups) {
+            std::set<std::string> studies;
+            std::set<std::string> series;
+            std::set<std::string> modalities;
+            for (size_t position : members) {
+                studies.insert(_records[position].value(studyInstanceUid));
+                series.insert(_records[position].value(seriesInstanceUid));
+                const std::string recordModality = _records[position].value(modality);
+                if (!recordModality.empty()) {
+                    modalities.insert(recordModality);
+                }
+            }
+            if (level == STUDY && !modalitiesQuery.empty() &&
+                    !std::any_of(modalities.begin(), modalities.end(), [&](const std::string& value) {
+                        return std::any_of(modalitiesQuery.begin(), modalitiesQuery.end(), [&](const std::string& query) {
+                            return valueMatches(WILDCARD, query, value);
+                        });
+                    })) {
+                continue;
+            }
+
+            const sRecord& record = _records[members.front()];
+            imebra::MutableDataSet result(implicitVRLittleEndian, imebra::charsetsList_t(1, "ISO_IR 192"));
+            result.setString(imebra::TagId(imebra::tagId_t::QueryRetrieveLevel_0008_0052), levelNames[level]);
+            for (size_t above = 0; above <= (size_t)level; ++above) {
+                setValue(result, keys[uniqueKeys[above]].group, keys[uniqueKeys[above]].element, record.value(uniqueKeys[above]));
+            }
+
+            for (const imebra::TagId& tag : requested) {
+                const std::uint16_t group = tag.getGroupId();
+                const std::uint16_t element = tag.getTagId();
+                if (group == 0x0008 && (element == 0x0052 || element == 0x0005)) {
+                    continue;
+                }
+                const sKey* key = std::find_if(keys, keys + keysCount, [&](const sKey& scan) {
+                    return scan.group == group && scan.element == element;
+                });
+                std::string value;
+                if (key != keys + keysCount) {
+                    if (key->level <= level) {
+                        value = record.value((size_t)(key - keys));
+                    }
+                }
+                else if (group == 0x0008 && element == 0x0061 && level == STUDY) {
+                    value = joinValues(std::vector<std::string>(modalities.begin(), modalities.end()));
+                }
+                else if (group == 0x0020 && element == 0x1200 && level == PATIENT) {
+                    value = std::to_string(studies.size());
+                }
+                else if (group == 0x0020 && element == 0x1202 && level == PATIENT) {
+                    value = std::to_string(series.size());
+                }
+                else if (group == 0x0020 && element == 0x1204 && level == PATIENT) {
+                    value = std::to_string(members.size());
+                }
+                else if (group == 0x0020 && element == 0x1206 && level == STUDY) {
+                    value = std::to_string(series.size());
+                }
+                else if (group == 0x0020 && element == 0x1208 && level == STUDY) {
+                    value = std::to_string(members.size());
+                }
+                else if (group == 0x0020 && element == 0x1209 && level == SERIES) {
+                    value = std::to_string(members.size());
+                }
+                setValue(result, group, element, value);
+            }
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    std::vector<sIndexedInstance> JournalIndex::retrieve(const imebra::DataSet& identifier)
+    {
+        const eLevel level = getLevel(identifier);
+
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // a retrieve must identify the entities, at least with the unique key of the level
+        const std::vector<std::string> unique = getValues(identifier, keys[uniqueKeys[level]].group, keys[uniqueKeys[level]].element);
+        if (unique.empty() || unique.front().empty()) {
+            throw std::runtime_error(std::string("missing unique key for the level ") + levelNames[level]);
+        }
+
+        std::vector<sIndexedInstance> instances;
+        for (size_t position : match(identifier, level)) {
+            const sRecord& record = _records[position];
+            sIndexedInstance instance;
+            const std::string fileName = record.fileName();
+            instance.path = (!fileName.empty() && fileName[0] == '/') ? fileName : _storagePath + "/" + fileName;
+            instance.sopClassUid = record.value(sopClassUid);
+            instance.sopInstanceUid = record.value(sopInstanceUid);
+            instance.transferSyntax = record.transferSyntax();
+            instances.push_back(instance);
+        }
+        return instances;
+    }
+
+} // namespace ns
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../library/include/imebra/dataSet.h"
+
+namespace ns {
+
+    // Query/retrieve levels, from the top of the hierarchy
+    enum eLevel {
+        PATIENT = 0,
+        STUDY = 1,
+        SERIES = 2,
+        IMAGE = 3
+    };
+
+    // An instance selected for a retrieve
+    struct sIndexedInstance {
+        std::string path;
+        std::string sopClassUid;
+        std::string sopInstanceUid;
+        std::string transferSyntax;
+    };
+
+    // Index of the instances stored by the scp, used to answer the query/retrieve
+    // requests without reading the storage folder.
+    // The scp only uses this interface so the index can be replaced, e.g. by a
+    // database.
+    class InstanceIndex {
+    public:
+        virtual ~InstanceIndex() {}
+
+        // adds the instance stored in fileName, or replaces the previous one with
+        // the same sop instance uid. Only the file header is read
+        virtual void add(const std::string& fileName) = 0;
+
+        // returns one dataset for each entity at the QueryRetrieveLevel of the
+        // identifier that matches its keys, with the requested keys filled in
+        virtual std::vector<imebra::DataSet> find(const imebra::DataSet& identifier) = 0;
+
+        // returns the instances below the entities matching the identifier
+        virtual std::vector<sIndexedInstance> retrieve(const imebra::DataSet& identifier) = 0;
+    };
+
+    // Keeps the attributes of the instances in memory and appends every added
+    // instance to a journal in the storage folder, read back when the scp starts.
+    // The journal is a binary file of checksummed records that are loaded as
+    // they are, without parsing each attribute, so that millions of instances
+    // load in a few seconds
+    class JournalIndex : public InstanceIndex {
+    public:
+        explicit JournalIndex(const std::string& storagePath);
+
+        void add(const std::string& fileName) override;
+
+        std::vector<imebra::DataSet> find(const imebra::DataSet& identifier) override;
+
+        std::vector<sIndexedInstance> retrieve(const imebra::DataSet& identifier) override;
+
+        size_t size() const;
+
+        // true when there was no valid journal in the storage folder, or when
+        // it was damaged before its last record: the index must be rebuilt
+        bool created() const;
+
+        // replaces the content of the index with the headers of all the files in
+        // the storage folder, read by numThreads threads. Returns the number of
+        // files that could not be indexed
+        size_t rebuild(size_t numThreads);
+
+        // name of the journal inside the storage folder
+        static const char* journalName();
+
+    private:
+        // the lengths of the fields followed by their values, as stored in the journal
+        struct sRecord {
+            std::string data;
+
+            std::string field(size_t field) const;
+            std::string fileName() const;          // relative to the storage folder
+            std::string transferSyntax() const;
+            std::string value(size_t key) const;   // one for each indexed key
+        };
+
+        static sRecord readRecord(const std::string& fileName, const std::string& storagePath);
+
+        typedef std::vector<std::pair<size_t, std::vector<std::string> > > query_t;
+
+        // called with the mutex locked
+        void load();
+        void writeJournal(const std::vector<sRecord>& records);
+        void insert(const sRecord& record);
+        void clear();
+        std::vector<size_t> select(const query_t& query) const;
+        std::vector<size_t> match(const imebra::DataSet& identifier, eLevel level) const;
+
+        const std::string _storagePath;
+        mutable std::mutex _mutex;
+        std::ofstream _journal;
+        bool _created;
+        std::vector<sRecord> _records;
+        std::unordered_map<std::string, size_t> _bySopInstance;
+        std::unordered_map<std::string, std::vector<size_t> > _bySeries;
+        std::unordered_map<std::string, std::vector<size_t> > _byStudy;
+        std::unordered_map<std::string, std::vector<size_t> > _byPatient;
+    };
+
+} // namespace ns
@@ -21,6 +21,8 @@ using namespace imebra;
 
 #include "json.h"
 #include "Utils.h"
+#include "SubOperationProgress.h"
+#include "AssociationPool.h"
 
 using json = nlohmann::json;
 
@@ -54,31 +56,16 @@ void MoveAsyncWorker::Execute(const ExecutionProgress& progress)
 
     const std::string abstractSyntax = uidStudyRootQueryRetrieveInformationModelMOVE_1_2_840_10008_5_1_4_1_2_2_2;
 
-    // Allocate a TCP stream that connects to the DICOM SCP
-    imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port));
+    // Presentation contexts proposed to the SCP, the association is reused
+    // between requests when keepAlive is set
+    ns::sContexts contexts;
+    contexts.abstractSyntaxes.push_back(abstractSyntax);
 
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
-
-    // Add all the abstract syntaxes and the supported transfer
-    // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
-    // called "presentation context")
-    imebra::PresentationContext context(abstractSyntax);
-    context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-    context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-    imebra::PresentationContexts presentationContexts;
-    presentationContexts.addPresentationContext(context);
-
-    // The AssociationSCU constructor will negotiate a connection through
-    // the readSCU and writeSCU stream reader and writer
-    imebra::AssociationSCU scu(in.source.aet, in.target.aet, 1, 1, presentationContexts, readSCU, writeSCU, 10);
+    ns::AssociationPool::Lease association(ns::AssociationPool::instance().acquire(in, contexts));
 
     // The DIMSE service will use the negotiated association to send and receive
     // DICOM commands
-    imebra::DimseService dimse(scu);
+    imebra::DimseService& dimse = association.dimse();
 
         // Let's prepare a dataset to store on the SCP
     imebra::MutableDataSet payload; // We will use the negotiated transfer syntax
@@ -96,42 +83,33 @@ void MoveAsyncWorker::Execute(const ExecutionProgress& progress)
         payload);
     dimse.sendCommandOrResponse(command);
 
+    // Sub-operation counters, sent at most every progressInterval milliseconds
+    ns::SubOperationProgress subOperations(progress, in.progressInterval);
+
     try
     {
         for (;;)
         {
-            imebra::DimseResponse response(dimse.getCMoveResponse(command));
-            if (response.getStatus() == imebra::dimseStatus_t::success)
+            imebra::CMoveResponse response(dimse.getCMoveResponse(command));
+            // A final warning (0xB000) means that some sub-operations failed or
+            // completed with warnings: the counters report how many
+            if (response.getStatus() == imebra::dimseStatus_t::success || response.getStatus() == imebra::dimseStatus_t::warning)
             {
-                _jsonOutput = {};
+                subOperations.update(response, 0);
+                subOperations.flush();
+                _jsonOutput = subOperations.counters();
                 break;
             }
             else if (response.getStatus() == imebra::dimseStatus_t::pending)
             {
-                /*
-                imebra::DataSet data  = response.getPayloadDataSet();
-                try
-                {
-                    int remainNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfRemainingSuboperations_0000_1020), 0);
-                    int completeNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfCompletedSuboperations_0000_1021), 0);
-                    int faileNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfFailedSuboperations_0000_1022), 0);
-                    // int warnNum = data.getSignedLong(imebra::TagId(imebra::tagId_t::NumberOfWarningSuboperations_0000_1023), 0);
-                    _output = "remaining: " + std::to_string(remainNum) + " completed: " + std::to_string(completeNum);
-                    if (faileNum > 0 ) {
-                        _output += " failed: " + std::to_string(remainNum);
-                    }
-                }
-                catch (std::exception &error)
-                {
-                    SetErrorJson("parse error: " + std::string(error.what()));
-                }
-                */
+                subOperations.update(response, 0);
             }
             else {
                 SetErrorJson("Move-scu request failed: " + std::to_string(response.getStatusCode()));
                 break;
             }
         }
+        association.done();
     }
     catch (const StreamEOFError & error)
     {
@@ -0,0 +1,319 @@
+#include "QueryRetrieveScp.h"
+
+#include "../library/include/imebra/imebra.h"
+#include "../library/include/imebra/exceptions.h"
+#include "../library/include/imebra/acse.h"
+#include "../library/include/imebra/codecFactory.h"
+#include "../library/include/imebra/tcpAddress.h"
+#include "../library/include/imebra/tcpStream.h"
+#include "../library/include/imebra/streamReader.h"
+#include "../library/include/imebra/streamWriter.h"
+
+#include <algorithm>
+#include <memory>
+#include <map>
+#include <set>
+
+using namespace imebra;
+
+namespace {
+
+    const std::string implicitVRLittleEndian = imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2;
+    const std::string explicitVRLittleEndian = imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1;
+    const std::string explicitVRBigEndian = imebra::uidExplicitVRBigEndian_1_2_840_10008_1_2_2;
+
+    bool isUncompressed(const std::string& transferSyntax) {
+        return transferSyntax == implicitVRLittleEndian ||
+            transferSyntax == explicitVRLittleEndian ||
+            transferSyntax == explicitVRBigEndian;
+    }
+
+    // one presentation context for each sop class and compressed transfer syntax,
+    // plus an uncompressed one for each sop class
+    imebra::PresentationContexts buildPresentationContexts(const std::vector<ns::sIndexedInstance>& instances, size_t& count) {
+        std::map<std::string, std::set<std::string> > syntaxes;
+        for (const ns::sIndexedInstance& instance : instances) {
+            syntaxes[instance.sopClassUid].insert(instance.transferSyntax);
+        }
+        imebra::PresentationContexts presentationContexts;
+        count = 0;
+        for (const auto& sopClass : syntaxes) {
+            for (const std::string& transferSyntax : sopClass.second) {
+                if (isUncompressed(transferSyntax)) {
+                    continue;
+                }
+                imebra::PresentationContext context(sopClass.first);
+                context.addTransferSyntax(transferSyntax);
+                presentationContexts.addPresentationContext(context);
+                ++count;
+            }
+            imebra::PresentationContext context(sopClass.first);
+            context.addTransferSyntax(explicitVRLittleEndian);
+            context.addTransferSyntax(implicitVRLittleEndian);
+            presentationContexts.addPresentationContext(context);
+            ++count;
+        }
+        return presentationContexts;
+    }
+}
+
+namespace ns {
+
+    QueryRetrieveScp::QueryRetrieveScp(InstanceIndex& index, const sInput& in, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress)
+        : _index(index)
+        , _in(in)
+        , _progress(progress)
+    {
+    }
+
+    std::vector<std::string> QueryRetrieveScp::abstractSyntaxes()
+    {
+        return {
+            imebra::uidPatientRootQueryRetrieveInformationModelFIND_1_2_840_10008_5_1_4_1_2_1_1,
+            imebra::uidPatientRootQueryRetrieveInformationModelMOVE_1_2_840_10008_5_1_4_1_2_1_2,
+            imebra::uidPatientRootQueryRetrieveInformationModelGET_1_2_840_10008_5_1_4_1_2_1_3,
+            imebra::uidStudyRootQueryRetrieveInformationModelFIND_1_2_840_10008_5_1_4_1_2_2_1,
+            imebra::uidStudyRootQueryRetrieveInformationModelMOVE_1_2_840_10008_5_1_4_1_2_2_2,
+            imebra::uidStudyRootQueryRetrieveInformationModelGET_1_2_840_10008_5_1_4_1_2_2_3
+        };
+    }
+
+    void QueryRetrieveScp::find(imebra::DimseService& dimse, const imebra::CFindCommand& command)
+    {
+        std::vector<imebra::DataSet> matches;
+        try {
+            matches = _index.find(command.getPayloadDataSet());
+        }
+        catch (const std::exception& e) {
+            report(FAILURE, "c-find failed, reason: " + std::string(e.what()));
+            dimse.sendCommandOrResponse(CFindResponse(command, dimseStatusCode_t::unableToProcess));
+            return;
+        }
+
+        for (const imebra::DataSet& match : matches) {
+            dimse.sendCommandOrResponse(CFindResponse(command, match));
+        }
+        dimse.sendCommandOrResponse(CFindResponse(command, dimseStatusCode_t::success));
+        report(PENDING, "c-find: " + std::to_string(matches.size()) + " matches");
+    }
+
+    void QueryRetrieveScp::get(imebra::DimseService& dimse, const imebra::CGetCommand& command)
+    {
+        std::vector<sIndexedInstance> instances;
+        if (!retrieve(command, instances)) {
+            dimse.sendCommandOrResponse(CGetResponse(command, dimseStatusCode_t::unableToProcess, 0, 0, 0, 0));
+            return;
+        }
+
+        sSubOperations subOperations(instances.size());
+        for (const sIndexedInstance& instance : instances) {
+            subOperations.update(instance, store(dimse, instance, "", 0));
+            if (subOperations.remaining != 0) {
+                dimse.sendCommandOrResponse(CGetResponse(command, dimseStatusCode_t::pending,
+                    subOperations.remaining, subOperations.completed, subOperations.failed, subOperations.warning));
+            }
+        }
+
+        if (subOperations.failedUids.empty()) {
+            dimse.sendCommandOrResponse(CGetResponse(command, subOperations.finalStatus(),
+                0, subOperations.completed, subOperations.failed, subOperations.warning));
+        }
+        else {
+            dimse.sendCommandOrResponse(CGetResponse(command, subOperations.finalStatus(),
+                0, subOperations.completed, subOperations.failed, subOperations.warning, subOperations.failedList()));
+        }
+        report(PENDING, "c-get: " + std::to_string(subOperations.completed) + " sent, " + std::to_string(subOperations.failed) + " failed");
+    }
+
+    void QueryRetrieveScp::move(imebra::DimseService& dimse, const imebra::CMoveCommand& command, const std::string& originatorAet)
+    {
+        const std::string destination = command.getDestinationAET();
+        std::vector<sIdent>::const_iterator peer = std::find_if(_in.peers.begin(), _in.peers.end(), [&](const sIdent& scan) {
+            return scan.aet == destination;
+        });
+        if (peer == _in.peers.end()) {
+            report(FAILURE, "c-move failed, unknown destination: " + destination);
+            dimse.sendCommandOrResponse(CMoveResponse(command, dimseStatusCode_t::moveDestinationUnknown, 0, 0, 0, 0));
+            return;
+        }
+
+        std::vector<sIndexedInstance> instances;
+        if (!retrieve(command, instances)) {
+            dimse.sendCommandOrResponse(CMoveResponse(command, dimseStatusCode_t::unableToProcess, 0, 0, 0, 0));
+            return;
+        }
+        if (instances.empty()) {
+            dimse.sendCommandOrResponse(CMoveResponse(command, dimseStatusCode_t::success, 0, 0, 0, 0));
+            return;
+        }
+
+        size_t contextsCount(0);
+        imebra::PresentationContexts presentationContexts = buildPresentationContexts(instances, contextsCount);
+        if (contextsCount > 128) {
+            report(FAILURE, "c-move failed, too many presentation contexts required (" + std::to_string(contextsCount) + ", max is 128)");
+            dimse.sendCommandOrResponse(CMoveResponse(command, dimseStatusCode_t::outOfResourcesCannotPerformSubOperations, 0, 0, 0, 0));
+            return;
+        }
+
+        // Only the failures of the association to the destination fail the
+        // sub-operations: a StreamError from the requester's dimse propagates
+        sSubOperations subOperations(instances.size());
+        std::unique_ptr<imebra::TCPStream> tcpStream;
+        std::unique_ptr<imebra::StreamReader> readSCU;
+        std::unique_ptr<imebra::StreamWriter> writeSCU;
+        std::unique_ptr<imebra::AssociationSCU> scu;
+        std::unique_ptr<imebra::DimseService> storeDimse;
+        auto failRemaining = [&](const std::exception& e) {
+            report(FAILURE, "c-move association to " + destination + " failed, reason: " + std::string(e.what()));
+            for (size_t position = instances.size() - subOperations.remaining; position != instances.size(); ++position) {
+                subOperations.update(instances[position], imebra::dimseStatus_t::failure);
+            }
+        };
+        try
+        {
+            tcpStream.reset(new imebra::TCPStream(TCPActiveAddress(peer->ip, peer->port), (std::uint32_t)std::max(_in.sendBufferSize, 0), (std::uint32_t)std::max(_in.receiveBufferSize, 0), _in.noDelay));
+            readSCU.reset(new imebra::StreamReader(tcpStream->getStreamInput()));
+            writeSCU.reset(new imebra::StreamWriter(tcpStream->getStreamOutput()));
+            if (_in.streamBufferSize > 0) {
+                readSCU->setBufferSize((size_t)_in.streamBufferSize);
+                writeSCU->setBufferSize((size_t)_in.streamBufferSize);
+            }
+            scu.reset(new imebra::AssociationSCU(_in.source.aet, destination, 1, 1, presentationContexts, *readSCU, *writeSCU, 10, (std::uint32_t)std::max(_in.maxPduLength, 0)));
+            storeDimse.reset(new imebra::DimseService(*scu));
+        }
+        catch (const std::exception& e)
+        {
+            failRemaining(e);
+        }
+
+        if (storeDimse) {
+            for (const sIndexedInstance& instance : instances) {
+                imebra::dimseStatus_t status;
+                try {
+                    status = store(*storeDimse, instance, originatorAet, command.getID());
+                }
+                catch (const std::exception& e) {
+                    failRemaining(e);
+                    break;
+                }
+                subOperations.update(instance, status);
+                if (subOperations.remaining != 0) {
+                    dimse.sendCommandOrResponse(CMoveResponse(command, dimseStatusCode_t::pending,
+                        subOperations.remaining, subOperations.completed, subOperations.failed, subOperations.warning));
+                }
+            }
+
+            try {
+                scu->release();
+            }
+            catch (const std::exception&) {
+                // the sub-operations are already completed
+            }
+        }
+
+        if (subOperations.failedUids.empty()) {
+            dimse.sendCommandOrResponse(CMoveResponse(command, subOperations.finalStatus(),
+                0, subOperations.completed, subOperations.failed, subOperations.warning));
+        }
+        else {
+            dimse.sendCommandOrResponse(CMoveResponse(command, subOperations.finalStatus(),
+                0, subOperations.completed, subOperations.failed, subOperations.warning, subOperations.failedList()));
+        }
+        report(PENDING, "c-move to " + destination + ": " + std::to_string(subOperations.completed) + " sent, " + std::to_string(subOperations.failed) + " failed");
+    }
+
+    imebra::dimseStatus_t QueryRetrieveScp::store(imebra::DimseService& dimse, const sIndexedInstance& instance, const std::string& originatorAet, std::uint16_t originatorId)
+    {
+        try
+        {
+            // the instances are not transcoded
+            const std::string transferSyntax = dimse.getTransferSyntax(instance.sopClassUid);
+            if (transferSyntax != instance.transferSyntax && !(isUncompressed(transferSyntax) && isUncompressed(instance.transferSyntax))) {
+                report(FAILURE, "transfer syntax not accepted: " + instance.sopInstanceUid);
+                return imebra::dimseStatus_t::failure;
+            }
+
+            // the tags larger than a few bytes are read from the file while the
+            // payload is being sent
+            DataSet payload = CodecFactory::load(instance.path, 256);
+            imebra::CStoreCommand command(
+                        instance.sopClassUid,
+                        dimse.getNextCommandID(),
+                        dimseCommandPriority_t::medium,
+                        instance.sopClassUid,
+                        instance.sopInstanceUid,
+                        originatorAet,
+                        originatorId,
+                        payload);
+            dimse.sendCommandOrResponse(command);
+            return imebra::DimseResponse(dimse.getCStoreResponse(command)).getStatus();
+        }
+        catch (const StreamOpenError& e)
+        {
+            // the instance file is gone: only this sub-operation fails
+            report(FAILURE, "c-store sub-operation failed for " + instance.sopInstanceUid + ", reason: " + std::string(e.what()));
+        }
+        catch (const StreamError&)
+        {
+            // the association is lost
+            throw;
+        }
+        catch (const std::exception& e)
+        {
+            report(FAILURE, "c-store sub-operation failed for " + instance.sopInstanceUid + ", reason: " + std::string(e.what()));
+        }
+        return imebra::dimseStatus_t::failure;
+    }
+
+    bool QueryRetrieveScp::retrieve(const imebra::DimseCommand& command, std::vector<sIndexedInstance>& instances)
+    {
+        try {
+            instances = _index.retrieve(command.getPayloadDataSet());
+            return true;
+        }
+        catch (const std::exception& e) {
+            report(FAILURE, "retrieve failed, reason: " + std::string(e.what()));
+        }
+        return false;
+    }
+
+    void QueryRetrieveScp::report(eStatus status, const std::string& message)
+    {
+        std::string msg = createJsonResponse(status, message);
+        _progress.Send(msg.c_str(), msg.length());
+    }
+
+    void QueryRetrieveScp::sSubOperations::update(const sIndexedInstance& instance, imebra::dimseStatus_t status)
+    {
+        --remaining;
+        if (status == imebra::dimseStatus_t::success) {
+            ++completed;
+        }
+        else if (status == imebra::dimseStatus_t::warning) {
+            ++warning;
+        }
+        else {
+            ++failed;
+            failedUids.push_back(instance.sopInstanceUid);
+        }
+    }
+
+    imebra::dimseStatusCode_t QueryRetrieveScp::sSubOperations::finalStatus() const
+    {
+        return (failed != 0 || warning != 0) ? dimseStatusCode_t::subOperationCompletedWithErrors : dimseStatusCode_t::success;
+    }
+
+    imebra::DataSet QueryRetrieveScp::sSubOperations::failedList() const
+    {
+        imebra::MutableDataSet identifier;
+        {
+            // one value per failed instance, committed when the handler is released
+            imebra::WritingDataHandler handler = identifier.getWritingDataHandler(TagId(tagId_t::FailedSOPInstanceUIDList_0008_0058), 0);
+            for (size_t position = 0; position != failedUids.size(); ++position) {
+                handler.setString(position, failedUids[position]);
+            }
+        }
+        return identifier;
+    }
+
+} // namespace ns
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <napi.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../library/include/imebra/dimse.h"
+
+#include "InstanceIndex.h"
+#include "Utils.h"
+
+using namespace Napi;
+
+namespace ns {
+
+    // Answers the c-find, c-get and c-move requests received by the scp from the
+    // instance index, without reading the storage folder.
+    // The retrieved instances are sent with their stored transfer syntax: the
+    // large tags are read from the file while the c-store payload is sent.
+    class QueryRetrieveScp {
+    public:
+        QueryRetrieveScp(InstanceIndex& index, const sInput& in, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress);
+
+        // the query/retrieve sop classes to accept
+        static std::vector<std::string> abstractSyntaxes();
+
+        void find(imebra::DimseService& dimse, const imebra::CFindCommand& command);
+
+        // the instances are sent on the association of the request
+        void get(imebra::DimseService& dimse, const imebra::CGetCommand& command);
+
+        // the instances are sent on a new association to the destination, which
+        // must be listed in the peers
+        void move(imebra::DimseService& dimse, const imebra::CMoveCommand& command, const std::string& originatorAet);
+
+    private:
+        struct sSubOperations {
+            sSubOperations(size_t total) : remaining((std::uint32_t)total), completed(0), failed(0), warning(0) {}
+            std::uint32_t remaining;
+            std::uint32_t completed;
+            std::uint32_t failed;
+            std::uint32_t warning;
+            std::vector<std::string> failedUids;
+
+            void update(const sIndexedInstance& instance, imebra::dimseStatus_t status);
+            imebra::dimseStatusCode_t finalStatus() const;
+            imebra::DataSet failedList() const;
+        };
+
+        // sends one instance, returns the status of the c-store response
+        imebra::dimseStatus_t store(imebra::DimseService& dimse, const sIndexedInstance& instance, const std::string& originatorAet, std::uint16_t originatorId);
+
+        bool retrieve(const imebra::DimseCommand& command, std::vector<sIndexedInstance>& instances);
+
+        void report(eStatus status, const std::string& message);
+
+        InstanceIndex& _index;
+        const sInput& _in;
+        const AsyncProgressQueueWorker<char>::ExecutionProgress& _progress;
+    };
+
+} // namespace ns
@@ -12,19 +12,377 @@
 #include "../library/include/imebra/streamWriter.h"
 
 
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <memory>
 #include <list>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 using namespace imebra;
 
 
 #include "json.h"
 #include "Utils.h"
+#include "ThreadPool.h"
+#include "DiskWriter.h"
+#include "InstanceIndex.h"
+#include "QueryRetrieveScp.h"
 
 using json = nlohmann::json;
 
+namespace {
+
+    // Counts the c-store responses that the writer threads have still to send
+    // on an association: the association waits for them before closing
+    class PendingResponses {
+    public:
+        PendingResponses() : _count(0) {
+        }
+
+        ~PendingResponses() {
+            wait();
+        }
+
+        void add() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_count;
+        }
+
+        void done() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (--_count == 0) {
+                _idle.notify_all();
+            }
+        }
+
+        void wait() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle.wait(lock, [this] { return _count == 0; });
+        }
+
+    private:
+        size_t _count;
+        std::mutex _mutex;
+        std::condition_variable _idle;
+    };
+
+    // Stores a received instance and sends the c-store response.
+    // The response is sent once the instance has been written, by the writer
+    // thread when the writer is asynchronous, so a successful status always
+    // means that the instance is on disk. With ackOnQueue the asynchronous
+    // writer answers as soon as the instance is queued instead
+    void StoreProc(imebra::DimseService& dimse, const imebra::CStoreCommand& command, const ns::sInput& in, ns::DiskWriter& diskWriter, ns::InstanceIndex* index, PendingResponses& pending, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress)
+    {
+        // The store command has a payload. We can do something with it, or we can
+        // use the methods in CStoreCommand to get other data sent by the peer
+        imebra::DataSet payload = command.getPayloadDataSet();
+
+        // Do something with the payload
+        std::string sop = payload.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0);
+
+        std::string msg = ns::createJsonResponse(ns::PENDING, "storing: " + sop);
+        progress.Send(msg.c_str(), msg.length());
+
+        if (!in.passThrough) {
+            // The writer threads read the payload while the association receives
+            // the next one: once frozen they read it without locking
+            payload.freeze();
+            if (in.ackOnQueue && diskWriter.isAsync()) {
+                // A write that fails later is only reported through the
+                // progress messages, the peer already has its response
+                const bool queued = diskWriter.store(payload, sop);
+                dimse.sendCommandOrResponse(CStoreResponse(command, queued ? dimseStatusCode_t::success : dimseStatusCode_t::outOfResources));
+                return;
+            }
+            pending.add();
+            diskWriter.store(payload, sop, [&dimse, command, sop, &pending, &progress](bool stored) {
+                try {
+                    dimse.sendCommandOrResponse(CStoreResponse(command, stored ? dimseStatusCode_t::success : dimseStatusCode_t::outOfResources));
+                }
+                catch (const std::exception& e) {
+                    std::string msg = ns::createJsonResponse(ns::FAILURE, "failed to send the response for " + sop + ": " + std::string(e.what()));
+                    progress.Send(msg.c_str(), msg.length());
+                }
+                pending.done();
+            });
+            return;
+        }
+
+        // The association has already written the file
+        if (index != nullptr) {
+            try {
+                index->add(in.storagePath + "/" + sop + ".dcm");
+            }
+            catch (const std::exception& e) {
+                std::string msg = ns::createJsonResponse(ns::FAILURE, "failed to index " + sop + ": " + std::string(e.what()));
+                progress.Send(msg.c_str(), msg.length());
+            }
+        }
+
+        // Send a response
+        dimse.sendCommandOrResponse(CStoreResponse(command, dimseStatusCode_t::success));
+    }
+
+    // Answers a command that the scp doesn't handle with the unrecognized operation status
+    void RejectCommand(imebra::DimseService& dimse, const imebra::DimseCommand& command)
+    {
+        const dimseStatusCode_t status = dimseStatusCode_t::unrecognizedOperation;
+        switch (command.getCommandType())
+        {
+        case dimseCommandType_t::cStore:
+            dimse.sendCommandOrResponse(CStoreResponse(command.getAsCStoreCommand(), status));
+            break;
+        case dimseCommandType_t::cFind:
+            dimse.sendCommandOrResponse(CFindResponse(command.getAsCFindCommand(), status));
+            break;
+        case dimseCommandType_t::cGet:
+            dimse.sendCommandOrResponse(CGetResponse(command.getAsCGetCommand(), status, 0, 0, 0, 0));
+            break;
+        case dimseCommandType_t::cMove:
+            dimse.sendCommandOrResponse(CMoveResponse(command.getAsCMoveCommand(), status, 0, 0, 0, 0));
+            break;
+        case dimseCommandType_t::cEcho:
+            dimse.sendCommandOrResponse(CEchoResponse(command.getAsCEchoCommand(), status));
+            break;
+        case dimseCommandType_t::nEventReport:
+            dimse.sendCommandOrResponse(NEventReportResponse(command.getAsNEventReportCommand(), status));
+            break;
+        case dimseCommandType_t::nGet:
+            dimse.sendCommandOrResponse(NGetResponse(command.getAsNGetCommand(), status));
+            break;
+        case dimseCommandType_t::nSet:
+            dimse.sendCommandOrResponse(NSetResponse(command.getAsNSetCommand(), status));
+            break;
+        case dimseCommandType_t::nAction:
+            dimse.sendCommandOrResponse(NActionResponse(command.getAsNActionCommand(), status));
+            break;
+        case dimseCommandType_t::nCreate:
+            dimse.sendCommandOrResponse(NCreateResponse(command.getAsNCreateCommand(), status));
+            break;
+        case dimseCommandType_t::nDelete:
+        {
+            NDeleteCommand deleteCommand(command.getAsNDeleteCommand());
+            dimse.sendCommandOrResponse(NDeleteResponse(deleteCommand, status));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // Handles one command received by the scp and sends its responses
+    void CommandProc(imebra::DimseService& dimse, const imebra::DimseCommand& command, const std::string& otherAet, const ns::sInput& in, ns::DiskWriter& diskWriter, ns::InstanceIndex* index, ns::QueryRetrieveScp* queryRetrieve, PendingResponses& pending, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress)
+    {
+        switch (command.getCommandType())
+        {
+        case dimseCommandType_t::cStore:
+            StoreProc(dimse, command.getAsCStoreCommand(), in, diskWriter, index, pending, progress);
+            return;
+        case dimseCommandType_t::cFind:
+            if (queryRetrieve != nullptr) {
+                queryRetrieve->find(dimse, command.getAsCFindCommand());
+                return;
+            }
+            break;
+        case dimseCommandType_t::cGet:
+            if (queryRetrieve != nullptr) {
+                queryRetrieve->get(dimse, command.getAsCGetCommand());
+                return;
+            }
+            break;
+        case dimseCommandType_t::cMove:
+            if (queryRetrieve != nullptr) {
+                queryRetrieve->move(dimse, command.getAsCMoveCommand(), otherAet);
+                return;
+            }
+            break;
+        default:
+            break;
+        }
+
+        // c-cancel has no response and is not supported: the pending operations
+        // run to completion
+        if (command.getCommandType() == dimseCommandType_t::cCancel) {
+            std::string msg = ns::createJsonResponse(ns::PENDING, "ignoring c-cancel");
+            progress.Send(msg.c_str(), msg.length());
+            return;
+        }
+
+        // The other commands are refused, so the peer doesn't wait for a response
+        RejectCommand(dimse, command);
+        std::string msg = ns::createJsonResponse(ns::FAILURE, "unsupported command " + std::to_string((int)command.getCommandType()));
+        progress.Send(msg.c_str(), msg.length());
+    }
+
+    // Limits the number of open associations: acquire() blocks while
+    // maxAssociations are open, so further peers wait in the listen backlog
+    class AssociationSlots {
+    public:
+        explicit AssociationSlots(size_t maxAssociations) : _maxAssociations(maxAssociations), _open(0) {
+        }
+
+        void acquire() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this] { return _open < _maxAssociations; });
+            ++_open;
+        }
+
+        void release() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            --_open;
+            _changed.notify_all();
+        }
+
+        // blocks until all the associations have been closed
+        void wait() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _changed.wait(lock, [this] { return _open == 0; });
+        }
+
+    private:
+        const size_t _maxAssociations;
+        size_t _open;
+        std::mutex _mutex;
+        std::condition_variable _changed;
+    };
+
+    // State shared by all the associations of the scp
+    struct ScpContext {
+        const ns::sInput& in;
+        const imebra::PresentationContexts& presentationContexts;
+        ns::DiskWriter& diskWriter;
+        ns::InstanceIndex* index;
+        ns::QueryRetrieveScp* queryRetrieve;
+        ns::ThreadPool& commands;
+        AssociationSlots& slots;
+        const AsyncProgressQueueWorker<char>::ExecutionProgress& progress;
+    };
+
+    // An association whose commands are handled by the pool shared by the
+    // whole scp: the association notifies each received command, so no thread
+    // waits for the commands of an idle association. The outstanding commands
+    // are handled concurrently and each response is sent as soon as it is
+    // ready, not necessarily in the order of the commands.
+    // The object keeps itself alive until the association is terminated
+    class ScpAssociation: public imebra::AssociationListener, public std::enable_shared_from_this<ScpAssociation> {
+    public:
+        // Negotiates the association on a pool thread, then lets it notify
+        // its commands
+        static void start(imebra::TCPStream tcpStream, const ScpContext& context) {
+            std::shared_ptr<ScpAssociation> association;
+            try {
+                association = std::make_shared<ScpAssociation>(tcpStream, context);
+            }
+            catch (const std::exception& e) {
+                // A failed association must not bring down the listener
+                std::string msg = ns::createJsonResponse(ns::FAILURE, "assoc failed, reason: " + std::string(e.what()));
+                context.progress.Send(msg.c_str(), msg.length());
+                context.slots.release();
+                return;
+            }
+            association->_self = association;
+            association->_scp->setListener(*association);
+        }
+
+        ScpAssociation(imebra::TCPStream tcpStream, const ScpContext& context)
+            : _context(context)
+            , _tcpStream(tcpStream)
+        {
+            const ns::sInput& in = _context.in;
+            if (in.noDelay) {
+                _tcpStream.setNoDelay(true);
+            }
+
+            // Allocate a stream reader and a writer that use the TCP stream.
+            // If you need a more complex stream (e.g. a stream that uses your
+            // own services to send and receive data) then use a Pipe
+            _reader.reset(new imebra::StreamReader(_tcpStream.getStreamInput()));
+            _writer.reset(new imebra::StreamWriter(_tcpStream.getStreamOutput()));
+            if (in.streamBufferSize > 0) {
+                // Fewer, larger socket reads and writes for bulk transfers
+                _reader->setBufferSize((size_t)in.streamBufferSize);
+                _writer->setBufferSize((size_t)in.streamBufferSize);
+            }
+
+            // The AssociationSCP constructor will negotiate the assocation.
+            // In pass-through mode the payloads are written into the storage path
+            // by the association itself, without being decoded
+            // The peer may invoke up to maxOperations c-store requests without
+            // waiting for the responses
+            _scp.reset(new imebra::AssociationSCP(in.source.aet, 1, (std::uint32_t)in.maxOperations, _context.presentationContexts, *_reader, *_writer, 0, 10, in.passThrough ? in.storagePath : std::string(), (std::uint32_t)std::max(in.maxPduLength, 0)));
+
+            // The DIMSE service will use the negotiated association to send and receive
+            // DICOM commands
+            _dimse.reset(new imebra::DimseService(*_scp));
+            _otherAet = _scp->getOtherAET();
+        }
+
+        ~ScpAssociation() {
+            // The responses still queued for the writer threads are sent
+            // before the association is destroyed
+            _pending.wait();
+            _dimse.reset();
+            _scp.reset();
+            _writer.reset();
+            _reader.reset();
+            _context.slots.release();
+        }
+
+        // Called by the thread receiving the association's messages: the
+        // command is handled by the shared pool
+        void commandReady() override {
+            std::shared_ptr<ScpAssociation> association(shared_from_this());
+            _context.commands.push([association]() { association->handleCommand(); });
+        }
+
+        void terminated() override {
+            std::string msg = ns::createJsonResponse(ns::PENDING, "assoc closed");
+            _context.progress.Send(msg.c_str(), msg.length());
+
+            // Destroyed by the pool: the thread that receives the messages
+            // can't wait for itself
+            _context.commands.push([this]() { std::shared_ptr<ScpAssociation> association(std::move(_self)); });
+        }
+
+    private:
+        void handleCommand() {
+            std::unique_ptr<imebra::DimseCommand> command;
+            try {
+                command.reset(new imebra::DimseCommand(_dimse->getCommand()));
+            }
+            catch (const StreamEOFError&) {
+                // The association has been terminated before the command
+                // could be handled
+                return;
+            }
+            try {
+                CommandProc(*_dimse, *command, _otherAet, _context.in, _context.diskWriter, _context.index, _context.queryRetrieve, _pending, _context.progress);
+            }
+            catch (const std::exception& e) {
+                std::string msg = ns::createJsonResponse(ns::FAILURE, "command failed, reason: " + std::string(e.what()));
+                _context.progress.Send(msg.c_str(), msg.length());
+            }
+        }
+
+        const ScpContext& _context;
+        imebra::TCPStream _tcpStream;
+        std::unique_ptr<imebra::StreamReader> _reader;
+        std::unique_ptr<imebra::StreamWriter> _writer;
+        std::unique_ptr<imebra::AssociationSCP> _scp;
+        std::unique_ptr<imebra::DimseService> _dimse;
+        std::string _otherAet;
+
+        // Counts the c-store responses still to be sent by the writer threads
+        PendingResponses _pending;
+
+        std::shared_ptr<ScpAssociation> _self;
+    };
+}
+
 ServerAsyncWorker::ServerAsyncWorker(std::string data, Function &callback) : BaseAsyncWorker(data, callback)
 {
 }
@@ -43,19 +401,64 @@ void ServerAsyncWorker::Execute(const ExecutionProgress& progress)
         SendInfo("storage path not set, defaulting to " + in.storagePath, progress);
     }
 
-    std::string msg(std::string("starting c-store scp: ") + in.source.ip + " : " + in.source.port);
-    SendInfo(msg, progress);
+    if (in.maxAssociations < 1) {
+        in.maxAssociations = 1;
+    }
+
+    if (in.maxOperations < 1) {
+        in.maxOperations = 1;
+    }
+
+    if (in.writerThreads < 0) {
+        in.writerThreads = 0;
+    }
+
+    if (in.writerQueueSize < 0) {
+        in.writerQueueSize = 0;
+    }
+
+    // The reactor replaces the thread that each association dedicates to
+    // receiving its pdus. The setting is process wide and applies to the scu
+    // requests too, so it is set once, by the first startScp that enables it
+    if (in.reactorThreads > 0) {
+        static std::once_flag reactorSet;
+        const std::uint32_t reactorThreads = (std::uint32_t)in.reactorThreads;
+        std::call_once(reactorSet, [reactorThreads]() { imebra::AssociationBase::setReactorThreads(reactorThreads); });
+    }
 
-    imebra::TCPListener tcpListener(TCPPassiveAddress(in.source.ip, in.source.port));
+    // The instance index is loaded from its journal before accepting
+    // connections
+    std::unique_ptr<ns::JournalIndex> index;
+    if (in.queryRetrieve) {
+        try {
+            index.reset(new ns::JournalIndex(in.storagePath));
+        }
+        catch (const std::exception& e) {
+            SetErrorJson("failed to load the instance index: " + std::string(e.what()));
+            return;
+        }
+        SendInfo("instance index loaded, instances: " + std::to_string(index->size()), progress);
 
-    // Wait until a connection arrives or terminate() is called on the tcpListener
-    imebra::TCPStream tcpStream(tcpListener.waitForConnection());
+        // Without a journal the index is rebuilt from the headers of the
+        // files already in the storage path
+        if (in.rebuildIndex || index->created()) {
+            const size_t threads = in.indexThreads > 0 ? (size_t)in.indexThreads : (size_t)std::max(std::thread::hardware_concurrency(), 1u);
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            size_t skipped = 0;
+            try {
+                skipped = index->rebuild(threads);
+            }
+            catch (const std::exception& e) {
+                SetErrorJson("failed to rebuild the instance index: " + std::string(e.what()));
+                return;
+            }
+            const long long elapsedMs = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+            SendInfo("instance index rebuilt in " + std::to_string(elapsedMs) + " ms, instances: " + std::to_string(index->size()) + ", files skipped: " + std::to_string(skipped), progress);
+        }
+    }
 
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
+    std::string msg(std::string("starting c-store scp: ") + in.source.ip + " : " + in.source.port);
+    SendInfo(msg, progress);
 
     // Add all the abstract syntaxes and the supported transfer
     // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
@@ -69,41 +472,63 @@ void ServerAsyncWorker::Execute(const ExecutionProgress& progress)
         context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
         presentationContexts.addPresentationContext(context);
     }
+    if (index) {
+        for (const std::string& abstractSyntax : ns::QueryRetrieveScp::abstractSyntaxes())
+        {
+            imebra::PresentationContext context(abstractSyntax);
+            context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
+            context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
+            presentationContexts.addPresentationContext(context);
+        }
+    }
+
+    // The accepted connections inherit the socket buffer sizes
+    imebra::TCPListener tcpListener(TCPPassiveAddress(in.source.ip, in.source.port), (std::uint32_t)std::max(in.sendBufferSize, 0), (std::uint32_t)std::max(in.receiveBufferSize, 0));
 
-    // The AssociationSCP constructor will negotiate the assocation
-    imebra::AssociationSCP scp(in.source.aet, 1, 1, presentationContexts, readSCU, writeSCU, 0, 10);
+    // Received instances are either written before the response is sent or,
+    // with writerThreads > 0, queued for the writer threads
+    // and added to the instance index once written
+    ns::DiskWriter::written_t onWritten;
+    if (index) {
+        ns::JournalIndex* journalIndex = index.get();
+        onWritten = [journalIndex](const std::string& fileName) { journalIndex->add(fileName); };
+    }
+    ns::DiskWriter diskWriter(in.storagePath, in.writerThreads, in.writerQueueSize, progress, onWritten);
+    std::unique_ptr<ns::QueryRetrieveScp> queryRetrieve;
+    if (index) {
+        queryRetrieve.reset(new ns::QueryRetrieveScp(*index, in, progress));
+    }
 
-    // The DIMSE service will use the negotiated association to send and receive
-    // DICOM commands
-    imebra::DimseService dimse(scp);
+    // The commands of all the associations are handled by maxAssociations
+    // threads. The queue holds the outstanding commands that the peers may
+    // send within their window, plus the negotiation and the termination of
+    // each association, so the threads receiving the messages don't wait
+    const size_t maxAssociations = (size_t)in.maxAssociations;
+    ns::ThreadPool commands(maxAssociations, maxAssociations * ((size_t)in.maxOperations + 2));
+    AssociationSlots slots(maxAssociations);
+    const ScpContext context = { in, presentationContexts, diskWriter, index.get(), queryRetrieve.get(), commands, slots, progress };
 
     try
     {
-        // Receive commands until the association is closed
+        // Accept connections until terminate() is called on the tcpListener
         for(;;)
         {
-            // receive a C-Store
-            imebra::CStoreCommand command(dimse.getCommand().getAsCStoreCommand());
-
-            // The store command has a payload. We can do something with it, or we can
-            // use the methods in CStoreCommand to get other data sent by the peer
-            imebra::DataSet payload = command.getPayloadDataSet();
-
-            // Do something with the payload
-            std::string sop = payload.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0);
-            imebra::CodecFactory::save(payload, in.storagePath + std::string("/") + sop + std::string(".dcm"), imebra::codecType_t::dicom);
-
-            SendInfo(std::string("storing: ") + sop, progress);
-
-            // Send a response
-            dimse.sendCommandOrResponse(CStoreResponse(command, dimseStatusCode_t::success));
+            imebra::TCPStream tcpStream(tcpListener.waitForConnection());
+            slots.acquire();
+            commands.push([tcpStream, &context]() {
+                ScpAssociation::start(tcpStream, context);
+            });
         }
     }
-    catch(const StreamEOFError& e)
+    catch(const StreamClosedError& e)
     {
-        // The association has been closed, do not abort
-        SendInfo("assoc closed, reason: " + std::string(e.what()), progress, ns::FAILURE);
+        SendInfo("listener closed, reason: " + std::string(e.what()), progress, ns::FAILURE);
     }
 
+    // The open associations are served until their peers close them
+    slots.wait();
+    commands.stop();
+    diskWriter.flush();
+
     SendInfo("shutting down scp...", progress);
 }
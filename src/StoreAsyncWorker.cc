@@ -11,20 +11,353 @@
 #include "../library/include/imebra/streamReader.h"
 #include "../library/include/imebra/streamWriter.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <iostream>
 #include <sstream>
 #include <memory>
 #include <list>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
 
 using namespace imebra;
 
 
 #include "json.h"
 #include "Utils.h"
+#include "ThreadPool.h"
 
 using json = nlohmann::json;
 
+namespace {
 
+    const std::string implicitVRLittleEndian = imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2;
+    const std::string explicitVRLittleEndian = imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1;
+    const std::string explicitVRBigEndian = imebra::uidExplicitVRBigEndian_1_2_840_10008_1_2_2;
+
+    struct sFileInfo {
+        std::string path;
+        std::string sopClassUid;
+        std::string sopInstanceUid;
+        std::string transferSyntax;
+    };
+
+    bool isUncompressed(const std::string& transferSyntax) {
+        return transferSyntax == implicitVRLittleEndian ||
+            transferSyntax == explicitVRLittleEndian ||
+            transferSyntax == explicitVRBigEndian;
+    }
+
+    // parses the file only up to the sop instance uid
+    bool scanFile(const std::string& path, sFileInfo& info) {
+        try {
+            DataSet ds = CodecFactory::load(path, TagId(tagId_t::SOPInstanceUID_0008_0018));
+            info.path = path;
+            info.sopClassUid = ds.getString(TagId(tagId_t::SOPClassUID_0008_0016), 0);
+            info.sopInstanceUid = ds.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0);
+            info.transferSyntax = ds.getString(TagId(tagId_t::TransferSyntaxUID_0002_0010), 0, implicitVRLittleEndian);
+            return true;
+        }
+        catch (const std::exception&) {
+        }
+        return false;
+    }
+
+    // one presentation context for each sop class and transfer syntax found in the files,
+    // plus an uncompressed one for each sop class
+    imebra::PresentationContexts buildPresentationContexts(const std::vector<sFileInfo>& files, size_t& count) {
+        std::map<std::string, std::set<std::string> > syntaxes;
+        for (const sFileInfo& info : files) {
+            syntaxes[info.sopClassUid].insert(info.transferSyntax);
+        }
+        imebra::PresentationContexts presentationContexts;
+        count = 0;
+        for (const auto& sopClass : syntaxes) {
+            for (const std::string& transferSyntax : sopClass.second) {
+                if (isUncompressed(transferSyntax)) {
+                    continue;
+                }
+                imebra::PresentationContext context(sopClass.first);
+                context.addTransferSyntax(transferSyntax);
+                presentationContexts.addPresentationContext(context);
+                ++count;
+            }
+            imebra::PresentationContext context(sopClass.first);
+            context.addTransferSyntax(explicitVRLittleEndian);
+            context.addTransferSyntax(implicitVRLittleEndian);
+            presentationContexts.addPresentationContext(context);
+            ++count;
+        }
+        return presentationContexts;
+    }
+
+    bool isAccepted(imebra::AssociationSCU& scu, const sFileInfo& info) {
+        try {
+            std::vector<std::string> accepted = scu.getTransferSyntaxes(info.sopClassUid);
+            for (const std::string& transferSyntax : accepted) {
+                if (transferSyntax == info.transferSyntax || (isUncompressed(info.transferSyntax) && isUncompressed(transferSyntax))) {
+                    return true;
+                }
+            }
+        }
+        catch (const std::exception&) {
+        }
+        return false;
+    }
+
+    struct sInFlight {
+        sInFlight(const imebra::CStoreCommand& c, const std::string& p) : command(c), path(p) {}
+        imebra::CStoreCommand command;
+        std::string path;
+    };
+
+    // Limits the number of associations opened towards the same target by
+    // all the running storeScu requests
+    class TargetLimiter {
+    public:
+        static TargetLimiter& instance() {
+            static TargetLimiter limiter;
+            return limiter;
+        }
+
+        void acquire(const std::string& target, size_t limit) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _released.wait(lock, [&] { return _open[target] < limit; });
+            ++_open[target];
+        }
+
+        void release(const std::string& target) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (--_open[target] == 0) {
+                    _open.erase(target);
+                }
+            }
+            _released.notify_all();
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _released;
+        std::map<std::string, size_t> _open;
+    };
+
+    class TargetSlot {
+    public:
+        TargetSlot(const std::string& target, size_t limit) : _target(target) {
+            TargetLimiter::instance().acquire(_target, limit);
+        }
+        ~TargetSlot() {
+            TargetLimiter::instance().release(_target);
+        }
+    private:
+        const std::string _target;
+    };
+
+    // State shared by the associations serving one storeScu request.
+    // The associations pull the files from a common list, so a slow or
+    // broken association does not hold back the others
+    class StoreJob {
+    public:
+        StoreJob(const std::vector<sFileInfo>& files, json& failed, const AsyncProgressQueueWorker<char>::ExecutionProgress& progress)
+            : _files(files)
+            , _failed(failed)
+            , _progress(progress)
+            , _next(0)
+            , _completed(0)
+            , _connected(0)
+        {
+        }
+
+        // returns nullptr once all the files have been taken
+        const sFileInfo* nextFile() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _next < _files.size() ? &_files[_next++] : nullptr;
+        }
+
+        bool hasFiles() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _next < _files.size();
+        }
+
+        void connected() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_connected;
+        }
+
+        void stored(const std::string& path) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            ++_completed;
+            report("stored: " + path, ns::PENDING);
+        }
+
+        void failed(const std::string& path, const std::string& reason) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _failed.push_back(path);
+            report(reason + ": " + path, ns::FAILURE);
+        }
+
+        void error(const std::string& message) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _error = message;
+            report(message, ns::FAILURE);
+        }
+
+        // marks the files no association could send as failed
+        void abandon() {
+            const sFileInfo* info;
+            while ((info = nextFile()) != nullptr) {
+                failed(info->path, "not sent");
+            }
+        }
+
+        size_t completed() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _completed;
+        }
+
+        size_t connectedCount() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _connected;
+        }
+
+        std::string lastError() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _error;
+        }
+
+    private:
+        // called with the mutex locked
+        void report(const std::string& message, ns::eStatus status) {
+            json counters = {
+                {"completed", _completed},
+                {"failed", _failed.size()},
+                {"total", _files.size()}
+            };
+            std::string msg = ns::createJsonResponse(status, message, counters);
+            _progress.Send(msg.c_str(), msg.length());
+        }
+
+        const std::vector<sFileInfo>& _files;
+        json& _failed;
+        const AsyncProgressQueueWorker<char>::ExecutionProgress& _progress;
+        mutable std::mutex _mutex;
+        size_t _next;
+        size_t _completed;
+        size_t _connected;
+        std::string _error;
+    };
+
+    // Runs one association, sending files taken from the job until there are none left
+    void StoreProc(StoreJob& job, const ns::sInput& in, const imebra::PresentationContexts& presentationContexts)
+    {
+        TargetSlot slot(in.target.aet + "@" + in.target.ip + ":" + in.target.port, (size_t)std::max(in.maxAssociations, 1));
+
+        // the other associations may have sent everything while waiting for the slot
+        if (!job.hasFiles()) {
+            return;
+        }
+
+        std::deque<sInFlight> inFlight;
+        const sFileInfo* info(nullptr);
+        try
+        {
+            // Allocate a TCP stream that connects to the DICOM SCP. On links with
+            // a large bandwidth-delay product the socket buffers must be sized
+            // before connecting
+            imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port), (std::uint32_t)std::max(in.sendBufferSize, 0), (std::uint32_t)std::max(in.receiveBufferSize, 0), in.noDelay);
+
+            // Allocate a stream reader and a writer that use the TCP stream.
+            // If you need a more complex stream (e.g. a stream that uses your
+            // own services to send and receive data) then use a Pipe
+            imebra::StreamReader readSCU(tcpStream.getStreamInput());
+            imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
+            if (in.streamBufferSize > 0) {
+                // Fewer, larger socket reads and writes for bulk transfers
+                readSCU.setBufferSize((size_t)in.streamBufferSize);
+                writeSCU.setBufferSize((size_t)in.streamBufferSize);
+            }
+
+            // The AssociationSCU constructor will negotiate a connection through
+            // the readSCU and writeSCU stream reader and writer
+            imebra::AssociationSCU scu(in.source.aet, in.target.aet, (std::uint32_t)in.maxOperations, 1, presentationContexts, readSCU, writeSCU, 10, (std::uint32_t)std::max(in.maxPduLength, 0));
+            job.connected();
+
+            // The DIMSE service will use the negotiated association to send and receive
+            // DICOM commands
+            imebra::DimseService dimse(scu);
+
+            // Keep up to the negotiated number of c-store requests outstanding
+            size_t window = (size_t)in.maxOperations;
+            const std::uint32_t negotiated = scu.getMaxOperationsInvoked();
+            if (negotiated != 0 && negotiated < window) {
+                window = negotiated;
+            }
+
+            auto waitOldest = [&]() {
+                sInFlight& oldest = inFlight.front();
+                imebra::DimseResponse response(dimse.getCStoreResponse(oldest.command));
+                if (response.getStatus() == imebra::dimseStatus_t::success || response.getStatus() == imebra::dimseStatus_t::warning) {
+                    job.stored(oldest.path);
+                }
+                else {
+                    job.failed(oldest.path, "store failed (" + std::to_string(response.getStatusCode()) + ")");
+                }
+                inFlight.pop_front();
+            };
+
+            while ((info = job.nextFile()) != nullptr) {
+                if (!isAccepted(scu, *info)) {
+                    job.failed(info->path, "presentation context not accepted");
+                    continue;
+                }
+
+                while (inFlight.size() >= window) {
+                    waitOldest();
+                }
+
+                DataSet payload = CodecFactory::load(info->path);
+                imebra::CStoreCommand command(
+                            info->sopClassUid,
+                            dimse.getNextCommandID(),
+                            dimseCommandPriority_t::medium,
+                            info->sopClassUid,
+                            info->sopInstanceUid,
+                            "",
+                            0,
+                            payload);
+                dimse.sendCommandOrResponse(command);
+                inFlight.emplace_back(command, info->path);
+                info = nullptr;
+            }
+
+            while (!inFlight.empty()) {
+                waitOldest();
+            }
+
+            scu.release();
+        }
+        catch (const StreamEOFError & error)
+        {
+            // The association has been closed
+            job.error("stream error: " + std::string(error.what()));
+        }
+        catch (const std::exception & error)
+        {
+            job.error("Store-scu request failed: " + std::string(error.what()));
+        }
+
+        // the files being sent when the association failed are lost
+        if (info != nullptr) {
+            job.failed(info->path, "association failed");
+        }
+        for (const sInFlight& sent : inFlight) {
+            job.failed(sent.path, "association failed");
+        }
+    }
+}
 
 StoreAsyncWorker::StoreAsyncWorker(std::string data, Function &callback) : BaseAsyncWorker(data, callback)
 {
@@ -43,74 +376,75 @@ void StoreAsyncWorker::Execute(const ExecutionProgress& progress)
         SetErrorJson("Target not set");
         return;
     }
-    // TODO: read sop class from file(s)
-    const std::string abstractSyntax = "1.2.840.10008.5.1.4.1.1.4";
-
-    // Allocate a TCP stream that connects to the DICOM SCP
-    imebra::TCPStream tcpStream(TCPActiveAddress(in.target.ip, in.target.port));
-
-    // Allocate a stream reader and a writer that use the TCP stream.
-    // If you need a more complex stream (e.g. a stream that uses your
-    // own services to send and receive data) then use a Pipe
-    imebra::StreamReader readSCU(tcpStream.getStreamInput());
-    imebra::StreamWriter writeSCU(tcpStream.getStreamOutput());
-
-    // Add all the abstract syntaxes and the supported transfer
-    // syntaxes for each abstract syntax (the pair abstract/transfer syntax is
-    // called "presentation context")
-    imebra::PresentationContext context(abstractSyntax); // MR Image Storage
-    context.addTransferSyntax(imebra::uidImplicitVRLittleEndian_1_2_840_10008_1_2);
-    context.addTransferSyntax(imebra::uidExplicitVRLittleEndian_1_2_840_10008_1_2_1);
-    imebra::PresentationContexts presentationContexts;
-    presentationContexts.addPresentationContext(context);
-
-    // The AssociationSCU constructor will negotiate a connection through
-    // the readSCU and writeSCU stream reader and writer
-    imebra::AssociationSCU scu(in.source.aet, in.target.aet, 1, 1, presentationContexts, readSCU, writeSCU, 10);
-
-    // The DIMSE service will use the negotiated association to send and receive
-    // DICOM commands
-    imebra::DimseService dimse(scu);
-
-    // Let's prepare a dataset to store on the SCP
-    // TODO: load file(s)
-    DataSet payload = CodecFactory::load("myfilename");
-
-
-    imebra::CStoreCommand command(
-                abstractSyntax,
-                dimse.getNextCommandID(),
-                dimseCommandPriority_t::medium,
-                payload.getString(TagId(tagId_t::SOPClassUID_0008_0016), 0),
-                payload.getString(TagId(tagId_t::SOPInstanceUID_0008_0018), 0),
-                "",
-                0,
-                payload);
-    dimse.sendCommandOrResponse(command);
-    try
-    {
-        for (;;)
-        {
-            imebra::DimseResponse response(dimse.getCStoreResponse(command));
-            if (response.getStatus() == imebra::dimseStatus_t::success)
-            {
-                _jsonOutput = {};
-                break;
-            }
-            else if (response.getStatus() == imebra::dimseStatus_t::pending)
-            {
-                // just continue for now
-            }
-            else {
-                SetErrorJson("Store-scu request failed: " + std::to_string(response.getStatusCode()));
-                break;
-            }
+
+    std::vector<std::string> paths = in.files;
+    if (!in.sourcePath.empty()) {
+        std::vector<std::string> found = ns::listFiles(in.sourcePath);
+        paths.insert(paths.end(), found.begin(), found.end());
+    }
+
+    if (paths.empty()) {
+        SetErrorJson("No files to send, set sourcePath or files");
+        return;
+    }
+
+    if (in.maxOperations < 1) {
+        in.maxOperations = 1;
+    }
+
+    // Read the sop class and transfer syntax of every file up front so that
+    // all the presentation contexts can be negotiated in one association
+    std::vector<sFileInfo> files;
+    json failed = json::array();
+    for (const std::string& path : paths) {
+        sFileInfo info;
+        if (scanFile(path, info)) {
+            files.push_back(info);
         }
+        else {
+            failed.push_back(path);
+            SendInfo("skipping, not a dicom file: " + path, progress);
+        }
+    }
+
+    if (files.empty()) {
+        SetErrorJson("No dicom files found");
+        return;
+    }
+
+    size_t contextsCount(0);
+    imebra::PresentationContexts presentationContexts = buildPresentationContexts(files, contextsCount);
+    if (contextsCount > 128) {
+        SetErrorJson("Too many presentation contexts required (" + std::to_string(contextsCount) + ", max is 128)");
+        return;
     }
-    catch (const StreamEOFError & error)
+
+    // Split the files over the requested number of associations, each one
+    // running on its own thread and taking the next file when it has room
+    size_t associations = (size_t)std::max(in.associations, 1);
+    if (associations > files.size()) {
+        associations = files.size();
+    }
+
+    StoreJob job(files, failed, progress);
     {
-        // The association has been closed
-        SetErrorJson("stream error: " + std::string(error.what()));
+        ns::ThreadPool pool(associations);
+        for (size_t i = 0; i < associations; ++i) {
+            pool.push([&job, &in, &presentationContexts]() {
+                StoreProc(job, in, presentationContexts);
+            });
+        }
+        pool.stop();
+    }
+    job.abandon();
+
+    if (job.connectedCount() == 0) {
+        SetErrorJson(job.lastError());
+        return;
     }
 
+    _jsonOutput = {
+        {"completed", job.completed()},
+        {"failed", failed}
+    };
 }
@@ -0,0 +1,87 @@
+#include "SubOperationProgress.h"
+
+#include <algorithm>
+
+#include "Utils.h"
+
+using json = nlohmann::json;
+
+namespace ns {
+
+    namespace {
+        // the counters are optional in the final response
+        std::uint32_t counter(std::uint32_t (imebra::CPartialResponse::*getter)() const, const imebra::CPartialResponse& response, std::uint32_t defaultValue) {
+            try {
+                return (response.*getter)();
+            }
+            catch (const std::exception&) {
+                return defaultValue;
+            }
+        }
+    }
+
+    SubOperationProgress::SubOperationProgress(const AsyncProgressQueueWorker<char>::ExecutionProgress& progress, int intervalMs)
+        : _progress(progress)
+        , _interval(std::max(intervalMs, 0))
+        , _start(std::chrono::steady_clock::now())
+        , _lastSent(_start)
+        , _pending(false)
+        , _remaining(0)
+        , _completed(0)
+        , _failed(0)
+        , _warning(0)
+        , _bytes(0)
+    {
+    }
+
+    void SubOperationProgress::update(const imebra::CPartialResponse& response, std::uint64_t bytes)
+    {
+        _remaining = counter(&imebra::CPartialResponse::getRemainingSubOperations, response, 0);
+        _completed = counter(&imebra::CPartialResponse::getCompletedSubOperations, response, _completed);
+        _failed = counter(&imebra::CPartialResponse::getFailedSubOperations, response, _failed);
+        _warning = counter(&imebra::CPartialResponse::getWarningSubOperations, response, _warning);
+        _bytes = bytes;
+        _pending = true;
+
+        if (std::chrono::steady_clock::now() - _lastSent >= _interval) {
+            send();
+        }
+    }
+
+    void SubOperationProgress::flush()
+    {
+        if (_pending) {
+            send();
+        }
+    }
+
+    json SubOperationProgress::counters() const
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _start).count();
+        const std::uint32_t done = _completed + _failed + _warning;
+        const double instancesPerSecond = seconds > 0 ? static_cast<double>(done) / seconds : 0;
+        json j = {
+            {"remaining", _remaining},
+            {"completed", _completed},
+            {"failed", _failed},
+            {"warning", _warning},
+            {"elapsedMs", (std::uint64_t)(seconds * 1000)},
+            {"instancesPerSecond", instancesPerSecond},
+            {"bytesPerSecond", seconds > 0 ? static_cast<double>(_bytes) / seconds : 0},
+            {"bytes", _bytes}
+        };
+        if (instancesPerSecond > 0) {
+            j["etaMs"] = (std::uint64_t)(_remaining / instancesPerSecond * 1000);
+        }
+        return j;
+    }
+
+    void SubOperationProgress::send()
+    {
+        std::string msg = createJsonResponse(PENDING, "sub-operations", counters());
+        _progress.Send(msg.c_str(), msg.length());
+        _lastSent = std::chrono::steady_clock::now();
+        _pending = false;
+    }
+
+} // namespace ns
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <napi.h>
+#include <chrono>
+#include <cstdint>
+
+#include "../library/include/imebra/dimse.h"
+
+#include "json.h"
+
+using namespace Napi;
+
+namespace ns {
+
+    // Turns the sub-operation counters of the pending c-get and c-move
+    // responses into progress messages with the transfer rates.
+    // At most one message is sent every interval milliseconds so that a
+    // fast peer cannot flood the event loop.
+    class SubOperationProgress {
+    public:
+        SubOperationProgress(const AsyncProgressQueueWorker<char>::ExecutionProgress& progress, int intervalMs);
+
+        // reads the counters from the response, bytes is the amount of data
+        // received so far (0 when unknown, e.g. for c-move)
+        void update(const imebra::CPartialResponse& response, std::uint64_t bytes);
+
+        // sends the last counters even if the interval has not elapsed
+        void flush();
+
+        // the last counters and rates
+        nlohmann::json counters() const;
+
+    private:
+        void send();
+
+        const AsyncProgressQueueWorker<char>::ExecutionProgress& _progress;
+        const std::chrono::milliseconds _interval;
+        const std::chrono::steady_clock::time_point _start;
+        std::chrono::steady_clock::time_point _lastSent;
+        bool _pending;
+        std::uint32_t _remaining;
+        std::uint32_t _completed;
+        std::uint32_t _failed;
+        std::uint32_t _warning;
+        std::uint64_t _bytes;
+    };
+
+} // namespace ns
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ns {
+
+    // A fixed size pool of worker threads.
+    // The number of tasks in flight (queued + running) is bounded by
+    // numThreads + maxQueued: push() blocks until there is room, which
+    // gives the callers natural backpressure.
+    class ThreadPool {
+    public:
+        ThreadPool(size_t numThreads, size_t maxQueued = 0)
+            : _capacity((numThreads == 0 ? 1 : numThreads) + maxQueued)
+            , _running(0)
+            , _stopped(false)
+        {
+            if (numThreads == 0) {
+                numThreads = 1;
+            }
+            for (size_t i = 0; i < numThreads; ++i) {
+                _workers.emplace_back(&ThreadPool::workerProc, this);
+            }
+        }
+
+        ~ThreadPool() {
+            stop();
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // queue a task, blocks while the pool is saturated.
+        // returns false if the pool has been stopped
+        bool push(std::function<void()> task) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this] { return _stopped || _tasks.size() + _running < _capacity; });
+            if (_stopped) {
+                return false;
+            }
+            _tasks.push(std::move(task));
+            _notEmpty.notify_one();
+            return true;
+        }
+
+        // same as push() but never blocks, returns false if the pool is saturated
+        bool tryPush(std::function<void()> task) {
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stopped || _tasks.size() + _running >= _capacity) {
+                return false;
+            }
+            _tasks.push(std::move(task));
+            _notEmpty.notify_one();
+            return true;
+        }
+
+        // blocks until all queued tasks have been executed
+        void wait() {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _idle.wait(lock, [this] { return _tasks.empty() && _running == 0; });
+        }
+
+        // executes the queued tasks and joins the workers
+        void stop() {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                if (_stopped && _workers.empty()) {
+                    return;
+                }
+                _stopped = true;
+            }
+            _notEmpty.notify_all();
+            _notFull.notify_all();
+            for (std::thread& worker : _workers) {
+                if (worker.joinable()) {
+                    worker.join();
+                }
+            }
+            _workers.clear();
+        }
+
+        size_t queued() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _tasks.size();
+        }
+
+        size_t running() const {
+            std::unique_lock<std::mutex> lock(_mutex);
+            return _running;
+        }
+
+    private:
+        void workerProc() {
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _notEmpty.wait(lock, [this] { return _stopped || !_tasks.empty(); });
+                    if (_tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(_tasks.front());
+                    _tasks.pop();
+                    ++_running;
+                }
+                try {
+                    task();
+                }
+                catch (...) {
+                    // tasks are expected to report their own errors
+                }
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    --_running;
+                    if (_tasks.empty() && _running == 0) {
+                        _idle.notify_all();
+                    }
+                }
+                _notFull.notify_one();
+            }
+        }
+
+        const size_t _capacity;
+        size_t _running;
+        bool _stopped;
+        std::queue<std::function<void()> > _tasks;
+        std::vector<std::thread> _workers;
+        mutable std::mutex _mutex;
+        std::condition_variable _notEmpty;
+        std::condition_variable _notFull;
+        std::condition_variable _idle;
+    };
+
+} // namespace ns
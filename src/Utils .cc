@@ -1,5 +1,13 @@
 #include "Utils.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <set>
+#endif
+
 using json = nlohmann::json;
 
 namespace ns {
@@ -235,6 +243,78 @@ namespace ns {
     };
     }
 
+#ifndef _WIN32
+    namespace {
+        // A directory reached again through a symbolic link is skipped, so
+        // a link to a parent directory doesn't list the same files forever
+        void addFiles(const std::string& path, std::vector<std::string>& files, std::set<std::pair<dev_t, ino_t>>& visited)
+        {
+            struct stat info;
+            if (stat(path.c_str(), &info) != 0) {
+                return;
+            }
+            if (!S_ISDIR(info.st_mode)) {
+                if (S_ISREG(info.st_mode)) {
+                    files.push_back(path);
+                }
+                return;
+            }
+            if (!visited.insert(std::make_pair(info.st_dev, info.st_ino)).second) {
+                return;
+            }
+            DIR* dir = opendir(path.c_str());
+            if (dir == nullptr) {
+                return;
+            }
+            while (struct dirent* entry = readdir(dir)) {
+                std::string name(entry->d_name);
+                if (name == "." || name == "..") {
+                    continue;
+                }
+                addFiles(path + "/" + name, files, visited);
+            }
+            closedir(dir);
+        }
+    }
+#endif
+
+    std::vector<std::string> listFiles(const std::string& path)
+    {
+        std::vector<std::string> files;
+#ifdef _WIN32
+        DWORD attributes = GetFileAttributesA(path.c_str());
+        if (attributes == INVALID_FILE_ATTRIBUTES) {
+            return files;
+        }
+        if ((attributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+            files.push_back(path);
+            return files;
+        }
+        WIN32_FIND_DATAA findData;
+        HANDLE hFind = FindFirstFileA((path + "\\*").c_str(), &findData);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            return files;
+        }
+        do {
+            std::string name(findData.cFileName);
+            if (name == "." || name == "..") {
+                continue;
+            }
+            // junctions and directory links may point to a parent
+            if ((findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 && (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0) {
+                continue;
+            }
+            std::vector<std::string> sub = listFiles(path + "/" + name);
+            files.insert(files.end(), sub.begin(), sub.end());
+        } while (FindNextFileA(hFind, &findData));
+        FindClose(hFind);
+#else
+        std::set<std::pair<dev_t, ino_t>> visited;
+        addFiles(path, files, visited);
+#endif
+        return files;
+    }
+
     std::string createJsonResponse(eStatus status, const std::string& message, const json& j) 
     {
         std::string meaning = "success";
@@ -28,7 +28,32 @@ namespace ns {
         sIdent target;
         std::string storagePath;
         std::string destination;
+        std::string sourcePath;
+        std::vector<std::string> files;
         std::vector<sTag> tags;
+        int maxAssociations;
+        int writerThreads;
+        int writerQueueSize;
+        bool ackOnQueue;
+        bool passThrough;
+        int maxOperations;
+        int associations;
+        bool stream;
+        int batchSize;
+        bool binary;
+        bool keepAlive;
+        int idleTimeout;
+        int progressInterval;
+        int maxPduLength;
+        int sendBufferSize;
+        int receiveBufferSize;
+        bool noDelay;
+        int streamBufferSize;
+        int reactorThreads;
+        bool queryRetrieve;
+        bool rebuildIndex;
+        int indexThreads;
+        std::vector<sIdent> peers;
         inline bool valid() {
             return source.valid() && target.valid();
         }
@@ -44,6 +69,30 @@ namespace ns {
         return "";
     }
 
+    inline int toInt(const json& in, const std::string& key, int defaultValue) {
+        try {
+            const json& value = in.at(key);
+            if (value.is_string()) {
+                return std::stoi(value.get<std::string>());
+            }
+            return value.get<int>();
+        }
+        catch(...) {
+
+        }
+        return defaultValue;
+    }
+
+    inline bool toBool(const json& in, const std::string& key, bool defaultValue) {
+        try {
+            return in.at(key).get<bool>();
+        }
+        catch(...) {
+
+        }
+        return defaultValue;
+    }
+
     inline void to_json(json& j, const sTag& p) {
         j = json{{"key", p.key}, {"value", p.value}};
     }
@@ -75,6 +124,41 @@ namespace ns {
         } catch(...) {}
         in.destination = toString(j, "destination");
         in.storagePath = toString(j, "storagePath");
+        in.maxAssociations = toInt(j, "maxAssociations", 10);
+        in.writerThreads = toInt(j, "writerThreads", 0);
+        in.writerQueueSize = toInt(j, "writerQueueSize", 64);
+        in.ackOnQueue = toBool(j, "ackOnQueue", false);
+        in.passThrough = toBool(j, "passThrough", false);
+        in.maxOperations = toInt(j, "maxOperations", 8);
+        in.associations = toInt(j, "associations", 1);
+        in.stream = toBool(j, "stream", false);
+        in.batchSize = toInt(j, "batchSize", 1);
+        in.binary = toBool(j, "binary", false);
+        in.keepAlive = toBool(j, "keepAlive", false);
+        in.idleTimeout = toInt(j, "idleTimeout", 60000);
+        in.progressInterval = toInt(j, "progressInterval", 500);
+        in.maxPduLength = toInt(j, "maxPduLength", 0);
+        in.sendBufferSize = toInt(j, "sendBufferSize", 0);
+        in.receiveBufferSize = toInt(j, "receiveBufferSize", 0);
+        in.noDelay = toBool(j, "noDelay", false);
+        in.streamBufferSize = toInt(j, "streamBufferSize", 0);
+        in.reactorThreads = toInt(j, "reactorThreads", 0);
+        in.queryRetrieve = toBool(j, "queryRetrieve", false);
+        in.rebuildIndex = toBool(j, "rebuildIndex", false);
+        in.indexThreads = toInt(j, "indexThreads", 0);
+        in.sourcePath = toString(j, "sourcePath");
+        try {
+            auto files = j.at("files");
+            for (json::iterator it = files.begin(); it != files.end(); ++it) {
+                in.files.push_back((*it).get<std::string>());
+            }
+        } catch(...) {}
+        try {
+            auto peers = j.at("peers");
+            for (json::iterator it = peers.begin(); it != peers.end(); ++it) {
+                in.peers.push_back((*it).get<sIdent>());
+            }
+        } catch(...) {}
         try {
             auto tags = j.at("tags");
             for (json::iterator it = tags.begin(); it != tags.end(); ++it) {
@@ -89,6 +173,11 @@ namespace ns {
 
     std::vector<std::string> dcmLongSCUStorageSOPClassUIDs();
 
+    // returns the path itself if it is a file, or all the files found
+    // recursively if it is a directory. Symbolic links are followed, each
+    // directory is listed once
+    std::vector<std::string> listFiles(const std::string& path);
+
     enum eStatus {
         SUCCESS = 0,
         PENDING = 1,